@@ -0,0 +1,368 @@
+/*
+ * Archivo: afinidad.h
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Descubrimiento de la topología de la máquina y colocación de hilos o procesos, compartido por
+ * openmp_riemann_suma.c y mpi_riemann_suma.c. La topología se lee de /sys/devices/system/cpu
+ * (CPUs en línea, núcleo y paquete de cada CPU lógica) y de /sys/devices/system/node (CPUs de
+ * cada dominio NUMA); si esos archivos no existen se supone una CPU lógica por núcleo y un solo
+ * nodo. Las políticas de colocación son:
+ * - compacta: llena núcleo por núcleo (incluidos sus hermanos SMT) y nodo por nodo.
+ * - dispersa: reparte los hilos entre nodos y luego entre núcleos; los hermanos SMT se usan
+ *   solo cuando todos los núcleos tienen ya un hilo.
+ * - fisicos: un hilo por núcleo físico, en orden compacto, sin hermanos SMT.
+ * - numa: bloques contiguos de hilos por nodo, cada hilo fijado a todas las CPUs de su nodo
+ *   (el planificador los mueve dentro del nodo, pero la memoria queda local).
+ * Con más hilos que CPUs de la política, la asignación da la vuelta.
+ *
+ * Requiere _GNU_SOURCE definido antes de cualquier #include (cpu_set_t y sched_setaffinity).
+ */
+
+#ifndef AFINIDAD_H
+#define AFINIDAD_H
+
+#include <dirent.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_CPUS_AFINIDAD 1024
+
+typedef enum { AFINIDAD_NINGUNA, AFINIDAD_COMPACTA, AFINIDAD_DISPERSA, AFINIDAD_FISICOS, AFINIDAD_NUMA } PoliticaAfinidad;
+
+/* CPU lógica: núcleo físico (índice global), paquete, nodo NUMA y posición entre sus hermanos SMT */
+typedef struct {
+    int cpu;
+    int nucleo;
+    int paquete;
+    int nodo;
+    int hermano;
+    int indice_en_nodo;  // Posición de su núcleo entre los núcleos del nodo
+} CpuLogica;
+
+typedef struct {
+    int num_cpus;
+    int num_nucleos;
+    int num_paquetes;
+    int num_nodos;
+    CpuLogica cpus[MAX_CPUS_AFINIDAD];
+    int orden_compacto[MAX_CPUS_AFINIDAD];   // Índices en cpus[] según cada política
+    int orden_disperso[MAX_CPUS_AFINIDAD];
+    int orden_fisico[MAX_CPUS_AFINIDAD];     // num_nucleos elementos
+    int nodos[MAX_CPUS_AFINIDAD];            // Identificadores de nodo presentes, ordenados
+} Topologia;
+
+static inline PoliticaAfinidad afinidad_leer_politica(const char *texto, int *valida) {
+    *valida = 1;
+    if (texto == NULL || texto[0] == '\0' || strcmp(texto, "ninguna") == 0) {
+        return AFINIDAD_NINGUNA;
+    } else if (strcmp(texto, "compacta") == 0) {
+        return AFINIDAD_COMPACTA;
+    } else if (strcmp(texto, "dispersa") == 0) {
+        return AFINIDAD_DISPERSA;
+    } else if (strcmp(texto, "fisicos") == 0) {
+        return AFINIDAD_FISICOS;
+    } else if (strcmp(texto, "numa") == 0) {
+        return AFINIDAD_NUMA;
+    }
+    *valida = 0;
+    return AFINIDAD_NINGUNA;
+}
+
+static inline const char *afinidad_nombre(PoliticaAfinidad politica) {
+    static const char *nombres[] = {"ninguna", "compacta", "dispersa", "fisicos", "numa"};
+    return nombres[politica];
+}
+
+/* Lee una lista de CPUs del kernel ("0-3,8,10-11") y marca sus elementos; devuelve 0 si falla */
+static inline int leer_lista_cpus(const char *ruta, unsigned char *marcas) {
+    FILE *archivo = fopen(ruta, "r");
+    if (archivo == NULL) {
+        return 0;
+    }
+    char texto[4096];
+    int leido = fgets(texto, sizeof(texto), archivo) != NULL;
+    fclose(archivo);
+    if (!leido) {
+        return 0;
+    }
+
+    char *p = texto;
+    while (*p != '\0' && *p != '\n') {
+        char *fin;
+        long primero = strtol(p, &fin, 10);
+        long ultimo = primero;
+        if (fin == p) {
+            return 0;
+        }
+        if (*fin == '-') {
+            p = fin + 1;
+            ultimo = strtol(p, &fin, 10);
+        }
+        for (long c = primero; c <= ultimo && c < MAX_CPUS_AFINIDAD; c++) {
+            if (c >= 0) {
+                marcas[c] = 1;
+            }
+        }
+        p = (*fin == ',') ? fin + 1 : fin;
+    }
+    return 1;
+}
+
+static inline int leer_entero_archivo(const char *ruta, int por_defecto) {
+    FILE *archivo = fopen(ruta, "r");
+    int valor;
+    if (archivo == NULL) {
+        return por_defecto;
+    }
+    if (fscanf(archivo, "%d", &valor) != 1) {
+        valor = por_defecto;
+    }
+    fclose(archivo);
+    return valor;
+}
+
+/* Claves de ordenación de las políticas compacta y dispersa */
+static inline int clave_compacta(const CpuLogica *c, int k) {
+    const int claves[4] = {c->nodo, c->paquete, c->nucleo, c->hermano};
+    return claves[k];
+}
+
+static inline int clave_dispersa(const CpuLogica *c, int k) {
+    const int claves[4] = {c->hermano, c->indice_en_nodo, c->nodo, c->cpu};
+    return claves[k];
+}
+
+static inline void ordenar_cpus(const Topologia *t, int *orden, int cantidad, int (*clave)(const CpuLogica *, int)) {
+    /* Inserción: la cantidad de CPUs es pequeña y solo se ordena una vez */
+    for (int i = 1; i < cantidad; i++) {
+        int actual = orden[i];
+        int j = i - 1;
+        for (; j >= 0; j--) {
+            int k = 0;
+            while (k < 4 && clave(&t->cpus[orden[j]], k) == clave(&t->cpus[actual], k)) {
+                k++;
+            }
+            if (k == 4 || clave(&t->cpus[orden[j]], k) < clave(&t->cpus[actual], k)) {
+                break;
+            }
+            orden[j + 1] = orden[j];
+        }
+        orden[j + 1] = actual;
+    }
+}
+
+/* Cuenta paquetes y nodos distintos (los nodos se guardan ordenados) y prepara el orden de cada
+ * política a partir de t->cpus */
+static inline void topologia_ordenar(Topologia *t) {
+    t->num_paquetes = 0;
+    t->num_nodos = 0;
+    for (int i = 0; i < t->num_cpus; i++) {
+        int nuevo_paquete = 1, nuevo_nodo = 1;
+        for (int j = 0; j < i; j++) {
+            nuevo_paquete &= t->cpus[j].paquete != t->cpus[i].paquete;
+            nuevo_nodo &= t->cpus[j].nodo != t->cpus[i].nodo;
+        }
+        t->num_paquetes += nuevo_paquete;
+        if (nuevo_nodo) {
+            int k = t->num_nodos++;
+            while (k > 0 && t->nodos[k - 1] > t->cpus[i].nodo) {
+                t->nodos[k] = t->nodos[k - 1];
+                k--;
+            }
+            t->nodos[k] = t->cpus[i].nodo;
+        }
+    }
+
+    /* Orden compacto, núcleos físicos y posición de cada núcleo dentro de su nodo */
+    for (int i = 0; i < t->num_cpus; i++) {
+        t->orden_compacto[i] = i;
+    }
+    ordenar_cpus(t, t->orden_compacto, t->num_cpus, clave_compacta);
+    int fisicos = 0;
+    int nucleos_por_nodo[MAX_CPUS_AFINIDAD] = {0};
+    for (int i = 0; i < t->num_cpus; i++) {
+        CpuLogica *cpu = &t->cpus[t->orden_compacto[i]];
+        if (cpu->hermano == 0) {
+            t->orden_fisico[fisicos++] = t->orden_compacto[i];
+            int d = 0;
+            while (t->nodos[d] != cpu->nodo) {
+                d++;
+            }
+            cpu->indice_en_nodo = nucleos_por_nodo[d]++;
+        }
+    }
+    for (int i = 0; i < t->num_cpus; i++) {
+        CpuLogica *cpu = &t->cpus[i];
+        for (int j = 0; j < t->num_cpus; j++) {
+            if (t->cpus[j].nucleo == cpu->nucleo && t->cpus[j].hermano == 0) {
+                cpu->indice_en_nodo = t->cpus[j].indice_en_nodo;
+            }
+        }
+        t->orden_disperso[i] = i;
+    }
+    ordenar_cpus(t, t->orden_disperso, t->num_cpus, clave_dispersa);
+}
+
+/* Descubre la topología. Con solo_permitidas se limita a las CPUs de la máscara actual del
+ * proceso (lo habitual con hilos); sin ella se consideran todas las CPUs en línea, lo que sirve
+ * a procesos MPI que el lanzador ya fijó a un solo núcleo. */
+static inline void topologia_descubrir(Topologia *t, int solo_permitidas) {
+    unsigned char en_linea[MAX_CPUS_AFINIDAD] = {0};
+    int nodo_de[MAX_CPUS_AFINIDAD];
+    cpu_set_t permitidas;
+    char ruta[256];
+
+    if (!leer_lista_cpus("/sys/devices/system/cpu/online", en_linea)) {
+        long cantidad = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long c = 0; c < cantidad && c < MAX_CPUS_AFINIDAD; c++) {
+            en_linea[c] = 1;
+        }
+    }
+    if (!solo_permitidas || sched_getaffinity(0, sizeof(cpu_set_t), &permitidas) != 0) {
+        CPU_ZERO(&permitidas);
+        for (int c = 0; c < MAX_CPUS_AFINIDAD && c < CPU_SETSIZE; c++) {
+            CPU_SET(c, &permitidas);
+        }
+    }
+
+    /* Nodos NUMA: un directorio nodeN por dominio */
+    for (int c = 0; c < MAX_CPUS_AFINIDAD; c++) {
+        nodo_de[c] = 0;
+    }
+    DIR *directorio = opendir("/sys/devices/system/node");
+    if (directorio != NULL) {
+        struct dirent *entrada;
+        while ((entrada = readdir(directorio)) != NULL) {
+            int nodo;
+            unsigned char marcas[MAX_CPUS_AFINIDAD] = {0};
+            if (sscanf(entrada->d_name, "node%d", &nodo) != 1) {
+                continue;
+            }
+            snprintf(ruta, sizeof(ruta), "/sys/devices/system/node/node%d/cpulist", nodo);
+            if (leer_lista_cpus(ruta, marcas)) {
+                for (int c = 0; c < MAX_CPUS_AFINIDAD; c++) {
+                    if (marcas[c]) {
+                        nodo_de[c] = nodo;
+                    }
+                }
+            }
+        }
+        closedir(directorio);
+    }
+
+    /* CPUs lógicas con su núcleo (identificado por el par paquete, core_id) */
+    int paquete_nucleo[MAX_CPUS_AFINIDAD][2];
+    t->num_cpus = 0;
+    t->num_nucleos = 0;
+    for (int c = 0; c < MAX_CPUS_AFINIDAD; c++) {
+        if (!en_linea[c] || !CPU_ISSET(c, &permitidas)) {
+            continue;
+        }
+        CpuLogica *cpu = &t->cpus[t->num_cpus++];
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", c);
+        int paquete = leer_entero_archivo(ruta, 0);
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu%d/topology/core_id", c);
+        int core_id = leer_entero_archivo(ruta, c);
+
+        cpu->cpu = c;
+        cpu->paquete = paquete;
+        cpu->nodo = nodo_de[c];
+        cpu->hermano = 0;
+        cpu->nucleo = -1;
+        for (int k = 0; k < t->num_nucleos; k++) {
+            if (paquete_nucleo[k][0] == paquete && paquete_nucleo[k][1] == core_id) {
+                cpu->nucleo = k;
+            }
+        }
+        if (cpu->nucleo < 0) {
+            cpu->nucleo = t->num_nucleos;
+            paquete_nucleo[t->num_nucleos][0] = paquete;
+            paquete_nucleo[t->num_nucleos][1] = core_id;
+            t->num_nucleos++;
+        }
+        for (int k = 0; k < t->num_cpus - 1; k++) {
+            if (t->cpus[k].nucleo == cpu->nucleo) {
+                cpu->hermano++;
+            }
+        }
+    }
+
+    topologia_ordenar(t);
+}
+
+/* Conjunto de CPUs del hilo (o proceso local) 'hilo' de 'hilos' según la política */
+static inline void afinidad_conjunto(const Topologia *t, PoliticaAfinidad politica, int hilo, int hilos,
+                                     cpu_set_t *conjunto) {
+    CPU_ZERO(conjunto);
+    if (t->num_cpus == 0) {
+        return;
+    }
+    switch (politica) {
+    case AFINIDAD_COMPACTA:
+        CPU_SET(t->cpus[t->orden_compacto[hilo % t->num_cpus]].cpu, conjunto);
+        break;
+    case AFINIDAD_DISPERSA:
+        CPU_SET(t->cpus[t->orden_disperso[hilo % t->num_cpus]].cpu, conjunto);
+        break;
+    case AFINIDAD_FISICOS:
+        CPU_SET(t->cpus[t->orden_fisico[hilo % t->num_nucleos]].cpu, conjunto);
+        break;
+    case AFINIDAD_NUMA: {
+        int nodo = t->nodos[(int)((long)hilo * t->num_nodos / hilos)];
+        for (int i = 0; i < t->num_cpus; i++) {
+            if (t->cpus[i].nodo == nodo) {
+                CPU_SET(t->cpus[i].cpu, conjunto);
+            }
+        }
+        break;
+    }
+    case AFINIDAD_NINGUNA:
+        for (int i = 0; i < t->num_cpus; i++) {
+            CPU_SET(t->cpus[i].cpu, conjunto);
+        }
+        break;
+    }
+}
+
+/* Fija el hilo que llama al conjunto dado; devuelve 0 si el sistema lo rechaza */
+static inline int afinidad_fijar_hilo(const cpu_set_t *conjunto) {
+    return sched_setaffinity(0, sizeof(cpu_set_t), conjunto) == 0;
+}
+
+/* Describe un conjunto: "CPU 3 (núcleo 1, paquete 0, nodo 0)" o "CPUs 0-7 (nodo 0)" */
+static inline void afinidad_describir(const Topologia *t, const cpu_set_t *conjunto, char *texto, size_t tamano) {
+    int cantidad = CPU_COUNT(conjunto);
+    for (int i = 0; i < t->num_cpus; i++) {
+        const CpuLogica *cpu = &t->cpus[i];
+        if (!CPU_ISSET(cpu->cpu, conjunto)) {
+            continue;
+        }
+        if (cantidad == 1) {
+            snprintf(texto, tamano, "CPU %d (núcleo %d, paquete %d, nodo %d)", cpu->cpu, cpu->nucleo, cpu->paquete,
+                     cpu->nodo);
+            return;
+        }
+        /* Conjunto de varias CPUs: primera, última y nodo de la primera */
+        int ultima = cpu->cpu;
+        for (int j = i; j < t->num_cpus; j++) {
+            if (CPU_ISSET(t->cpus[j].cpu, conjunto)) {
+                ultima = t->cpus[j].cpu;
+            }
+        }
+        snprintf(texto, tamano, "%d CPUs entre %d y %d (nodo %d)", cantidad, cpu->cpu, ultima, cpu->nodo);
+        return;
+    }
+    snprintf(texto, tamano, "sin CPUs");
+}
+
+static inline void topologia_imprimir(const Topologia *t) {
+    printf("Topología: %d CPUs lógicas, %d núcleos físicos, %d paquetes, %d nodos NUMA.\n",
+           t->num_cpus, t->num_nucleos, t->num_paquetes, t->num_nodos);
+}
+
+#endif
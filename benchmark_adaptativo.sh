@@ -0,0 +1,101 @@
+#!/bin/bash
+
+# Script: benchmark_adaptativo.sh
+# Autor: Samuel Chamalé
+# Fecha: 2024-10-23
+#
+# Descripción:
+# Este script mide el modo adaptativo de openmp_riemann_suma (bisección con tareas de OpenMP)
+# sobre integrandos con rasgos locales agudos: un pico estrecho, un escalón y una raíz con
+# derivada singular, además de sin(x) como referencia suave. Para cada integrando y número de
+# hilos muestra el tiempo, el speedup respecto de la primera cantidad de hilos de la lista, el
+# número de subintervalos aceptados y la profundidad máxima alcanzada.
+#
+# Uso:
+#     ./benchmark_adaptativo.sh <a> <b> <n> <tolerancia> "<hilos_OpenMP>" [repeticiones]
+#     Donde:
+#         <a> : Límite inferior de integración (double)
+#         <b> : Límite superior de integración (double)
+#         <n> : Subintervalos iniciales (entero positivo)
+#         <tolerancia> : Error absoluto objetivo (double positivo)
+#         <hilos_OpenMP> : Lista de números de hilos separados por espacio (ej. "1 2 4 8")
+#         [repeticiones] : Ejecuciones por configuración; se toma el menor tiempo (por defecto 3)
+#     Ejemplo:
+#         ./benchmark_adaptativo.sh 0 10 100000 1e-13 "1 2 4 8"
+
+# Verificar que se proporcionen al menos 5 argumentos
+if [ "$#" -lt 5 ]; then
+    echo "Uso: $0 <a> <b> <n> <tolerancia> \"<hilos_OpenMP>\" [repeticiones]"
+    echo "Ejemplo: $0 0 10 100000 1e-13 \"1 2 4 8\""
+    exit 1
+fi
+
+A=$1
+B=$2
+N=$3
+TOLERANCIA=$4
+HILOS_OPENMP=($5)
+REPETICIONES=${6:-3}
+INTEGRANDOS=(seno pico escalon raiz)
+
+PROG_OPENMP_NAME="openmp_riemann_suma"
+SRC_OPENMP="openmp_riemann_suma.c"
+
+if [ ! -f "$SRC_OPENMP" ]; then
+    echo "Error: Archivo fuente $SRC_OPENMP no encontrado."
+    exit 1
+fi
+
+# Compilar la versión paralela con OpenMP
+echo "Compilando la versión paralela con OpenMP..."
+gcc -fopenmp -O2 -o "$PROG_OPENMP_NAME" "$SRC_OPENMP" -lm
+if [ $? -ne 0 ]; then
+    echo "Error: Falló la compilación de $PROG_OPENMP_NAME."
+    exit 1
+fi
+echo "Compilación de $PROG_OPENMP_NAME exitosa."
+echo "-------------------------------------------"
+
+for INTEGRANDO in "${INTEGRANDOS[@]}"; do
+    echo "Integrando: $INTEGRANDO"
+    echo "--------------------------------------------------------------------------------------------------"
+    printf "| %-8s | %-20s | %-12s | %-10s | %-14s | %-12s |\n" "Hilos" "Integral Aproximada" "Tiempo (s)" "Speedup" "Subintervalos" "Profundidad"
+    echo "--------------------------------------------------------------------------------------------------"
+    TIEMPO_BASE=""
+    for HILOS in "${HILOS_OPENMP[@]}"; do
+        MEJOR=""
+        for ((r = 0; r < REPETICIONES; r++)); do
+            OUTPUT=$(./"$PROG_OPENMP_NAME" "$A" "$B" "$N" "$HILOS" adaptativo "$TOLERANCIA" "$INTEGRANDO")
+            if [ $? -ne 0 ]; then
+                echo "Error: Falló la ejecución con $HILOS hilos ($INTEGRANDO)."
+                exit 1
+            fi
+            TIEMPO=$(echo "$OUTPUT" | grep "Tiempo de ejecución" | awk '{print $4}')
+            if [ -z "$MEJOR" ] || [ "$(echo "$TIEMPO < $MEJOR" | bc -l)" -eq 1 ]; then
+                MEJOR=$TIEMPO
+                RESULTADO=$(echo "$OUTPUT" | grep "Resultado de la integral aproximada" | awk '{print $6}')
+                SUBINTERVALOS=$(echo "$OUTPUT" | grep "Error estimado" | sed 's/.*(\([0-9]*\) subintervalos.*/\1/')
+                PROFUNDIDAD=$(echo "$OUTPUT" | grep "Error estimado" | sed 's/.*profundidad máxima \([0-9]*\).*/\1/')
+            fi
+        done
+
+        MEJOR=$(printf "%.6f" "$MEJOR")
+        if [ -z "$TIEMPO_BASE" ]; then
+            TIEMPO_BASE=$MEJOR
+        fi
+        SPEEDUP=$(printf "%.6f" "$(echo "scale=6; $TIEMPO_BASE / $MEJOR" | bc -l)")
+        printf "| %-8s | %-20s | %-12s | %-10s | %-14s | %-12s |\n" "$HILOS" "$RESULTADO" "$MEJOR" "$SPEEDUP" "$SUBINTERVALOS" "$PROFUNDIDAD"
+    done
+    echo "--------------------------------------------------------------------------------------------------"
+    echo ""
+done
+
+echo "Parámetros de entrada:"
+echo "Límite Inferior: $A"
+echo "Límite Superior: $B"
+echo "Subintervalos Iniciales: $N"
+echo "Tolerancia: $TOLERANCIA"
+echo "Número de Hilos (OpenMP): ${HILOS_OPENMP[@]}"
+echo "-------------------------------------------------------------"
+
+exit 0
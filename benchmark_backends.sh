@@ -0,0 +1,98 @@
+#!/bin/bash
+
+# Script: benchmark_backends.sh
+# Autor: Samuel Chamalé
+# Fecha: 2024-10-23
+#
+# Descripción:
+# Este script compara frente a frente los dos backends de la suma de Riemann de
+# openmp_riemann_suma: el pragma de OpenMP (modo por defecto) y el pool de hilos propio con
+# robo de trabajo (modo pool, pool_hilos.h). Para cada tamaño de problema y número de hilos
+# muestra el menor tiempo de cada backend, el cociente OpenMP / pool (mayor que 1 indica que el
+# pool es más rápido) y el tiempo de creación del pool, que no se incluye en su tiempo de cálculo.
+# Los tamaños pequeños miden sobre todo el costo de lanzar y sincronizar una región paralela.
+#
+# Uso:
+#     ./benchmark_backends.sh <a> <b> "<n>" "<hilos>" [repeticiones]
+#     Donde:
+#         <a> : Límite inferior de integración (double)
+#         <b> : Límite superior de integración (double)
+#         <n> : Lista de números de subintervalos separados por espacio (ej. "10000 100000000")
+#         <hilos> : Lista de números de hilos separados por espacio (ej. "1 2 4 8")
+#         [repeticiones] : Ejecuciones por configuración; se toma el menor tiempo (por defecto 3)
+#     Ejemplo:
+#         ./benchmark_backends.sh 0 3.141592653589793 "10000 1000000 100000000" "1 2 4 8"
+
+# Verificar que se proporcionen al menos 4 argumentos
+if [ "$#" -lt 4 ]; then
+    echo "Uso: $0 <a> <b> \"<n>\" \"<hilos>\" [repeticiones]"
+    echo "Ejemplo: $0 0 3.141592653589793 \"10000 1000000 100000000\" \"1 2 4 8\""
+    exit 1
+fi
+
+A=$1
+B=$2
+TAMANOS=($3)
+HILOS_LISTA=($4)
+REPETICIONES=${5:-3}
+
+PROG_OPENMP_NAME="openmp_riemann_suma"
+SRC_OPENMP="openmp_riemann_suma.c"
+
+if [ ! -f "$SRC_OPENMP" ]; then
+    echo "Error: Archivo fuente $SRC_OPENMP no encontrado."
+    exit 1
+fi
+
+# Compilar con soporte para OpenMP y pthreads
+echo "Compilando la versión paralela con OpenMP y el pool de hilos..."
+gcc -fopenmp -pthread -O2 -o "$PROG_OPENMP_NAME" "$SRC_OPENMP" -lm
+if [ $? -ne 0 ]; then
+    echo "Error: Falló la compilación de $PROG_OPENMP_NAME."
+    exit 1
+fi
+echo "Compilación de $PROG_OPENMP_NAME exitosa."
+echo "-------------------------------------------"
+
+# Ejecuta el programa REPETICIONES veces y deja en MEJOR el menor tiempo de ejecución
+medir() {
+    MEJOR=""
+    for ((r = 0; r < REPETICIONES; r++)); do
+        OUTPUT=$(./"$PROG_OPENMP_NAME" "$@")
+        if [ $? -ne 0 ]; then
+            echo "Error: Falló la ejecución de $PROG_OPENMP_NAME $*."
+            exit 1
+        fi
+        TIEMPO=$(echo "$OUTPUT" | grep "Tiempo de ejecución" | awk '{print $4}')
+        if [ -z "$MEJOR" ] || [ "$(echo "$TIEMPO < $MEJOR" | bc -l)" -eq 1 ]; then
+            MEJOR=$TIEMPO
+            RESULTADO=$(echo "$OUTPUT" | grep "Resultado de la integral aproximada" | awk '{print $6}')
+            CREACION=$(echo "$OUTPUT" | grep "Creación del pool" | awk '{print $4}')
+        fi
+    done
+}
+
+echo "------------------------------------------------------------------------------------------------------------"
+printf "| %-12s | %-6s | %-20s | %-12s | %-12s | %-10s | %-14s |\n" "n" "Hilos" "Integral (pool)" "OpenMP (s)" "Pool (s)" "OpenMP/Pool" "Creación (s)"
+echo "------------------------------------------------------------------------------------------------------------"
+for N in "${TAMANOS[@]}"; do
+    for HILOS in "${HILOS_LISTA[@]}"; do
+        medir "$A" "$B" "$N" "$HILOS"
+        TIEMPO_OPENMP=$MEJOR
+        medir "$A" "$B" "$N" "$HILOS" pool
+        TIEMPO_POOL=$MEJOR
+
+        COCIENTE=$(printf "%.3f" "$(echo "scale=6; $TIEMPO_OPENMP / $TIEMPO_POOL" | bc -l)")
+        printf "| %-12s | %-6s | %-20s | %-12s | %-12s | %-10s | %-14s |\n" "$N" "$HILOS" "$RESULTADO" "$TIEMPO_OPENMP" "$TIEMPO_POOL" "$COCIENTE" "$CREACION"
+    done
+done
+echo "------------------------------------------------------------------------------------------------------------"
+
+echo "Parámetros de entrada:"
+echo "Límite Inferior: $A"
+echo "Límite Superior: $B"
+echo "Subintervalos: ${TAMANOS[@]}"
+echo "Número de Hilos: ${HILOS_LISTA[@]}"
+echo "-------------------------------------------------------------"
+
+exit 0
@@ -0,0 +1,184 @@
+/*
+ * Archivo: colectivas_persistentes.h
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Difusión y suma persistentes para el modo iterativo de mpi_riemann_suma.c: se preparan una
+ * vez sobre búferes fijos y cada iteración solo las vuelve a arrancar. Con MPI 4 o posterior
+ * se usan MPI_Bcast_init y MPI_Reduce_init. Con versiones anteriores se emulan con solicitudes
+ * persistentes punto a punto (MPI_Send_init/MPI_Recv_init) sobre un árbol binomial con raíz en
+ * el proceso 'raiz': la difusión baja del padre a los hijos y la suma sube de los hijos al
+ * padre, sumando siempre en el mismo orden (la reducción emulada solo admite MPI_SUM de double).
+ *
+ * Las solicitudes quedan atadas a las direcciones de los búferes, así que estos deben seguir
+ * vivos y en el mismo lugar mientras la colectiva exista; cada iteración solo cambia su
+ * contenido.
+ */
+
+#ifndef COLECTIVAS_PERSISTENTES_H
+#define COLECTIVAS_PERSISTENTES_H
+
+#include <mpi.h>
+#include <stdlib.h>
+
+#define ETIQUETA_DIFUSION_PERSISTENTE 7301
+#define ETIQUETA_REDUCCION_PERSISTENTE 7302
+#define MAX_HIJOS_PERSISTENTES 64  // Hijos de un nodo del árbol binomial (log2 del número de procesos)
+
+#if defined(MPI_VERSION) && MPI_VERSION >= 4
+#define COLECTIVAS_PERSISTENTES_NATIVAS 1
+#else
+#define COLECTIVAS_PERSISTENTES_NATIVAS 0
+#endif
+
+typedef struct {
+    MPI_Request recibir;                          // Del padre (MPI_REQUEST_NULL en la raíz)
+    MPI_Request enviar[MAX_HIJOS_PERSISTENTES];   // A cada hijo
+    int hijos;
+} DifusionPersistente;
+
+typedef struct {
+    MPI_Request recibir[MAX_HIJOS_PERSISTENTES];  // De cada hijo, a su búfer propio
+    MPI_Request enviar;                           // Al padre (MPI_REQUEST_NULL en la raíz)
+    int hijos;
+    int cantidad;
+    const double *local;
+    double *resultado;      // Solo en la raíz
+    double *de_hijos;       // hijos · cantidad
+    double *parcial;        // Suma del subárbol que se envía al padre
+} ReduccionPersistente;
+
+/* Padre e hijos de 'rank' en el árbol binomial de 'size' procesos con raíz 'raiz'; devuelve el
+ * número de hijos (de mayor a menor subárbol) y deja el padre en *padre (-1 en la raíz) */
+static inline int arbol_binomial(int rank, int size, int raiz, int *padre, int *hijos) {
+    int relativo = (rank - raiz + size) % size;
+    int mascara = 1;
+    *padre = -1;
+    while (mascara < size) {
+        if (relativo & mascara) {
+            *padre = ((relativo ^ mascara) + raiz) % size;
+            break;
+        }
+        mascara <<= 1;
+    }
+    int cantidad = 0;
+    for (mascara >>= 1; mascara > 0; mascara >>= 1) {
+        if (relativo + mascara < size) {
+            hijos[cantidad++] = (relativo + mascara + raiz) % size;
+        }
+    }
+    return cantidad;
+}
+
+static inline void difusion_persistente_iniciar(DifusionPersistente *d, void *bufer, int cantidad, MPI_Datatype tipo,
+                                                int raiz, MPI_Comm comm) {
+#if COLECTIVAS_PERSISTENTES_NATIVAS
+    d->hijos = 0;
+    MPI_Bcast_init(bufer, cantidad, tipo, raiz, comm, MPI_INFO_NULL, &d->recibir);
+#else
+    int rank, size, padre, hijos[MAX_HIJOS_PERSISTENTES];
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    d->hijos = arbol_binomial(rank, size, raiz, &padre, hijos);
+    d->recibir = MPI_REQUEST_NULL;
+    if (padre >= 0) {
+        MPI_Recv_init(bufer, cantidad, tipo, padre, ETIQUETA_DIFUSION_PERSISTENTE, comm, &d->recibir);
+    }
+    for (int h = 0; h < d->hijos; h++) {
+        MPI_Send_init(bufer, cantidad, tipo, hijos[h], ETIQUETA_DIFUSION_PERSISTENTE, comm, &d->enviar[h]);
+    }
+#endif
+}
+
+static inline void difusion_persistente_ejecutar(DifusionPersistente *d) {
+#if COLECTIVAS_PERSISTENTES_NATIVAS
+    MPI_Start(&d->recibir);
+    MPI_Wait(&d->recibir, MPI_STATUS_IGNORE);
+#else
+    if (d->recibir != MPI_REQUEST_NULL) {
+        MPI_Start(&d->recibir);
+        MPI_Wait(&d->recibir, MPI_STATUS_IGNORE);
+    }
+    if (d->hijos > 0) {
+        MPI_Startall(d->hijos, d->enviar);
+        MPI_Waitall(d->hijos, d->enviar, MPI_STATUSES_IGNORE);
+    }
+#endif
+}
+
+static inline void difusion_persistente_liberar(DifusionPersistente *d) {
+    if (d->recibir != MPI_REQUEST_NULL) {
+        MPI_Request_free(&d->recibir);
+    }
+    for (int h = 0; h < d->hijos; h++) {
+        MPI_Request_free(&d->enviar[h]);
+    }
+}
+
+/* Suma persistente de 'cantidad' doubles de 'local' en 'resultado' del proceso raíz */
+static inline void reduccion_persistente_iniciar(ReduccionPersistente *r, const double *local, double *resultado,
+                                                 int cantidad, int raiz, MPI_Comm comm) {
+    r->cantidad = cantidad;
+    r->local = local;
+    r->resultado = resultado;
+    r->de_hijos = NULL;
+    r->parcial = NULL;
+#if COLECTIVAS_PERSISTENTES_NATIVAS
+    r->hijos = 0;
+    MPI_Reduce_init(local, resultado, cantidad, MPI_DOUBLE, MPI_SUM, raiz, comm, MPI_INFO_NULL, &r->enviar);
+#else
+    int rank, size, padre, hijos[MAX_HIJOS_PERSISTENTES];
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    r->hijos = arbol_binomial(rank, size, raiz, &padre, hijos);
+    r->de_hijos = malloc((size_t)(r->hijos > 0 ? r->hijos : 1) * cantidad * sizeof(double));
+    r->parcial = malloc((size_t)cantidad * sizeof(double));
+    for (int h = 0; h < r->hijos; h++) {
+        MPI_Recv_init(r->de_hijos + (size_t)h * cantidad, cantidad, MPI_DOUBLE, hijos[h],
+                      ETIQUETA_REDUCCION_PERSISTENTE, comm, &r->recibir[h]);
+    }
+    r->enviar = MPI_REQUEST_NULL;
+    if (padre >= 0) {
+        MPI_Send_init(r->parcial, cantidad, MPI_DOUBLE, padre, ETIQUETA_REDUCCION_PERSISTENTE, comm, &r->enviar);
+    }
+#endif
+}
+
+static inline void reduccion_persistente_ejecutar(ReduccionPersistente *r) {
+#if COLECTIVAS_PERSISTENTES_NATIVAS
+    MPI_Start(&r->enviar);
+    MPI_Wait(&r->enviar, MPI_STATUS_IGNORE);
+#else
+    if (r->hijos > 0) {
+        MPI_Startall(r->hijos, r->recibir);
+        MPI_Waitall(r->hijos, r->recibir, MPI_STATUSES_IGNORE);
+    }
+    /* Suma del subárbol en orden fijo: local y luego cada hijo */
+    double *destino = (r->enviar == MPI_REQUEST_NULL) ? r->resultado : r->parcial;
+    for (int i = 0; i < r->cantidad; i++) {
+        double suma = r->local[i];
+        for (int h = 0; h < r->hijos; h++) {
+            suma += r->de_hijos[(size_t)h * r->cantidad + i];
+        }
+        destino[i] = suma;
+    }
+    if (r->enviar != MPI_REQUEST_NULL) {
+        MPI_Start(&r->enviar);
+        MPI_Wait(&r->enviar, MPI_STATUS_IGNORE);
+    }
+#endif
+}
+
+static inline void reduccion_persistente_liberar(ReduccionPersistente *r) {
+    for (int h = 0; h < r->hijos; h++) {
+        MPI_Request_free(&r->recibir[h]);
+    }
+    if (r->enviar != MPI_REQUEST_NULL) {
+        MPI_Request_free(&r->enviar);
+    }
+    free(r->de_hijos);
+    free(r->parcial);
+}
+
+#endif
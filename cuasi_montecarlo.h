@@ -0,0 +1,252 @@
+/*
+ * Archivo: cuasi_montecarlo.h
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Generadores de puntos de cuasi-Monte Carlo compartidos por los modos sobol y reticula de
+ * openmp_riemann_suma.c y mpi_riemann_suma.c.
+ *
+ * - Sucesión de Sobol con los números de dirección de Joe y Kuo (new-joe-kuo-6.21201) para las
+ *   primeras DIM_MAX_QMC dimensiones, incluidos en este archivo. El punto i se obtiene en orden
+ *   de código de Gray, de modo que cada hilo o proceso salta directo al inicio de su bloque
+ *   (un XOR por bit del índice) y luego avanza con un XOR por punto.
+ * - Retícula de rango 1 de Korobov, z = (1, α, α², ...) mod N, con α elegido por el criterio
+ *   P_2 entre un conjunto de candidatos. El punto i es {i·z/N}, accesible directamente.
+ *
+ * La aleatorización usa un desplazamiento digital (XOR) para Sobol y un desplazamiento de
+ * Cranley-Patterson (módulo 1) para la retícula; cada réplica toma su desplazamiento de un flujo
+ * de Philox distinto, y el error se estima con la dispersión entre réplicas independientes.
+ */
+
+#ifndef CUASI_MONTECARLO_H
+#define CUASI_MONTECARLO_H
+
+#include <stdint.h>
+#include <math.h>
+#include "montecarlo.h"
+
+#define DIM_MAX_QMC 21
+#define BITS_SOBOL 32
+#define TRABAJO_BUSQUEDA_RETICULA 2e8  // Operaciones aproximadas dedicadas a elegir α
+
+/* Números de dirección de Joe-Kuo para las dimensiones 2..DIM_MAX_QMC: grado s del
+ * polinomio primitivo, sus coeficientes interiores a y los m_k iniciales. */
+static const struct {
+    int s;
+    int a;
+    unsigned m[7];
+} DIRECCIONES_SOBOL[DIM_MAX_QMC - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+    {6, 19, {1, 1, 1, 15, 7, 5}},
+    {6, 22, {1, 3, 1, 15, 13, 25}},
+    {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7, 1, {1, 3, 7, 11, 23, 15, 103}},
+    {7, 4, {1, 3, 7, 13, 13, 15, 69}},
+};
+
+typedef struct {
+    int dim;
+    uint32_t v[DIM_MAX_QMC][BITS_SOBOL];  // v[d][k]: número de dirección del bit k
+} Sobol;
+
+typedef struct {
+    int dim;
+    uint64_t n;
+    uint64_t z[DIM_MAX_QMC];  // Vector generador
+} Reticula;
+
+static inline void sobol_iniciar(Sobol *s, int dim) {
+    s->dim = dim;
+    for (int k = 0; k < BITS_SOBOL; k++) {
+        s->v[0][k] = 1u << (BITS_SOBOL - 1 - k);
+    }
+    for (int d = 1; d < dim; d++) {
+        int grado = DIRECCIONES_SOBOL[d - 1].s;
+        int a = DIRECCIONES_SOBOL[d - 1].a;
+        for (int k = 0; k < BITS_SOBOL; k++) {
+            if (k < grado) {
+                s->v[d][k] = DIRECCIONES_SOBOL[d - 1].m[k] << (BITS_SOBOL - 1 - k);
+            } else {
+                uint32_t v = s->v[d][k - grado] ^ (s->v[d][k - grado] >> grado);
+                for (int j = 1; j < grado; j++) {
+                    if ((a >> (grado - 1 - j)) & 1) {
+                        v ^= s->v[d][k - j];
+                    }
+                }
+                s->v[d][k] = v;
+            }
+        }
+    }
+}
+
+/* Suma de f sobre los puntos de Sobol [inicio, fin) (en orden de Gray), con desplazamiento
+ * digital 'desplazamiento' por dimensión y escalados a [a, b]^dim. */
+static inline double sobol_suma_bloque(const Sobol *s, const uint32_t *desplazamiento, uint64_t inicio,
+                                       uint64_t fin, double (*integrando)(const double *, int),
+                                       double a, double b) {
+    uint32_t x[DIM_MAX_QMC];
+    double punto[DIM_MAX_QMC];
+    uint64_t gray = inicio ^ (inicio >> 1);
+    double suma = 0.0;
+
+    /* Salto directo al punto 'inicio': XOR de las direcciones de los bits de su código de Gray */
+    for (int d = 0; d < s->dim; d++) {
+        x[d] = 0;
+        for (int k = 0; k < BITS_SOBOL; k++) {
+            if ((gray >> k) & 1) {
+                x[d] ^= s->v[d][k];
+            }
+        }
+    }
+
+    for (uint64_t i = inicio; i < fin; i++) {
+        for (int d = 0; d < s->dim; d++) {
+            punto[d] = a + (b - a) * (((double)(x[d] ^ desplazamiento[d]) + 0.5) * 0x1.0p-32);
+        }
+        suma += integrando(punto, s->dim);
+
+        int c = __builtin_ctzll(~i);
+        for (int d = 0; d < s->dim; d++) {
+            x[d] ^= s->v[d][c];
+        }
+    }
+    return suma;
+}
+
+/* Criterio P_2 de la retícula de Korobov con parámetro alfa (menor es mejor) */
+static inline double reticula_criterio_p2(uint64_t n, int dim, uint64_t alfa) {
+    uint64_t z[DIM_MAX_QMC];
+    double suma = 0.0;
+
+    z[0] = 1;
+    for (int d = 1; d < dim; d++) {
+        z[d] = (z[d - 1] * alfa) % n;
+    }
+
+#if defined(_OPENMP)
+    #pragma omp parallel for reduction(+:suma)
+#endif
+    for (uint64_t k = 0; k < n; k++) {
+        double producto = 1.0;
+        for (int d = 0; d < dim; d++) {
+            double x = (double)((k * z[d]) % n) / (double)n;
+            producto *= 1.0 + 2.0 * M_PI * M_PI * (x * x - x + 1.0 / 6.0);
+        }
+        suma += producto;
+    }
+    return suma / n - 1.0;
+}
+
+static inline uint64_t mcd(uint64_t x, uint64_t y) {
+    while (y != 0) {
+        uint64_t t = x % y;
+        x = y;
+        y = t;
+    }
+    return x;
+}
+
+/* Con n pequeño hay pocos α en [2, n/2]: se enumeran todos los coprimos con n (con n < 5, o si
+ * no hay ninguno, solo queda α = 1) */
+#define CANDIDATOS_MAX_RETICULA 64
+
+static inline int reticula_es_pequena(uint64_t n) {
+    return n < 5 || n / 2 - 1 <= CANDIDATOS_MAX_RETICULA;
+}
+
+static inline int reticula_coprimos_pequenos(uint64_t n) {
+    int coprimos = 0;
+    for (uint64_t alfa = 2; n >= 5 && alfa <= n / 2; alfa++) {
+        coprimos += mcd(alfa, n) == 1;
+    }
+    return coprimos;
+}
+
+/* Cantidad de candidatos α que cabe en el presupuesto de búsqueda, sin repetidos */
+static inline int reticula_numero_candidatos(uint64_t n, int dim) {
+    double presupuesto = TRABAJO_BUSQUEDA_RETICULA / ((double)n * dim);
+    int candidatos = presupuesto < 4.0 ? 4
+                                       : (presupuesto > CANDIDATOS_MAX_RETICULA ? CANDIDATOS_MAX_RETICULA
+                                                                               : (int)presupuesto);
+    if (reticula_es_pequena(n)) {
+        int coprimos = reticula_coprimos_pequenos(n);
+        candidatos = coprimos == 0 ? 1 : (candidatos < coprimos ? candidatos : coprimos);
+    }
+    return candidatos;
+}
+
+/* Candidato número c. Con n pequeño, el c-ésimo α coprimo con n en [2, n/2]; si no, repartidos
+ * en [2, n/2] según la sucesión de la razón áurea (un espaciado regular produce α con factores
+ * comunes con n cuando n es potencia de dos) y llevados al siguiente coprimo con n */
+static inline uint64_t reticula_candidato(uint64_t n, int c) {
+    if (reticula_es_pequena(n)) {
+        for (uint64_t alfa = 2; n >= 5 && alfa <= n / 2; alfa++) {
+            if (mcd(alfa, n) == 1 && c-- == 0) {
+                return alfa;
+            }
+        }
+        return 1;
+    }
+    double fraccion = fmod((c + 1) * 0.6180339887498949, 1.0);
+    uint64_t alfa = 2 + (uint64_t)((double)(n / 2 - 2) * fraccion);
+    while (mcd(alfa, n) != 1) {
+        alfa++;
+    }
+    return alfa;
+}
+
+static inline void reticula_iniciar(Reticula *r, uint64_t n, int dim, uint64_t alfa) {
+    r->dim = dim;
+    r->n = n;
+    r->z[0] = 1;
+    for (int d = 1; d < dim; d++) {
+        r->z[d] = (r->z[d - 1] * alfa) % n;
+    }
+}
+
+/* Suma de f sobre los puntos de la retícula [inicio, fin) con desplazamiento módulo 1 */
+static inline double reticula_suma_bloque(const Reticula *r, const double *desplazamiento, uint64_t inicio,
+                                          uint64_t fin, double (*integrando)(const double *, int),
+                                          double a, double b) {
+    double punto[DIM_MAX_QMC];
+    double suma = 0.0;
+
+    for (uint64_t i = inicio; i < fin; i++) {
+        for (int d = 0; d < r->dim; d++) {
+            double u = (double)((i * r->z[d]) % r->n) / (double)r->n + desplazamiento[d];
+            punto[d] = a + (b - a) * (u - floor(u));
+        }
+        suma += integrando(punto, r->dim);
+    }
+    return suma;
+}
+
+/* Desplazamientos aleatorios de la réplica, tomados de un flujo de Philox aparte de los
+ * bloques de Monte Carlo (bit alto del índice de bloque encendido). */
+static inline void desplazamientos_replica(uint64_t semilla, int replica, int dim,
+                                           uint32_t *digital, double *modulo_uno) {
+    double u[DIM_MAX_QMC + 1];
+    int cantidad = dim + (dim & 1);
+    philox_uniformes(semilla, (UINT64_C(1) << 63) | (uint64_t)replica, 0, cantidad, u);
+    for (int d = 0; d < dim; d++) {
+        modulo_uno[d] = u[d];
+        digital[d] = (uint32_t)(u[d] * 0x1.0p32);
+    }
+}
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * Archivo: montecarlo.h
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Utilidades compartidas por el modo Monte Carlo de openmp_riemann_suma.c y mpi_riemann_suma.c.
+ *
+ * Los números aleatorios salen de Philox4x32-10, un generador basado en contador: el valor
+ * número j del bloque b se obtiene cifrando el contador (j, b) con la semilla como clave, sin
+ * estado compartido entre hilos ni procesos. Las muestras se agrupan en bloques globales de
+ * TAMANO_BLOQUE_MC; como cada bloque tiene su propio flujo, la secuencia de muestras es la misma
+ * con cualquier número de hilos o procesos, que solo deciden qué bloques evalúa cada uno.
+ *
+ * Media y varianza se acumulan con Welford por bloque y los bloques se combinan con la fórmula
+ * de Chan et al., que también se usa como operación de reducción de MPI.
+ */
+
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <stdint.h>
+#include <math.h>
+
+#define TAMANO_BLOQUE_MC 4096   // Muestras por bloque (unidad de reparto y de flujo aleatorio)
+#define DIM_MAX_MC 64           // Dimensión máxima del modo Monte Carlo
+#define MUESTRAS_POR_TANDA 64   // Muestras cuyos aleatorios se generan de una vez
+
+/* Media y suma de cuadrados de las desviaciones de n valores (tres doubles contiguos) */
+typedef struct {
+    double n;
+    double media;
+    double m2;
+} EstadisticaMC;
+
+static inline void estadistica_agregar(EstadisticaMC *e, double x) {
+    e->n += 1.0;
+    double delta = x - e->media;
+    e->media += delta / e->n;
+    e->m2 += delta * (x - e->media);
+}
+
+/* Combina b en a (Chan, Golub y LeVeque) */
+static inline void estadistica_combinar(EstadisticaMC *a, const EstadisticaMC *b) {
+    if (b->n == 0.0) {
+        return;
+    }
+    if (a->n == 0.0) {
+        *a = *b;
+        return;
+    }
+    double n = a->n + b->n;
+    double delta = b->media - a->media;
+    a->media += delta * b->n / n;
+    a->m2 += b->m2 + delta * delta * a->n * b->n / n;
+    a->n = n;
+}
+
+/* Error estándar de la media */
+static inline double estadistica_error_estandar(const EstadisticaMC *e) {
+    return e->n > 1.0 ? sqrt(e->m2 / (e->n - 1.0) / e->n) : INFINITY;
+}
+
+/* Philox4x32-10 (Salmon et al., 2011) */
+static inline void philox4x32_10(uint32_t contador[4], uint32_t clave0, uint32_t clave1) {
+    for (int ronda = 0; ronda < 10; ronda++) {
+        uint64_t p0 = (uint64_t)0xD2511F53u * contador[0];
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * contador[2];
+        uint32_t c1 = contador[1], c3 = contador[3];
+        contador[0] = (uint32_t)(p1 >> 32) ^ c1 ^ clave0;
+        contador[1] = (uint32_t)p1;
+        contador[2] = (uint32_t)(p0 >> 32) ^ c3 ^ clave1;
+        contador[3] = (uint32_t)p0;
+        clave0 += 0x9E3779B9u;
+        clave1 += 0xBB67AE85u;
+    }
+}
+
+/* Escribe 'cantidad' (par) uniformes en (0, 1) del flujo del bloque, desde la posición
+ * 'desplazamiento' (también par). Cada llamada a Philox produce dos doubles de 53 bits. */
+static inline void philox_uniformes(uint64_t semilla, uint64_t bloque, uint64_t desplazamiento,
+                                    int cantidad, double *u) {
+#if defined(_OPENMP)
+    #pragma omp simd
+#endif
+    for (int i = 0; i < cantidad / 2; i++) {
+        uint64_t j = desplazamiento / 2 + (uint64_t)i;
+        uint32_t c[4] = {(uint32_t)j, (uint32_t)(j >> 32), (uint32_t)bloque, (uint32_t)(bloque >> 32)};
+        philox4x32_10(c, (uint32_t)semilla, (uint32_t)(semilla >> 32));
+        uint64_t x = ((uint64_t)c[0] << 21) ^ (c[1] >> 11);
+        uint64_t y = ((uint64_t)c[2] << 21) ^ (c[3] >> 11);
+        u[2 * i] = ((double)x + 0.5) * 0x1.0p-53;
+        u[2 * i + 1] = ((double)y + 0.5) * 0x1.0p-53;
+    }
+}
+
+/* Evalúa 'muestras' puntos uniformes del bloque en [a, b]^dim y devuelve su estadística */
+static inline EstadisticaMC estadistica_bloque_mc(double (*integrando)(const double *, int), int dim,
+                                                  double a, double b, uint64_t semilla,
+                                                  uint64_t bloque, long muestras) {
+    double u[MUESTRAS_POR_TANDA * DIM_MAX_MC + 1];
+    int por_muestra = dim + (dim & 1);  // Se redondea a par para alinear con Philox
+    EstadisticaMC e = {0.0, 0.0, 0.0};
+
+    for (long inicio = 0; inicio < muestras; inicio += MUESTRAS_POR_TANDA) {
+        int tanda = muestras - inicio < MUESTRAS_POR_TANDA ? (int)(muestras - inicio) : MUESTRAS_POR_TANDA;
+        philox_uniformes(semilla, bloque, (uint64_t)inicio * por_muestra, tanda * por_muestra, u);
+        for (int s = 0; s < tanda; s++) {
+            double *x = &u[s * por_muestra];
+            for (int d = 0; d < dim; d++) {
+                x[d] = a + (b - a) * x[d];
+            }
+            estadistica_agregar(&e, integrando(x, dim));
+        }
+    }
+    return e;
+}
+
+#endif
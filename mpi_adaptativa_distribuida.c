@@ -0,0 +1,390 @@
+/*
+ * Programa: mpi_adaptativa_distribuida.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Este programa aproxima la integral definida de una función con cuadratura adaptativa de
+ * Gauss-Kronrod (G7-K15) repartida entre procesos MPI. Cada proceso empieza con su tramo
+ * [inicio, fin) de [a, b], como en mpi_riemann_suma.c, y guarda sus subintervalos en un
+ * montículo local ordenado por error.
+ *
+ * En lugar de que cada proceso refine donde su propio error es mayor, en cada paso se calcula
+ * un umbral global: FRACCION_UMBRAL veces el mayor error de todos los procesos
+ * (MPI_Allreduce). Solo se bisecan los subintervalos cuyo error supera el umbral, como máximo
+ * k por proceso y paso, así que el esfuerzo va a donde el error global es grande. Luego se
+ * reúne cuántos subintervalos por encima del umbral tiene cada proceso (MPI_Allgather) y los
+ * procesos se emparejan del más cargado al menos cargado: el primero cede la mitad de la
+ * diferencia, tomando sus peores subintervalos, sobre todo a los procesos que quedaron sin
+ * trabajo. El cálculo termina cuando el error global cumple la tolerancia o se agota el
+ * máximo de subdivisiones.
+ *
+ * Compilación:
+ *     mpicc -O2 -o mpi_adaptativa_distribuida mpi_adaptativa_distribuida.c -lm
+ *
+ * Uso:
+ *     mpirun -np <número_de_procesos> ./mpi_adaptativa_distribuida <a> <b> <tolerancia> <max_subdivisiones> <k>
+ *     Donde:
+ *         <a> : Límite inferior de integración (double)
+ *         <b> : Límite superior de integración (double)
+ *         <tolerancia> : Error absoluto objetivo (double positivo)
+ *         <max_subdivisiones> : Máximo de bisecciones entre todos los procesos (entero positivo)
+ *         <k> : Máximo de bisecciones por proceso y paso (entero positivo)
+ *
+ * Ejemplo:
+ *     mpirun -np 4 ./mpi_adaptativa_distribuida 0 10 1e-12 1000000 64
+ */
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define FRACCION_UMBRAL 0.25   // Se biseca todo subintervalo con error > FRACCION_UMBRAL·max
+#define PERIODO_RECALCULO 16   // Pasos entre dos recálculos de las sumas locales
+#define TAG_REGIONES 1
+
+/* Definición de la función a integrar: sin(x) con un pico estrecho en x = 1 */
+double funcion(double x) {
+    return sin(x) + 1e-2 / ((x - 1.0) * (x - 1.0) + 1e-4); // A quien lea esto, puede cambiar la función a integrar por cualquier otra función que desee.
+}
+
+/* Estructura para almacenar los parámetros de la integral */
+typedef struct {
+    double a;                // Límite inferior de integración
+    double b;                // Límite superior de integración
+    double tolerancia;       // Error absoluto objetivo
+    long max_subdivisiones;  // Presupuesto global de bisecciones
+    int k;                   // Bisecciones por proceso y paso
+} AdaptativaParams;
+
+/* Subintervalo con su estimación de Kronrod y el error |K15 - G7| */
+typedef struct {
+    double izquierdo;
+    double derecho;
+    double integral;
+    double error;
+} Region;
+
+/* Montículo de máximos ordenado por error */
+typedef struct {
+    Region *regiones;
+    long cantidad;
+    long capacidad;
+} Monticulo;
+
+static void monticulo_insertar(Monticulo *m, const Region *r) {
+    if (m->cantidad == m->capacidad) {
+        m->capacidad = m->capacidad ? 2 * m->capacidad : 1024;
+        m->regiones = realloc(m->regiones, m->capacidad * sizeof(Region));
+    }
+    long i = m->cantidad++;
+    while (i > 0 && m->regiones[(i - 1) / 2].error < r->error) {
+        m->regiones[i] = m->regiones[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    m->regiones[i] = *r;
+}
+
+static Region monticulo_extraer(Monticulo *m) {
+    Region tope = m->regiones[0];
+    Region ultimo = m->regiones[--m->cantidad];
+    long i = 0;
+    for (;;) {
+        long hijo = 2 * i + 1;
+        if (hijo >= m->cantidad) {
+            break;
+        }
+        if (hijo + 1 < m->cantidad && m->regiones[hijo + 1].error > m->regiones[hijo].error) {
+            hijo++;
+        }
+        if (m->regiones[hijo].error <= ultimo.error) {
+            break;
+        }
+        m->regiones[i] = m->regiones[hijo];
+        i = hijo;
+    }
+    if (m->cantidad > 0) {
+        m->regiones[i] = ultimo;
+    }
+    return tope;
+}
+
+/* Regla de Gauss-Kronrod de 15 puntos con la de Gauss de 7 encajada */
+static void evaluar_region(Region *r) {
+    static const double nodos[8] = {
+        0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+    static const double pesos_kronrod[8] = {
+        0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+    static const double pesos_gauss[4] = {
+        0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+    double centro = 0.5 * (r->izquierdo + r->derecho);
+    double semiancho = 0.5 * (r->derecho - r->izquierdo);
+    double f_centro = funcion(centro);
+    double kronrod = pesos_kronrod[7] * f_centro;
+    double gauss = pesos_gauss[3] * f_centro;
+
+    for (int j = 0; j < 7; j++) {
+        double suma = funcion(centro - semiancho * nodos[j]) + funcion(centro + semiancho * nodos[j]);
+        kronrod += pesos_kronrod[j] * suma;
+        if (j % 2 == 1) {
+            gauss += pesos_gauss[j / 2] * suma;
+        }
+    }
+    r->integral = kronrod * semiancho;
+    r->error = fabs((kronrod - gauss) * semiancho);
+}
+
+/* Cede las 'cantidad' peores regiones del montículo al proceso 'destino' */
+static void enviar_regiones(Monticulo *m, long cantidad, int destino,
+                            double *integral_local, double *error_local) {
+    Region *paquete = malloc((cantidad > 0 ? cantidad : 1) * sizeof(Region));
+    for (long i = 0; i < cantidad; i++) {
+        paquete[i] = monticulo_extraer(m);
+        *integral_local -= paquete[i].integral;
+        *error_local -= paquete[i].error;
+    }
+    MPI_Send(paquete, (int)(cantidad * sizeof(Region)), MPI_BYTE, destino, TAG_REGIONES, MPI_COMM_WORLD);
+    free(paquete);
+}
+
+static void recibir_regiones(Monticulo *m, long cantidad, int origen,
+                             double *integral_local, double *error_local) {
+    Region *paquete = malloc((cantidad > 0 ? cantidad : 1) * sizeof(Region));
+    MPI_Recv(paquete, (int)(cantidad * sizeof(Region)), MPI_BYTE, origen, TAG_REGIONES,
+             MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    for (long i = 0; i < cantidad; i++) {
+        monticulo_insertar(m, &paquete[i]);
+        *integral_local += paquete[i].integral;
+        *error_local += paquete[i].error;
+    }
+    free(paquete);
+}
+
+/* Cantidad de regiones del montículo con error mayor que el umbral (recorrido acotado por el
+ * orden del montículo: los hijos de una región bajo el umbral también lo están) */
+static long contar_sobre_umbral(const Monticulo *m, double umbral) {
+    long cantidad = 0;
+    long *pila = malloc((m->cantidad + 1) * sizeof(long));
+    long tope = 0;
+    if (m->cantidad > 0) {
+        pila[tope++] = 0;
+    }
+    while (tope > 0) {
+        long i = pila[--tope];
+        if (m->regiones[i].error <= umbral) {
+            continue;
+        }
+        cantidad++;
+        if (2 * i + 1 < m->cantidad) {
+            pila[tope++] = 2 * i + 1;
+        }
+        if (2 * i + 2 < m->cantidad) {
+            pila[tope++] = 2 * i + 2;
+        }
+    }
+    free(pila);
+    return cantidad;
+}
+
+typedef struct {
+    long pendientes;
+    int rank;
+} CargaProceso;
+
+static int comparar_carga(const void *x, const void *y) {
+    const CargaProceso *p = x, *q = y;
+    if (p->pendientes != q->pendientes) {
+        return p->pendientes > q->pendientes ? -1 : 1;
+    }
+    return p->rank - q->rank;
+}
+
+/* Empareja el i-ésimo proceso con más regiones sobre el umbral con el i-ésimo con menos; el
+ * primero cede la mitad de la diferencia. Devuelve las regiones cedidas por este proceso. */
+static long migrar(Monticulo *m, double umbral, int rank, int size,
+                   double *integral_local, double *error_local) {
+    long propio = contar_sobre_umbral(m, umbral);
+    long *todos = malloc(size * sizeof(long));
+    CargaProceso *cargas = malloc(size * sizeof(CargaProceso));
+    long cedidas = 0;
+
+    MPI_Allgather(&propio, 1, MPI_LONG, todos, 1, MPI_LONG, MPI_COMM_WORLD);
+    for (int p = 0; p < size; p++) {
+        cargas[p].pendientes = todos[p];
+        cargas[p].rank = p;
+    }
+    qsort(cargas, size, sizeof(CargaProceso), comparar_carga);
+
+    for (int i = 0; i < size / 2; i++) {
+        CargaProceso rico = cargas[i], pobre = cargas[size - 1 - i];
+        long cantidad = (rico.pendientes - pobre.pendientes) / 2;
+        if (cantidad == 0) {
+            continue;
+        }
+        if (rank == rico.rank) {
+            enviar_regiones(m, cantidad, pobre.rank, integral_local, error_local);
+            cedidas = cantidad;
+        } else if (rank == pobre.rank) {
+            recibir_regiones(m, cantidad, rico.rank, integral_local, error_local);
+        }
+    }
+
+    free(todos);
+    free(cargas);
+    return cedidas;
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+    AdaptativaParams params;
+    double start_time, end_time;
+
+    /* Inicialización de MPI */
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    /* Proceso raíz procesa los argumentos de línea de comandos */
+    if (rank == 0) {
+        if (argc != 6) {
+            fprintf(stderr, "Uso: %s <a> <b> <tolerancia> <max_subdivisiones> <k>\n", argv[0]);
+            fprintf(stderr, "Donde:\n");
+            fprintf(stderr, "    <a> : Límite inferior de integración (double)\n");
+            fprintf(stderr, "    <b> : Límite superior de integración (double)\n");
+            fprintf(stderr, "    <tolerancia> : Error absoluto objetivo (double positivo)\n");
+            fprintf(stderr, "    <max_subdivisiones> : Máximo de bisecciones entre todos los procesos (entero positivo)\n");
+            fprintf(stderr, "    <k> : Máximo de bisecciones por proceso y paso (entero positivo)\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        params.a = atof(argv[1]);
+        params.b = atof(argv[2]);
+        params.tolerancia = atof(argv[3]);
+        params.max_subdivisiones = atol(argv[4]);
+        params.k = atoi(argv[5]);
+
+        if (params.tolerancia <= 0.0 || params.max_subdivisiones <= 0 || params.k <= 0) {
+            fprintf(stderr, "La tolerancia, el máximo de subdivisiones y k deben ser positivos.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        printf("Aproximando la integral desde %.6f hasta %.6f con tolerancia %.3e.\n",
+               params.a, params.b, params.tolerancia);
+    }
+
+    /* Difusión de los parámetros a todos los procesos */
+    MPI_Bcast(&params, sizeof(AdaptativaParams), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    Monticulo monticulo = {NULL, 0, 0};
+    double integral_local, error_local;
+    long subdivisiones_locales = 0, cedidas_locales = 0;
+    double global[3] = {0.0, 0.0, 0.0};  // integral, error, subdivisiones
+    double error_maximo;
+    long pasos = 0;
+
+    /* Sincronización antes del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    start_time = MPI_Wtime();
+
+    /* Cada proceso empieza con su tramo de [a, b] */
+    double ancho = (params.b - params.a) / size;
+    Region inicial = {params.a + rank * ancho, (rank == size - 1) ? params.b : params.a + (rank + 1) * ancho, 0.0, 0.0};
+    evaluar_region(&inicial);
+    monticulo_insertar(&monticulo, &inicial);
+    integral_local = inicial.integral;
+    error_local = inicial.error;
+
+    Region *padres = malloc(params.k * sizeof(Region));
+
+    for (;;) {
+        double local[3] = {integral_local, error_local, (double)subdivisiones_locales};
+        double peor_local = monticulo.cantidad > 0 ? monticulo.regiones[0].error : 0.0;
+        MPI_Allreduce(local, global, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(&peor_local, &error_maximo, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+        if (global[1] <= params.tolerancia || global[2] >= params.max_subdivisiones) {
+            break;
+        }
+
+        /* Umbral global: los procesos ociosos reciben regiones de los más cargados */
+        double umbral = FRACCION_UMBRAL * error_maximo;
+        if (size > 1) {
+            cedidas_locales += migrar(&monticulo, umbral, rank, size, &integral_local, &error_local);
+        }
+
+        /* Bisección de las regiones sobre el umbral, las peores primero */
+        int tomadas = 0;
+        while (tomadas < params.k && monticulo.cantidad > 0 && monticulo.regiones[0].error > umbral) {
+            padres[tomadas] = monticulo_extraer(&monticulo);
+            integral_local -= padres[tomadas].integral;
+            error_local -= padres[tomadas].error;
+            tomadas++;
+        }
+        for (int i = 0; i < tomadas; i++) {
+            double medio = 0.5 * (padres[i].izquierdo + padres[i].derecho);
+            Region hijos[2] = {{padres[i].izquierdo, medio, 0.0, 0.0}, {medio, padres[i].derecho, 0.0, 0.0}};
+            for (int h = 0; h < 2; h++) {
+                evaluar_region(&hijos[h]);
+                monticulo_insertar(&monticulo, &hijos[h]);
+                integral_local += hijos[h].integral;
+                error_local += hijos[h].error;
+            }
+        }
+        subdivisiones_locales += tomadas;
+
+        /* Las restas y sumas sucesivas acumulan redondeo: se recalcula desde el montículo */
+        if (++pasos % PERIODO_RECALCULO == 0) {
+            integral_local = 0.0;
+            error_local = 0.0;
+            for (long i = 0; i < monticulo.cantidad; i++) {
+                integral_local += monticulo.regiones[i].integral;
+                error_local += monticulo.regiones[i].error;
+            }
+        }
+    }
+
+    /* Sincronización después del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    end_time = MPI_Wtime();
+
+    /* Suma final exacta desde los montículos */
+    double integral_final = 0.0, resultado;
+    for (long i = 0; i < monticulo.cantidad; i++) {
+        integral_final += monticulo.regiones[i].integral;
+    }
+    MPI_Reduce(&integral_final, &resultado, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    long *subdivisiones = malloc(size * sizeof(long));
+    long *cedidas = malloc(size * sizeof(long));
+    MPI_Gather(&subdivisiones_locales, 1, MPI_LONG, subdivisiones, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+    MPI_Gather(&cedidas_locales, 1, MPI_LONG, cedidas, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+
+    /* Proceso raíz muestra el resultado y el tiempo de ejecución */
+    if (rank == 0) {
+        for (int p = 0; p < size; p++) {
+            printf("  Proceso %d: %ld bisecciones, %ld regiones cedidas\n", p, subdivisiones[p], cedidas[p]);
+        }
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Error estimado: %.3e (%.0f bisecciones, %ld pasos).\n", global[1], global[2], pasos);
+        printf("Tiempo de ejecución: %.6f segundos.\n", end_time - start_time);
+    }
+
+    free(subdivisiones);
+    free(cedidas);
+    free(padres);
+    free(monticulo.regiones);
+
+    /* Finalización de MPI */
+    MPI_Finalize();
+
+    return 0;
+}
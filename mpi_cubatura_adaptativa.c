@@ -0,0 +1,430 @@
+/*
+ * Programa: mpi_cubatura_adaptativa.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Este programa aproxima integrales de 2 a 10 dimensiones sobre la caja [a, b]^dim con
+ * cubatura adaptativa de Genz-Malik: en cada subregión se aplica la regla de grado 7 con
+ * 2^dim + 2dim² + 2dim + 1 puntos y su regla encajada de grado 5, cuya diferencia estima el
+ * error. Las subregiones se guardan en un montículo ordenado por error; en cada paso se toman
+ * las k de mayor error, se biseca cada una en la dimensión con la mayor cuarta diferencia y
+ * las 2k mitades se evalúan en paralelo con hilos de OpenMP.
+ *
+ * Con varios procesos, cada uno empieza con una franja de la caja y mantiene su propio
+ * montículo. Tras cada paso se suman integral y error globales (MPI_Allreduce) para decidir
+ * la terminación, y periódicamente los procesos se emparejan del más cargado (mayor error
+ * pendiente) al menos cargado para que el primero le ceda sus peores regiones.
+ *
+ * Compilación:
+ *     mpicc -fopenmp -O2 -o mpi_cubatura_adaptativa mpi_cubatura_adaptativa.c -lm
+ *
+ * Uso:
+ *     mpirun -np <número_de_procesos> ./mpi_cubatura_adaptativa <a> <b> <dim> <tolerancia> <max_evaluaciones> <k> <numero_de_hilos>
+ *     Donde:
+ *         <a> : Límite inferior de integración en cada dimensión (double)
+ *         <b> : Límite superior de integración en cada dimensión (double)
+ *         <dim> : Dimensión de la integral (2 a 10)
+ *         <tolerancia> : Error relativo objetivo (double positivo)
+ *         <max_evaluaciones> : Máximo de evaluaciones de la función (entero positivo)
+ *         <k> : Regiones que cada proceso subdivide por paso (entero positivo)
+ *         <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)
+ *
+ * Ejemplo:
+ *     mpirun -np 4 ./mpi_cubatura_adaptativa 0 1 5 1e-6 100000000 64 2
+ */
+
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DIM_MAX 10
+#define PERIODO_BALANCE 8   // Pasos entre dos intercambios de regiones
+#define TAG_REGIONES 1
+
+/* Definición de la función a integrar: un pico gaussiano estrecho centrado en 0.5 */
+double funcion(const double *x, int dim) {
+    double r2 = 0.0;
+    for (int d = 0; d < dim; d++) {
+        r2 += (x[d] - 0.5) * (x[d] - 0.5);
+    }
+    return exp(-r2 / (2.0 * 0.05 * 0.05)); // A quien lea esto, puede cambiar la función a integrar por cualquier otra función que desee.
+}
+
+/* Estructura para almacenar los parámetros de la integral */
+typedef struct {
+    double a;               // Límite inferior en cada dimensión
+    double b;               // Límite superior en cada dimensión
+    int dim;                // Dimensión
+    double tolerancia;      // Error relativo objetivo
+    long max_evaluaciones;  // Presupuesto global de evaluaciones
+    int k;                  // Regiones por paso y proceso
+    int hilos;              // Hilos de OpenMP por proceso
+} AdaptativaParams;
+
+/* Subregión [centro - semiancho, centro + semiancho] con su estimación */
+typedef struct {
+    double centro[DIM_MAX];
+    double semiancho[DIM_MAX];
+    double integral;
+    double error;
+    int eje;  // Dimensión en la que conviene bisecar
+} Region;
+
+/* Montículo de máximos ordenado por error */
+typedef struct {
+    Region *regiones;
+    long cantidad;
+    long capacidad;
+} Monticulo;
+
+static void monticulo_insertar(Monticulo *m, const Region *r) {
+    if (m->cantidad == m->capacidad) {
+        m->capacidad = m->capacidad ? 2 * m->capacidad : 1024;
+        m->regiones = realloc(m->regiones, m->capacidad * sizeof(Region));
+    }
+    long i = m->cantidad++;
+    while (i > 0 && m->regiones[(i - 1) / 2].error < r->error) {
+        m->regiones[i] = m->regiones[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    m->regiones[i] = *r;
+}
+
+static Region monticulo_extraer(Monticulo *m) {
+    Region tope = m->regiones[0];
+    Region ultimo = m->regiones[--m->cantidad];
+    long i = 0;
+    for (;;) {
+        long hijo = 2 * i + 1;
+        if (hijo >= m->cantidad) {
+            break;
+        }
+        if (hijo + 1 < m->cantidad && m->regiones[hijo + 1].error > m->regiones[hijo].error) {
+            hijo++;
+        }
+        if (m->regiones[hijo].error <= ultimo.error) {
+            break;
+        }
+        m->regiones[i] = m->regiones[hijo];
+        i = hijo;
+    }
+    if (m->cantidad > 0) {
+        m->regiones[i] = ultimo;
+    }
+    return tope;
+}
+
+/* Evalúa la regla de Genz-Malik en la región; devuelve el número de evaluaciones */
+static long evaluar_region(Region *r, int dim) {
+    const double lambda2 = sqrt(9.0 / 70.0);
+    const double lambda4 = sqrt(9.0 / 10.0);
+    const double lambda5 = sqrt(9.0 / 19.0);
+    const double razon = (lambda2 * lambda2) / (lambda4 * lambda4);
+    const double peso1 = (12824.0 - 9120.0 * dim + 400.0 * dim * dim) / 19683.0;
+    const double peso2 = 980.0 / 6561.0;
+    const double peso3 = (1820.0 - 400.0 * dim) / 19683.0;
+    const double peso4 = 200.0 / 19683.0;
+    const double peso5 = 6859.0 / 19683.0 / (double)(1L << dim);
+    const double peso_e1 = (729.0 - 950.0 * dim + 50.0 * dim * dim) / 729.0;
+    const double peso_e2 = 245.0 / 486.0;
+    const double peso_e3 = (265.0 - 100.0 * dim) / 1458.0;
+    const double peso_e4 = 25.0 / 729.0;
+
+    double x[DIM_MAX];
+    double volumen = 1.0;
+    for (int d = 0; d < dim; d++) {
+        x[d] = r->centro[d];
+        volumen *= 2.0 * r->semiancho[d];
+    }
+
+    double f0 = funcion(x, dim);
+    double suma2 = 0.0, suma3 = 0.0, suma4 = 0.0, suma5 = 0.0;
+    double max_diferencia = -1.0;
+    r->eje = 0;
+
+    /* Puntos sobre los ejes y cuarta diferencia por dimensión */
+    for (int i = 0; i < dim; i++) {
+        double c = r->centro[i], h = r->semiancho[i];
+        x[i] = c - lambda2 * h;
+        double f2a = funcion(x, dim);
+        x[i] = c + lambda2 * h;
+        double f2b = funcion(x, dim);
+        x[i] = c - lambda4 * h;
+        double f3a = funcion(x, dim);
+        x[i] = c + lambda4 * h;
+        double f3b = funcion(x, dim);
+        x[i] = c;
+
+        suma2 += f2a + f2b;
+        suma3 += f3a + f3b;
+        double diferencia = fabs(f2a + f2b - 2.0 * f0 - razon * (f3a + f3b - 2.0 * f0));
+        if (diferencia > max_diferencia * (1.0 + 1e-10)
+            || (diferencia >= max_diferencia * (1.0 - 1e-10) && h > r->semiancho[r->eje])) {
+            max_diferencia = diferencia > max_diferencia ? diferencia : max_diferencia;
+            r->eje = i;
+        }
+    }
+
+    /* Puntos (±lambda4, ±lambda4) en cada par de dimensiones */
+    for (int i = 0; i < dim; i++) {
+        for (int j = i + 1; j < dim; j++) {
+            double ci = r->centro[i], cj = r->centro[j];
+            double hi = lambda4 * r->semiancho[i], hj = lambda4 * r->semiancho[j];
+            for (int s = 0; s < 4; s++) {
+                x[i] = (s & 1) ? ci + hi : ci - hi;
+                x[j] = (s & 2) ? cj + hj : cj - hj;
+                suma4 += funcion(x, dim);
+            }
+            x[i] = ci;
+            x[j] = cj;
+        }
+    }
+
+    /* Vértices escalados (±lambda5, ..., ±lambda5) */
+    for (long signos = 0; signos < (1L << dim); signos++) {
+        for (int d = 0; d < dim; d++) {
+            double h = lambda5 * r->semiancho[d];
+            x[d] = ((signos >> d) & 1) ? r->centro[d] + h : r->centro[d] - h;
+        }
+        suma5 += funcion(x, dim);
+    }
+
+    double grado7 = volumen * (peso1 * f0 + peso2 * suma2 + peso3 * suma3 + peso4 * suma4 + peso5 * suma5);
+    double grado5 = volumen * (peso_e1 * f0 + peso_e2 * suma2 + peso_e3 * suma3 + peso_e4 * suma4);
+    r->integral = grado7;
+    r->error = fabs(grado7 - grado5);
+
+    return 1 + 4L * dim + 2L * dim * (dim - 1) + (1L << dim);
+}
+
+/* Cede las 'cantidad' peores regiones del montículo al proceso 'destino' */
+static void enviar_regiones(Monticulo *m, long cantidad, int destino,
+                            double *integral_local, double *error_local) {
+    Region *paquete = malloc((cantidad > 0 ? cantidad : 1) * sizeof(Region));
+    for (long i = 0; i < cantidad; i++) {
+        paquete[i] = monticulo_extraer(m);
+        *integral_local -= paquete[i].integral;
+        *error_local -= paquete[i].error;
+    }
+    MPI_Send(paquete, (int)(cantidad * sizeof(Region)), MPI_BYTE, destino, TAG_REGIONES, MPI_COMM_WORLD);
+    free(paquete);
+}
+
+static void recibir_regiones(Monticulo *m, long cantidad, int origen,
+                             double *integral_local, double *error_local) {
+    Region *paquete = malloc((cantidad > 0 ? cantidad : 1) * sizeof(Region));
+    MPI_Recv(paquete, (int)(cantidad * sizeof(Region)), MPI_BYTE, origen, TAG_REGIONES,
+             MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    for (long i = 0; i < cantidad; i++) {
+        monticulo_insertar(m, &paquete[i]);
+        *integral_local += paquete[i].integral;
+        *error_local += paquete[i].error;
+    }
+    free(paquete);
+}
+
+typedef struct {
+    double error;
+    int rank;
+} CargaProceso;
+
+static int comparar_carga(const void *x, const void *y) {
+    const CargaProceso *p = x, *q = y;
+    if (p->error != q->error) {
+        return p->error > q->error ? -1 : 1;
+    }
+    return p->rank - q->rank;
+}
+
+/* Empareja el i-ésimo proceso más cargado con el i-ésimo menos cargado; el primero cede
+ * sus peores regiones si su error pendiente es más del doble que el del segundo. */
+static void balancear(Monticulo *m, const AdaptativaParams *params, int rank, int size,
+                      double *integral_local, double *error_local) {
+    double propio[2] = {*error_local, (double)m->cantidad};
+    double *todos = malloc(2 * size * sizeof(double));
+    CargaProceso *cargas = malloc(size * sizeof(CargaProceso));
+
+    MPI_Allgather(propio, 2, MPI_DOUBLE, todos, 2, MPI_DOUBLE, MPI_COMM_WORLD);
+    for (int p = 0; p < size; p++) {
+        cargas[p].error = todos[2 * p];
+        cargas[p].rank = p;
+    }
+    qsort(cargas, size, sizeof(CargaProceso), comparar_carga);
+
+    for (int i = 0; i < size / 2; i++) {
+        CargaProceso rico = cargas[i], pobre = cargas[size - 1 - i];
+        long disponibles = (long)todos[2 * rico.rank + 1];
+        long cantidad = disponibles / 2 < params->k ? disponibles / 2 : params->k;
+        if (cantidad == 0 || rico.error <= 2.0 * pobre.error) {
+            continue;
+        }
+        if (rank == rico.rank) {
+            enviar_regiones(m, cantidad, pobre.rank, integral_local, error_local);
+        } else if (rank == pobre.rank) {
+            recibir_regiones(m, cantidad, rico.rank, integral_local, error_local);
+        }
+    }
+
+    free(todos);
+    free(cargas);
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+    AdaptativaParams params;
+    double start_time, end_time;
+
+    /* Inicialización de MPI */
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    /* Proceso raíz procesa los argumentos de línea de comandos */
+    if (rank == 0) {
+        if (argc != 8) {
+            fprintf(stderr, "Uso: %s <a> <b> <dim> <tolerancia> <max_evaluaciones> <k> <numero_de_hilos>\n", argv[0]);
+            fprintf(stderr, "Donde:\n");
+            fprintf(stderr, "    <a> : Límite inferior de integración en cada dimensión (double)\n");
+            fprintf(stderr, "    <b> : Límite superior de integración en cada dimensión (double)\n");
+            fprintf(stderr, "    <dim> : Dimensión de la integral (2 a 10)\n");
+            fprintf(stderr, "    <tolerancia> : Error relativo objetivo (double positivo)\n");
+            fprintf(stderr, "    <max_evaluaciones> : Máximo de evaluaciones de la función (entero positivo)\n");
+            fprintf(stderr, "    <k> : Regiones que cada proceso subdivide por paso (entero positivo)\n");
+            fprintf(stderr, "    <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        params.a = atof(argv[1]);
+        params.b = atof(argv[2]);
+        params.dim = atoi(argv[3]);
+        params.tolerancia = atof(argv[4]);
+        params.max_evaluaciones = atol(argv[5]);
+        params.k = atoi(argv[6]);
+        params.hilos = atoi(argv[7]);
+
+        if (params.dim < 2 || params.dim > DIM_MAX) {
+            fprintf(stderr, "La dimensión debe estar entre 2 y %d.\n", DIM_MAX);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (params.tolerancia <= 0.0 || params.max_evaluaciones <= 0 || params.k <= 0 || params.hilos <= 0) {
+            fprintf(stderr, "La tolerancia, el máximo de evaluaciones, k y el número de hilos deben ser positivos.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        printf("Aproximando la integral %dD sobre [%.6f, %.6f]^%d con tolerancia relativa %.3e.\n",
+               params.dim, params.a, params.b, params.dim, params.tolerancia);
+    }
+
+    /* Difusión de los parámetros a todos los procesos */
+    MPI_Bcast(&params, sizeof(AdaptativaParams), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    int dim = params.dim;
+    Monticulo monticulo = {NULL, 0, 0};
+    double integral_local = 0.0, error_local = 0.0;
+    long evaluaciones_locales = 0;
+    double global[3] = {0.0, 0.0, 0.0};  // integral, error, evaluaciones
+    long pasos = 0;
+
+    /* Sincronización antes del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    start_time = MPI_Wtime();
+
+    /* Cada proceso empieza con una franja de la caja a lo largo de la primera dimensión */
+    Region inicial;
+    double ancho_franja = (params.b - params.a) / size;
+    for (int d = 0; d < dim; d++) {
+        inicial.centro[d] = 0.5 * (params.a + params.b);
+        inicial.semiancho[d] = 0.5 * (params.b - params.a);
+    }
+    inicial.centro[0] = params.a + (rank + 0.5) * ancho_franja;
+    inicial.semiancho[0] = 0.5 * ancho_franja;
+    evaluaciones_locales += evaluar_region(&inicial, dim);
+    monticulo_insertar(&monticulo, &inicial);
+    integral_local = inicial.integral;
+    error_local = inicial.error;
+
+    Region *padres = malloc(params.k * sizeof(Region));
+    Region *hijos = malloc(2 * params.k * sizeof(Region));
+
+    for (;;) {
+        double local[3] = {integral_local, error_local, (double)evaluaciones_locales};
+        MPI_Allreduce(local, global, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+        if (global[1] <= params.tolerancia * fabs(global[0]) || global[2] >= params.max_evaluaciones) {
+            break;
+        }
+
+        /* Las k regiones de mayor error se bisecan en su eje de mayor cuarta diferencia */
+        int tomadas = 0;
+        while (tomadas < params.k && monticulo.cantidad > 0) {
+            padres[tomadas] = monticulo_extraer(&monticulo);
+            integral_local -= padres[tomadas].integral;
+            error_local -= padres[tomadas].error;
+            tomadas++;
+        }
+        for (int i = 0; i < tomadas; i++) {
+            int eje = padres[i].eje;
+            hijos[2 * i] = padres[i];
+            hijos[2 * i + 1] = padres[i];
+            hijos[2 * i].semiancho[eje] *= 0.5;
+            hijos[2 * i + 1].semiancho[eje] *= 0.5;
+            hijos[2 * i].centro[eje] -= hijos[2 * i].semiancho[eje];
+            hijos[2 * i + 1].centro[eje] += hijos[2 * i + 1].semiancho[eje];
+        }
+
+        /* Evaluación paralela de las 2k mitades */
+        long evaluaciones_paso = 0;
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(params.hilos) reduction(+:evaluaciones_paso)
+        for (int i = 0; i < 2 * tomadas; i++) {
+            evaluaciones_paso += evaluar_region(&hijos[i], dim);
+        }
+        evaluaciones_locales += evaluaciones_paso;
+
+        for (int i = 0; i < 2 * tomadas; i++) {
+            monticulo_insertar(&monticulo, &hijos[i]);
+            integral_local += hijos[i].integral;
+            error_local += hijos[i].error;
+        }
+
+        /* Las restas y sumas sucesivas acumulan redondeo: se recalcula desde el montículo */
+        if (++pasos % PERIODO_BALANCE == 0) {
+            integral_local = 0.0;
+            error_local = 0.0;
+            for (long i = 0; i < monticulo.cantidad; i++) {
+                integral_local += monticulo.regiones[i].integral;
+                error_local += monticulo.regiones[i].error;
+            }
+            if (size > 1) {
+                balancear(&monticulo, &params, rank, size, &integral_local, &error_local);
+            }
+        }
+    }
+
+    /* Sincronización después del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    end_time = MPI_Wtime();
+
+    long regiones_totales;
+    MPI_Reduce(&monticulo.cantidad, &regiones_totales, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    /* Proceso raíz muestra el resultado y el tiempo de ejecución */
+    if (rank == 0) {
+        printf("Resultado de la integral aproximada: %.12f\n", global[0]);
+        printf("Error estimado: %.3e (%ld regiones, %.0f evaluaciones, %ld pasos).\n",
+               global[1], regiones_totales, global[2], pasos);
+        printf("Tiempo de ejecución: %.6f segundos.\n", end_time - start_time);
+    }
+
+    free(padres);
+    free(hijos);
+    free(monticulo.regiones);
+
+    /* Finalización de MPI */
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * Programa: mpi_cubatura_tensorial.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Este programa aproxima integrales dobles y triples sobre una caja [a1,b1] × [a2,b2] (× [a3,b3])
+ * con cubatura de producto tensorial: la caja se divide en n celdas por dimensión y en cada
+ * celda se aplica el producto de la Regla del Punto Medio o de Gauss-Legendre de 2 o 3 puntos.
+ *
+ * Los procesos forman una malla cartesiana (MPI_Cart_create) con tantas dimensiones como la
+ * integral, y cada proceso integra la subcaja de celdas que le corresponde según sus
+ * coordenadas. Dentro de cada proceso, los hilos de OpenMP recorren bloques (teselas) de las
+ * dos dimensiones más internas, de modo que cada bloque cabe en caché y se evalúa con una sola
+ * llamada a la función por lotes, cuyo bucle interno el compilador puede vectorizar.
+ *
+ * Compilación:
+ *     mpicc -fopenmp -O2 -o mpi_cubatura_tensorial mpi_cubatura_tensorial.c -lm
+ *
+ * Uso:
+ *     mpirun -np <número_de_procesos> ./mpi_cubatura_tensorial <dim> <regla> <n> <numero_de_hilos> <a1> <b1> <a2> <b2> [<a3> <b3>]
+ *     Donde:
+ *         <dim> : Dimensión de la integral (2 o 3)
+ *         <regla> : punto_medio | gauss2 | gauss3
+ *         <n> : Número de celdas por dimensión (entero positivo)
+ *         <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)
+ *         <ai> <bi> : Límites de integración en la dimensión i (double)
+ *
+ * Ejemplo:
+ *     mpirun -np 4 ./mpi_cubatura_tensorial 3 gauss2 400 2 0 3.141592653589793 0 3.141592653589793 0 3.141592653589793
+ */
+
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DIM_MAX 3
+#define TESELA_1 16   // Puntos por tesela en la penúltima dimensión
+#define TESELA_2 64   // Puntos por tesela en la última dimensión
+
+/* Definición de la función a integrar, evaluada por lotes de m puntos en forma SoA:
+ * x[d * m + i] es la coordenada d del punto i. */
+void funcion_lote(int dim, long m, const double *restrict x, double *restrict valores) {
+    #pragma omp simd
+    for (long i = 0; i < m; i++) {
+        double producto = 1.0;
+        for (int d = 0; d < dim; d++) {
+            producto *= sin(x[d * m + i]);
+        }
+        valores[i] = producto; // A quien lea esto, puede cambiar la función a integrar por cualquier otra función que desee.
+    }
+}
+
+/* Estructura para almacenar los parámetros de la integral */
+typedef struct {
+    int dim;                // Dimensión (2 o 3)
+    int puntos_regla;       // Puntos de la regla 1D por celda (1, 2 o 3)
+    long n;                 // Celdas por dimensión
+    int hilos;              // Hilos de OpenMP por proceso
+    double a[DIM_MAX];      // Límites inferiores
+    double b[DIM_MAX];      // Límites superiores
+} CubaturaParams;
+
+/* Nodos (en [-1, 1]) y pesos (suman 2) de la regla 1D por celda */
+static void regla_1d(int puntos, double *nodos, double *pesos) {
+    switch (puntos) {
+    case 1:
+        nodos[0] = 0.0;
+        pesos[0] = 2.0;
+        break;
+    case 2:
+        nodos[0] = -1.0 / sqrt(3.0);
+        nodos[1] = 1.0 / sqrt(3.0);
+        pesos[0] = pesos[1] = 1.0;
+        break;
+    default:
+        nodos[0] = -sqrt(0.6);
+        nodos[1] = 0.0;
+        nodos[2] = sqrt(0.6);
+        pesos[0] = pesos[2] = 5.0 / 9.0;
+        pesos[1] = 8.0 / 9.0;
+        break;
+    }
+}
+
+/* Nodos y pesos 1D de las celdas [inicio, fin) de la dimensión d */
+static long puntos_dimension(const CubaturaParams *params, int d, long inicio, long fin,
+                             double **x, double **w) {
+    double nodos[3], pesos[3];
+    double h = (params->b[d] - params->a[d]) / params->n;
+    long total = (fin - inicio) * params->puntos_regla;
+
+    regla_1d(params->puntos_regla, nodos, pesos);
+    *x = malloc((total > 0 ? total : 1) * sizeof(double));
+    *w = malloc((total > 0 ? total : 1) * sizeof(double));
+
+    for (long c = inicio; c < fin; c++) {
+        double centro = params->a[d] + (c + 0.5) * h;
+        for (int q = 0; q < params->puntos_regla; q++) {
+            long k = (c - inicio) * params->puntos_regla + q;
+            (*x)[k] = centro + 0.5 * h * nodos[q];
+            (*w)[k] = 0.5 * h * pesos[q];
+        }
+    }
+    return total;
+}
+
+/* Cubatura sobre la subcaja del proceso. Las dimensiones externas se recorren punto por
+ * punto y las dos internas por teselas de TESELA_1 × TESELA_2 puntos. */
+double calcular_cubatura_local(const CubaturaParams *params, const long *inicio, const long *fin) {
+    int dim = params->dim;
+    double *x[DIM_MAX], *w[DIM_MAX];
+    long m[DIM_MAX];
+
+    for (int d = 0; d < dim; d++) {
+        m[d] = puntos_dimension(params, d, inicio[d], fin[d], &x[d], &w[d]);
+    }
+
+    long externos = 1;
+    for (int d = 0; d < dim - 2; d++) {
+        externos *= m[d];
+    }
+    long teselas_1 = (m[dim - 2] + TESELA_1 - 1) / TESELA_1;
+    long teselas_2 = (m[dim - 1] + TESELA_2 - 1) / TESELA_2;
+    long trabajos = externos * teselas_1 * teselas_2;
+    double suma = 0.0;
+
+    #pragma omp parallel num_threads(params->hilos) reduction(+:suma)
+    {
+        double *lote = malloc((size_t)dim * TESELA_1 * TESELA_2 * sizeof(double));
+        double *pesos = malloc(TESELA_1 * TESELA_2 * sizeof(double));
+        double *valores = malloc(TESELA_1 * TESELA_2 * sizeof(double));
+
+        #pragma omp for schedule(static)
+        for (long t = 0; t < trabajos; t++) {
+            long t2 = t % teselas_2;
+            long t1 = (t / teselas_2) % teselas_1;
+            long e = t / (teselas_2 * teselas_1);
+
+            long i1_inicio = t1 * TESELA_1;
+            long i1_fin = i1_inicio + TESELA_1 < m[dim - 2] ? i1_inicio + TESELA_1 : m[dim - 2];
+            long i2_inicio = t2 * TESELA_2;
+            long i2_fin = i2_inicio + TESELA_2 < m[dim - 1] ? i2_inicio + TESELA_2 : m[dim - 1];
+            long ancho = i2_fin - i2_inicio;
+            long puntos = (i1_fin - i1_inicio) * ancho;
+
+            /* Coordenadas externas y su peso, comunes a toda la tesela */
+            double externo[DIM_MAX];
+            double peso_externo = 1.0;
+            long resto = e;
+            for (int d = dim - 3; d >= 0; d--) {
+                long i = resto % m[d];
+                resto /= m[d];
+                externo[d] = x[d][i];
+                peso_externo *= w[d][i];
+            }
+
+            for (long i1 = i1_inicio; i1 < i1_fin; i1++) {
+                long fila = (i1 - i1_inicio) * ancho;
+                for (long i2 = i2_inicio; i2 < i2_fin; i2++) {
+                    long k = fila + (i2 - i2_inicio);
+                    for (int d = 0; d < dim - 2; d++) {
+                        lote[d * puntos + k] = externo[d];
+                    }
+                    lote[(dim - 2) * puntos + k] = x[dim - 2][i1];
+                    lote[(dim - 1) * puntos + k] = x[dim - 1][i2];
+                    pesos[k] = peso_externo * w[dim - 2][i1] * w[dim - 1][i2];
+                }
+            }
+
+            funcion_lote(dim, puntos, lote, valores);
+
+            double suma_tesela = 0.0;
+            #pragma omp simd reduction(+:suma_tesela)
+            for (long k = 0; k < puntos; k++) {
+                suma_tesela += pesos[k] * valores[k];
+            }
+            suma += suma_tesela;
+        }
+
+        free(lote);
+        free(pesos);
+        free(valores);
+    }
+
+    for (int d = 0; d < dim; d++) {
+        free(x[d]);
+        free(w[d]);
+    }
+    return suma;
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+    CubaturaParams params;
+    double suma_local = 0.0, suma_total = 0.0;
+    double start_time, end_time;
+
+    /* Inicialización de MPI */
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    /* Proceso raíz procesa los argumentos de línea de comandos */
+    if (rank == 0) {
+        int dim = argc > 1 ? atoi(argv[1]) : 0;
+        if ((dim != 2 && dim != 3) || argc != 5 + 2 * dim) {
+            fprintf(stderr, "Uso: %s <dim> <regla> <n> <numero_de_hilos> <a1> <b1> <a2> <b2> [<a3> <b3>]\n", argv[0]);
+            fprintf(stderr, "Donde:\n");
+            fprintf(stderr, "    <dim> : Dimensión de la integral (2 o 3)\n");
+            fprintf(stderr, "    <regla> : punto_medio | gauss2 | gauss3\n");
+            fprintf(stderr, "    <n> : Número de celdas por dimensión (entero positivo)\n");
+            fprintf(stderr, "    <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)\n");
+            fprintf(stderr, "    <ai> <bi> : Límites de integración en la dimensión i (double)\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        params.dim = dim;
+        if (strcmp(argv[2], "punto_medio") == 0) {
+            params.puntos_regla = 1;
+        } else if (strcmp(argv[2], "gauss2") == 0) {
+            params.puntos_regla = 2;
+        } else if (strcmp(argv[2], "gauss3") == 0) {
+            params.puntos_regla = 3;
+        } else {
+            fprintf(stderr, "La regla debe ser punto_medio, gauss2 o gauss3.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        params.n = atol(argv[3]);
+        params.hilos = atoi(argv[4]);
+        for (int d = 0; d < dim; d++) {
+            params.a[d] = atof(argv[5 + 2 * d]);
+            params.b[d] = atof(argv[6 + 2 * d]);
+        }
+
+        if (params.n <= 0 || params.hilos <= 0) {
+            fprintf(stderr, "El número de celdas y el número de hilos deben ser enteros positivos.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        printf("Aproximando la integral %dD del producto de senos con %ld celdas por dimensión y la regla %s.\n",
+               params.dim, params.n, argv[2]);
+    }
+
+    /* Difusión de los parámetros a todos los procesos */
+    MPI_Bcast(&params, sizeof(CubaturaParams), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    /* Malla cartesiana de procesos y subcaja de cada uno */
+    int dims[DIM_MAX] = {0, 0, 0};
+    int periodos[DIM_MAX] = {0, 0, 0};
+    int coords[DIM_MAX];
+    MPI_Comm comm_cart;
+
+    MPI_Dims_create(size, params.dim, dims);
+    MPI_Cart_create(MPI_COMM_WORLD, params.dim, dims, periodos, 1, &comm_cart);
+    MPI_Comm_rank(comm_cart, &rank);
+    MPI_Cart_coords(comm_cart, rank, params.dim, coords);
+
+    long inicio[DIM_MAX], fin[DIM_MAX];
+    for (int d = 0; d < params.dim; d++) {
+        inicio[d] = params.n * coords[d] / dims[d];
+        fin[d] = params.n * (coords[d] + 1) / dims[d];
+    }
+
+    if (rank == 0) {
+        printf("Malla de procesos:");
+        for (int d = 0; d < params.dim; d++) {
+            printf(" %d", dims[d]);
+        }
+        printf(" (%d procesos, %d hilos por proceso).\n", size, params.hilos);
+    }
+
+    /* Sincronización antes del cálculo */
+    MPI_Barrier(comm_cart);
+    start_time = MPI_Wtime();
+
+    /* Cálculo de la cubatura local */
+    suma_local = calcular_cubatura_local(&params, inicio, fin);
+
+    /* Reducción de las sumas locales para obtener la suma total */
+    MPI_Reduce(&suma_local, &suma_total, 1, MPI_DOUBLE, MPI_SUM, 0, comm_cart);
+
+    /* Sincronización después del cálculo */
+    MPI_Barrier(comm_cart);
+    end_time = MPI_Wtime();
+
+    /* Proceso raíz muestra el resultado y el tiempo de ejecución */
+    if (rank == 0) {
+        printf("Resultado de la integral aproximada: %.12f\n", suma_total);
+        printf("Tiempo de ejecución: %.6f segundos.\n", end_time - start_time);
+    }
+
+    MPI_Comm_free(&comm_cart);
+
+    /* Finalización de MPI */
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * Programa: mpi_fourier_fft.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Este programa calcula de una sola vez los K primeros coeficientes de Fourier
+ *     c_k = ∫_a^b f(x) e^{-i w_k x} dx,   w_k = 2πk / (b - a),   k = 0..K-1
+ * (w_k = k cuando b - a = 2π). En lugar de K sumas de Riemann independientes (costo O(nK)),
+ * la función se muestrea una vez en la malla del punto medio y todos los coeficientes se
+ * obtienen con una FFT radix-2 propia (costo O(n log n)). A cada coeficiente se le suma la
+ * corrección de Euler-Maclaurin de los extremos, h²/24 (g'(b) - g'(a)) con g = f e^{-iwx},
+ * estimando f' en los extremos con diferencias de segundo orden, lo que lleva el error de
+ * O(h²) a O(h⁴) cuando f no es periódica.
+ *
+ * Con un solo proceso la FFT se paraleliza con OpenMP por etapas de mariposas. Con varios
+ * procesos se usa el algoritmo de cuatro pasos: los n = n1·n2 datos se ven como una matriz
+ * n2 × n1 repartida por filas, se transpone con MPI_Alltoall, se hacen FFT de longitud n2,
+ * se multiplican los factores de giro, se transpone de nuevo y se hacen FFT de longitud n1.
+ * Las FFT de cada proceso se reparten entre hilos de OpenMP.
+ *
+ * Compilación:
+ *     mpicc -fopenmp -O2 -o mpi_fourier_fft mpi_fourier_fft.c -lm
+ *
+ * Uso:
+ *     mpirun -np <número_de_procesos> ./mpi_fourier_fft <a> <b> <n> <K> <numero_de_hilos> [archivo_salida]
+ *     Donde:
+ *         <a> : Límite inferior de integración (double)
+ *         <b> : Límite superior de integración (double)
+ *         <n> : Número de subintervalos (potencia de dos)
+ *         <K> : Número de coeficientes a calcular (1 <= K <= n/2)
+ *         <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)
+ *         [archivo_salida] : Archivo donde escribir los K coeficientes "k re im"
+ *     El número de procesos debe ser potencia de dos y dividir a n1 y n2 (≈ sqrt(n)).
+ *
+ * Ejemplo:
+ *     mpirun -np 4 ./mpi_fourier_fft 0 3.141592653589793 16777216 1000 2 coeficientes.txt
+ */
+
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <complex.h>
+
+#define COEFICIENTES_EN_PANTALLA 8
+
+/* Definición de la función a integrar */
+double funcion(double x) {
+    return sin(x); // A quien lea esto, puede cambiar la función a integrar por cualquier otra función que desee.
+}
+
+/* Estructura para almacenar los parámetros de la integral */
+typedef struct {
+    double a;      // Límite inferior de integración
+    double b;      // Límite superior de integración
+    long n;        // Número de subintervalos (potencia de dos)
+    long K;        // Número de coeficientes
+    int hilos;     // Hilos de OpenMP por proceso
+} FourierParams;
+
+static int es_potencia_de_dos(long x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+/* Tabla de factores de giro w[k] = exp(-2πik/m), k < m/2 */
+static double complex *crear_tabla_giros(long m) {
+    double complex *tabla = malloc((m / 2 > 0 ? m / 2 : 1) * sizeof(double complex));
+    #pragma omp parallel for
+    for (long k = 0; k < m / 2; k++) {
+        tabla[k] = cexp(-2.0 * M_PI * I * (double)k / (double)m);
+    }
+    return tabla;
+}
+
+/* FFT radix-2 iterativa en sitio de longitud m. Si 'paralelo' es distinto de cero, la
+ * permutación y cada etapa de mariposas se reparten entre los hilos del equipo. */
+static void fft_radix2(double complex *x, long m, const double complex *giros, int paralelo) {
+    int bits = 0;
+    while ((1L << bits) < m) {
+        bits++;
+    }
+
+    #pragma omp parallel for if(paralelo)
+    for (long i = 0; i < m; i++) {
+        long j = 0;
+        for (int b = 0; b < bits; b++) {
+            j |= ((i >> b) & 1L) << (bits - 1 - b);
+        }
+        if (i < j) {
+            double complex t = x[i];
+            x[i] = x[j];
+            x[j] = t;
+        }
+    }
+
+    for (long longitud = 2; longitud <= m; longitud <<= 1) {
+        long mitad = longitud / 2;
+        long paso = m / longitud;
+        #pragma omp parallel for if(paralelo)
+        for (long t = 0; t < m / 2; t++) {
+            long grupo = t / mitad;
+            long k = t % mitad;
+            long i = grupo * longitud + k;
+            double complex u = x[i];
+            double complex v = x[i + mitad] * giros[k * paso];
+            x[i] = u + v;
+            x[i + mitad] = u - v;
+        }
+    }
+}
+
+/* FFT distribuida de cuatro pasos. Cada proceso entra con sus n/P muestras consecutivas y
+ * sale con los coeficientes X[k2 + n2*k1] para k2 en su bloque; se copian a 'salida'
+ * (de longitud K, en cero donde el proceso no es dueño del coeficiente). */
+static void fft_distribuida(double complex *local, long n, long K, int rank, int size,
+                            double complex *salida) {
+    int bits = 0;
+    while ((1L << bits) < n) {
+        bits++;
+    }
+    long n1 = 1L << (bits / 2);
+    long n2 = n / n1;
+    long filas = n2 / size;     // Filas j2 por proceso al inicio
+    long columnas = n1 / size;  // Columnas j1 por proceso tras la primera transposición
+    long bloque_k2 = n2 / size; // Índices k2 por proceso tras la segunda transposición
+    long bloque = n / ((long)size * size);
+
+    double complex *envio = malloc((n / size) * sizeof(double complex));
+    double complex *recepcion = malloc((n / size) * sizeof(double complex));
+    double complex *giros_n1 = crear_tabla_giros(n1);
+    double complex *giros_n2 = crear_tabla_giros(n2);
+
+    /* Primera transposición: filas j2 -> columnas j1 */
+    #pragma omp parallel for collapse(2)
+    for (int q = 0; q < size; q++) {
+        for (long f = 0; f < filas; f++) {
+            for (long c = 0; c < columnas; c++) {
+                envio[q * bloque + f * columnas + c] = local[f * n1 + q * columnas + c];
+            }
+        }
+    }
+    MPI_Alltoall(envio, (int)bloque, MPI_C_DOUBLE_COMPLEX,
+                 recepcion, (int)bloque, MPI_C_DOUBLE_COMPLEX, MPI_COMM_WORLD);
+    #pragma omp parallel for collapse(2)
+    for (int s = 0; s < size; s++) {
+        for (long f = 0; f < filas; f++) {
+            for (long c = 0; c < columnas; c++) {
+                local[c * n2 + s * filas + f] = recepcion[s * bloque + f * columnas + c];
+            }
+        }
+    }
+
+    /* FFT de longitud n2 por columna y multiplicación por w_n^(j1*k2) */
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long c = 0; c < columnas; c++) {
+        double complex *columna = local + c * n2;
+        long j1 = rank * columnas + c;
+        fft_radix2(columna, n2, giros_n2, 0);
+        for (long k2 = 0; k2 < n2; k2++) {
+            long exponente = (j1 * k2) % n;
+            columna[k2] *= cexp(-2.0 * M_PI * I * (double)exponente / (double)n);
+        }
+    }
+
+    /* Segunda transposición: columnas j1 -> bloques de k2 */
+    #pragma omp parallel for collapse(2)
+    for (int q = 0; q < size; q++) {
+        for (long c = 0; c < columnas; c++) {
+            for (long k = 0; k < bloque_k2; k++) {
+                envio[q * bloque + c * bloque_k2 + k] = local[c * n2 + q * bloque_k2 + k];
+            }
+        }
+    }
+    MPI_Alltoall(envio, (int)bloque, MPI_C_DOUBLE_COMPLEX,
+                 recepcion, (int)bloque, MPI_C_DOUBLE_COMPLEX, MPI_COMM_WORLD);
+    #pragma omp parallel for collapse(2)
+    for (int s = 0; s < size; s++) {
+        for (long c = 0; c < columnas; c++) {
+            for (long k = 0; k < bloque_k2; k++) {
+                local[k * n1 + s * columnas + c] = recepcion[s * bloque + c * bloque_k2 + k];
+            }
+        }
+    }
+
+    /* FFT de longitud n1 por cada k2 local */
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long k = 0; k < bloque_k2; k++) {
+        fft_radix2(local + k * n1, n1, giros_n1, 0);
+    }
+
+    /* Coeficientes propios: k = k2 + n2*k1 con k2 en el bloque de este proceso */
+    for (long k = 0; k < K; k++) {
+        long k2 = k % n2;
+        long k1 = k / n2;
+        salida[k] = (k2 / bloque_k2 == rank) ? local[(k2 - rank * bloque_k2) * n1 + k1] : 0.0;
+    }
+
+    free(envio);
+    free(recepcion);
+    free(giros_n1);
+    free(giros_n2);
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+    FourierParams params;
+    double start_time, end_time;
+
+    /* Inicialización de MPI */
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    /* Proceso raíz procesa los argumentos de línea de comandos */
+    if (rank == 0) {
+        if (argc != 6 && argc != 7) {
+            fprintf(stderr, "Uso: %s <a> <b> <n> <K> <numero_de_hilos> [archivo_salida]\n", argv[0]);
+            fprintf(stderr, "Donde:\n");
+            fprintf(stderr, "    <a> : Límite inferior de integración (double)\n");
+            fprintf(stderr, "    <b> : Límite superior de integración (double)\n");
+            fprintf(stderr, "    <n> : Número de subintervalos (potencia de dos)\n");
+            fprintf(stderr, "    <K> : Número de coeficientes a calcular (1 <= K <= n/2)\n");
+            fprintf(stderr, "    <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)\n");
+            fprintf(stderr, "    [archivo_salida] : Archivo donde escribir los coeficientes\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        params.a = atof(argv[1]);
+        params.b = atof(argv[2]);
+        params.n = atol(argv[3]);
+        params.K = atol(argv[4]);
+        params.hilos = atoi(argv[5]);
+
+        if (!es_potencia_de_dos(params.n) || params.n < 4) {
+            fprintf(stderr, "El número de subintervalos debe ser una potencia de dos (>= 4).\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (params.K < 1 || params.K > params.n / 2 || params.hilos <= 0) {
+            fprintf(stderr, "K debe estar entre 1 y n/2 y el número de hilos debe ser positivo.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        int bits = 0;
+        while ((1L << bits) < params.n) {
+            bits++;
+        }
+        long n1 = 1L << (bits / 2);
+        if (size > 1 && (!es_potencia_de_dos(size) || n1 % size != 0)) {
+            fprintf(stderr, "El número de procesos debe ser potencia de dos y no mayor que %ld.\n", n1);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        printf("Calculando %ld coeficientes de Fourier de sin(x) en [%.6f, %.6f] con %ld subintervalos "
+               "(%d procesos, %d hilos).\n", params.K, params.a, params.b, params.n, size, params.hilos);
+    }
+
+    /* Difusión de los parámetros a todos los procesos */
+    MPI_Bcast(&params, sizeof(FourierParams), MPI_BYTE, 0, MPI_COMM_WORLD);
+    omp_set_num_threads(params.hilos);
+
+    long n = params.n;
+    long K = params.K;
+    long locales = n / size;
+    long inicio = rank * locales;
+    double h = (params.b - params.a) / n;
+    double complex *muestras = malloc(locales * sizeof(double complex));
+    double complex *propios = malloc(K * sizeof(double complex));
+    double complex *coeficientes = malloc(K * sizeof(double complex));
+
+    /* Sincronización antes del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    start_time = MPI_Wtime();
+
+    /* Muestreo único de f en la malla del punto medio */
+    #pragma omp parallel for
+    for (long j = 0; j < locales; j++) {
+        muestras[j] = funcion(params.a + (inicio + j + 0.5) * h);
+    }
+
+    if (size == 1) {
+        double complex *giros = crear_tabla_giros(n);
+        fft_radix2(muestras, n, giros, 1);
+        for (long k = 0; k < K; k++) {
+            propios[k] = muestras[k];
+        }
+        free(giros);
+    } else {
+        fft_distribuida(muestras, n, K, rank, size, propios);
+    }
+
+    MPI_Reduce(propios, coeficientes, (int)K, MPI_C_DOUBLE_COMPLEX, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    /* Fase de cada coeficiente y corrección de los extremos */
+    if (rank == 0) {
+        double fa = funcion(params.a), fb = funcion(params.b);
+        double f0 = funcion(params.a + 0.5 * h), f1 = funcion(params.a + 1.5 * h);
+        double fn1 = funcion(params.b - 0.5 * h), fn2 = funcion(params.b - 1.5 * h);
+        double dfa = (-8.0 * fa + 9.0 * f0 - f1) / (3.0 * h);
+        double dfb = (8.0 * fb - 9.0 * fn1 + fn2) / (3.0 * h);
+
+        for (long k = 0; k < K; k++) {
+            double w = 2.0 * M_PI * k / (params.b - params.a);
+            double complex gpa = (dfa - I * w * fa) * cexp(-I * w * params.a);
+            double complex gpb = (dfb - I * w * fb) * cexp(-I * w * params.b);
+            coeficientes[k] = h * cexp(-I * w * (params.a + 0.5 * h)) * coeficientes[k]
+                              + h * h / 24.0 * (gpb - gpa);
+        }
+    }
+
+    /* Sincronización después del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    end_time = MPI_Wtime();
+
+    /* Proceso raíz muestra el resultado y el tiempo de ejecución */
+    if (rank == 0) {
+        for (long k = 0; k < K && k < COEFICIENTES_EN_PANTALLA; k++) {
+            printf("c[%ld] = %.12f %+.12f i\n", k, creal(coeficientes[k]), cimag(coeficientes[k]));
+        }
+        if (K > COEFICIENTES_EN_PANTALLA) {
+            printf("... (%ld coeficientes en total)\n", K);
+        }
+        printf("Tiempo de ejecución: %.6f segundos.\n", end_time - start_time);
+
+        if (argc == 7) {
+            FILE *salida = fopen(argv[6], "w");
+            if (salida == NULL) {
+                fprintf(stderr, "No se pudo abrir %s para escritura.\n", argv[6]);
+            } else {
+                for (long k = 0; k < K; k++) {
+                    fprintf(salida, "%ld %.17g %.17g\n", k, creal(coeficientes[k]), cimag(coeficientes[k]));
+                }
+                fclose(salida);
+            }
+        }
+    }
+
+    free(muestras);
+    free(propios);
+    free(coeficientes);
+
+    /* Finalización de MPI */
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,414 @@
+/*
+ * Programa: mpi_malla_no_uniforme.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Este programa aproxima la integral definida de una función sobre una malla no uniforme
+ * (por ejemplo, una malla graduada producida por una simulación) de manera paralela con
+ * Open MPI y OpenMP. Los nodos se leen de un archivo y se guardan en forma SoA: un arreglo
+ * con el extremo izquierdo de cada celda y otro con su ancho. En cada celda se aplica la
+ * Regla del Punto Medio o una regla de Gauss-Legendre de 2 o 3 puntos; el bucle interno
+ * recorre los dos arreglos con accesos contiguos para que el compilador lo vectorice.
+ *
+ * Las celdas se reparten entre procesos, y dentro de cada proceso entre hilos, ya sea por
+ * cantidad de celdas o por costo estimado. El costo de cada celda se toma de la segunda
+ * columna del archivo si existe; si no, el proceso raíz lo estima midiendo el tiempo de
+ * evaluación de la función en una muestra de celdas de cada tramo de la malla.
+ *
+ * Formato del archivo de malla:
+ *     Un nodo por línea, en orden creciente. Una segunda columna opcional da el costo
+ *     relativo de la celda que empieza en ese nodo (se ignora en el último nodo).
+ *
+ * Compilación:
+ *     mpicc -fopenmp -O2 -o mpi_malla_no_uniforme mpi_malla_no_uniforme.c -lm
+ *
+ * Uso:
+ *     mpirun -np <número_de_procesos> ./mpi_malla_no_uniforme <archivo_malla> <regla> <particion> <numero_de_hilos>
+ *     Donde:
+ *         <archivo_malla> : Archivo con los nodos de la malla
+ *         <regla> : punto_medio | gauss2 | gauss3
+ *         <particion> : cantidad | costo
+ *         <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)
+ *
+ * Ejemplo:
+ *     awk 'BEGIN{n=1000000; for(i=0;i<=n;i++) printf "%.17g\n", 3.141592653589793*(i/n)^2}' > malla.txt
+ *     mpirun -np 4 ./mpi_malla_no_uniforme malla.txt gauss2 costo 2
+ */
+
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define GRUPOS_ESTIMACION 256
+#define CELDAS_POR_GRUPO_ESTIMACION 32
+
+/* Definición de la función a integrar */
+#pragma omp declare simd
+double funcion(double x) {
+    return sin(x); // A quien lea esto, puede cambiar la función a integrar por cualquier otra función que desee.
+}
+
+typedef enum { REGLA_PUNTO_MEDIO, REGLA_GAUSS2, REGLA_GAUSS3 } Regla;
+
+/* Malla en forma SoA: la celda i es [izquierdos[i], izquierdos[i] + anchos[i]] */
+typedef struct {
+    long celdas;
+    double *izquierdos;
+    double *anchos;
+    double *costos;  // Costo relativo por celda, o NULL
+} Malla;
+
+/* Aplica la regla a las celdas [inicio, fin) de la malla */
+double calcular_suma_malla(const double *izquierdos, const double *anchos,
+                           long inicio, long fin, Regla regla) {
+    double suma = 0.0;
+
+    switch (regla) {
+    case REGLA_PUNTO_MEDIO:
+        #pragma omp simd reduction(+:suma)
+        for (long i = inicio; i < fin; i++) {
+            suma += funcion(izquierdos[i] + 0.5 * anchos[i]) * anchos[i];
+        }
+        break;
+    case REGLA_GAUSS2: {
+        const double xi = 0.5 / sqrt(3.0);
+        #pragma omp simd reduction(+:suma)
+        for (long i = inicio; i < fin; i++) {
+            double centro = izquierdos[i] + 0.5 * anchos[i];
+            double d = xi * anchos[i];
+            suma += 0.5 * anchos[i] * (funcion(centro - d) + funcion(centro + d));
+        }
+        break;
+    }
+    case REGLA_GAUSS3: {
+        const double xi = 0.5 * sqrt(0.6);
+        #pragma omp simd reduction(+:suma)
+        for (long i = inicio; i < fin; i++) {
+            double centro = izquierdos[i] + 0.5 * anchos[i];
+            double d = xi * anchos[i];
+            suma += anchos[i] * (5.0 * funcion(centro - d) + 8.0 * funcion(centro)
+                                 + 5.0 * funcion(centro + d)) / 18.0;
+        }
+        break;
+    }
+    }
+
+    return suma;
+}
+
+/* Divide [0, celdas) en 'partes' tramos contiguos de igual cantidad o de igual costo.
+ * El tramo p es [limites[p], limites[p + 1]). */
+void particionar(const double *costos, long celdas, int partes, long *limites) {
+    limites[0] = 0;
+    limites[partes] = celdas;
+
+    if (costos == NULL) {
+        for (int p = 1; p < partes; p++) {
+            limites[p] = celdas * p / partes;
+        }
+        return;
+    }
+
+    double total = 0.0;
+    for (long i = 0; i < celdas; i++) {
+        total += costos[i];
+    }
+
+    double acumulado = 0.0;
+    long i = 0;
+    for (int p = 1; p < partes; p++) {
+        double objetivo = total * p / partes;
+        while (i < celdas && acumulado + costos[i] <= objetivo) {
+            acumulado += costos[i];
+            i++;
+        }
+        limites[p] = i;
+    }
+}
+
+/* Estima el costo por celda midiendo la evaluación de la regla en una muestra de celdas
+ * de cada grupo; todas las celdas de un grupo reciben el costo medio medido. */
+void estimar_costos(Malla *malla, Regla regla) {
+    long celdas_por_grupo = (malla->celdas + GRUPOS_ESTIMACION - 1) / GRUPOS_ESTIMACION;
+    volatile double sumidero = 0.0;
+
+    for (long g = 0; g * celdas_por_grupo < malla->celdas; g++) {
+        long inicio = g * celdas_por_grupo;
+        long fin = inicio + celdas_por_grupo < malla->celdas ? inicio + celdas_por_grupo : malla->celdas;
+        long fin_muestra = inicio + CELDAS_POR_GRUPO_ESTIMACION < fin ? inicio + CELDAS_POR_GRUPO_ESTIMACION : fin;
+
+        double t0 = MPI_Wtime();
+        sumidero += calcular_suma_malla(malla->izquierdos, malla->anchos, inicio, fin_muestra, regla);
+        double costo = (MPI_Wtime() - t0) / (fin_muestra - inicio);
+
+        for (long i = inicio; i < fin; i++) {
+            malla->costos[i] = costo;
+        }
+    }
+    (void)sumidero;
+}
+
+/* Lee los nodos del archivo y construye la malla SoA. Devuelve 0 si hubo un error. */
+int leer_malla(const char *ruta, Malla *malla) {
+    FILE *archivo = fopen(ruta, "r");
+    if (archivo == NULL) {
+        fprintf(stderr, "No se pudo abrir el archivo de malla %s.\n", ruta);
+        return 0;
+    }
+
+    long capacidad = 1024, nodos = 0, numero_linea = 0;
+    int con_costos = 0;
+    double *x = malloc(capacidad * sizeof(double));
+    double *c = malloc(capacidad * sizeof(double));
+    char linea[256];
+    if (x == NULL || c == NULL) {
+        fprintf(stderr, "No hay memoria para los nodos de la malla %s.\n", ruta);
+        fclose(archivo);
+        free(x);
+        free(c);
+        return 0;
+    }
+
+    while (fgets(linea, sizeof(linea), archivo) != NULL) {
+        char *resto, *fin_costo;
+        numero_linea++;
+        double nodo = strtod(linea, &resto);
+        if (resto == linea) {
+            continue;
+        }
+        double costo = strtod(resto, &fin_costo);
+        if (fin_costo != resto) {
+            con_costos = 1;
+        } else {
+            costo = 1.0;
+        }
+        if (nodos > 0 && nodo <= x[nodos - 1]) {
+            fprintf(stderr, "Los nodos de la malla deben ser estrictamente crecientes (línea %ld).\n", numero_linea);
+            fclose(archivo);
+            free(x);
+            free(c);
+            return 0;
+        }
+        if (nodos == capacidad) {
+            capacidad *= 2;
+            double *nuevos_x = realloc(x, capacidad * sizeof(double));
+            x = (nuevos_x != NULL) ? nuevos_x : x;
+            double *nuevos_c = realloc(c, capacidad * sizeof(double));
+            c = (nuevos_c != NULL) ? nuevos_c : c;
+            if (nuevos_x == NULL || nuevos_c == NULL) {
+                fprintf(stderr, "No hay memoria para los nodos de la malla %s.\n", ruta);
+                fclose(archivo);
+                free(x);
+                free(c);
+                return 0;
+            }
+        }
+        x[nodos] = nodo;
+        c[nodos] = costo;
+        nodos++;
+    }
+    fclose(archivo);
+
+    if (nodos < 2) {
+        fprintf(stderr, "La malla debe tener al menos dos nodos.\n");
+        free(x);
+        free(c);
+        return 0;
+    }
+
+    malla->celdas = nodos - 1;
+    malla->izquierdos = x;
+    malla->anchos = malloc(malla->celdas * sizeof(double));
+    if (malla->anchos == NULL) {
+        fprintf(stderr, "No hay memoria para las celdas de la malla %s.\n", ruta);
+        free(x);
+        free(c);
+        return 0;
+    }
+    for (long i = 0; i < malla->celdas; i++) {
+        malla->anchos[i] = x[i + 1] - x[i];
+    }
+    if (con_costos) {
+        malla->costos = c;
+    } else {
+        malla->costos = NULL;
+        free(c);
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+    int parametros[3];  // regla, partición por costo, hilos
+    Malla malla = {0, NULL, NULL, NULL};
+    double suma_local = 0.0, suma_total = 0.0;
+    double start_time, end_time;
+
+    /* Inicialización de MPI */
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    long *limites = malloc((size + 1) * sizeof(long));
+    if (limites == NULL) {
+        fprintf(stderr, "No hay memoria para la partición entre procesos.\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    /* Proceso raíz procesa los argumentos y lee la malla */
+    if (rank == 0) {
+        if (argc != 5) {
+            fprintf(stderr, "Uso: %s <archivo_malla> <regla> <particion> <numero_de_hilos>\n", argv[0]);
+            fprintf(stderr, "Donde:\n");
+            fprintf(stderr, "    <archivo_malla> : Archivo con los nodos de la malla\n");
+            fprintf(stderr, "    <regla> : punto_medio | gauss2 | gauss3\n");
+            fprintf(stderr, "    <particion> : cantidad | costo\n");
+            fprintf(stderr, "    <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        if (strcmp(argv[2], "punto_medio") == 0) {
+            parametros[0] = REGLA_PUNTO_MEDIO;
+        } else if (strcmp(argv[2], "gauss2") == 0) {
+            parametros[0] = REGLA_GAUSS2;
+        } else if (strcmp(argv[2], "gauss3") == 0) {
+            parametros[0] = REGLA_GAUSS3;
+        } else {
+            fprintf(stderr, "La regla debe ser punto_medio, gauss2 o gauss3.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        if (strcmp(argv[3], "cantidad") == 0) {
+            parametros[1] = 0;
+        } else if (strcmp(argv[3], "costo") == 0) {
+            parametros[1] = 1;
+        } else {
+            fprintf(stderr, "La partición debe ser cantidad o costo.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        parametros[2] = atoi(argv[4]);
+        if (parametros[2] <= 0) {
+            fprintf(stderr, "El número de hilos debe ser un entero positivo.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        if (!leer_malla(argv[1], &malla)) {
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        if (parametros[1] && malla.costos == NULL) {
+            malla.costos = malloc(malla.celdas * sizeof(double));
+            if (malla.costos == NULL) {
+                fprintf(stderr, "No hay memoria para los costos de la malla.\n");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            estimar_costos(&malla, (Regla)parametros[0]);
+        }
+
+        printf("Aproximando la integral de sin(x) sobre una malla de %ld celdas en [%.6f, %.6f] "
+               "con la regla %s y partición por %s.\n",
+               malla.celdas, malla.izquierdos[0], malla.izquierdos[malla.celdas], argv[2], argv[3]);
+
+        particionar(parametros[1] ? malla.costos : NULL, malla.celdas, size, limites);
+    }
+
+    /* Difusión de los parámetros y reparto de las celdas de cada proceso */
+    MPI_Bcast(parametros, 3, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(limites, size + 1, MPI_LONG, 0, MPI_COMM_WORLD);
+
+    Regla regla = (Regla)parametros[0];
+    int por_costo = parametros[1];
+    int num_hilos = parametros[2];
+    long celdas_locales = limites[rank + 1] - limites[rank];
+
+    int *cuentas = NULL, *desplazamientos = NULL;
+    if (rank == 0) {
+        cuentas = malloc(size * sizeof(int));
+        desplazamientos = malloc(size * sizeof(int));
+        if (cuentas == NULL || desplazamientos == NULL) {
+            fprintf(stderr, "No hay memoria para el reparto de las celdas.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        for (int p = 0; p < size; p++) {
+            cuentas[p] = (int)(limites[p + 1] - limites[p]);
+            desplazamientos[p] = (int)limites[p];
+        }
+    }
+
+    double *izquierdos = malloc((celdas_locales > 0 ? celdas_locales : 1) * sizeof(double));
+    double *anchos = malloc((celdas_locales > 0 ? celdas_locales : 1) * sizeof(double));
+    double *costos = por_costo ? malloc((celdas_locales > 0 ? celdas_locales : 1) * sizeof(double)) : NULL;
+    if (izquierdos == NULL || anchos == NULL || (por_costo && costos == NULL)) {
+        fprintf(stderr, "Proceso %d: no hay memoria para sus %ld celdas.\n", rank, celdas_locales);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Scatterv(malla.izquierdos, cuentas, desplazamientos, MPI_DOUBLE,
+                 izquierdos, (int)celdas_locales, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Scatterv(malla.anchos, cuentas, desplazamientos, MPI_DOUBLE,
+                 anchos, (int)celdas_locales, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (por_costo) {
+        MPI_Scatterv(malla.costos, cuentas, desplazamientos, MPI_DOUBLE,
+                     costos, (int)celdas_locales, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    }
+
+    /* Partición local entre hilos con el mismo criterio */
+    long *limites_hilos = malloc((num_hilos + 1) * sizeof(long));
+    if (limites_hilos == NULL) {
+        fprintf(stderr, "Proceso %d: no hay memoria para la partición entre %d hilos.\n", rank, num_hilos);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    particionar(costos, celdas_locales, num_hilos, limites_hilos);
+
+    /* Sincronización antes del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    start_time = MPI_Wtime();
+
+    /* Cálculo de la suma local: un tramo de celdas por iteración, así que se suman todos aunque
+     * el equipo tenga menos hilos que num_hilos (OMP_THREAD_LIMIT, OMP_DYNAMIC) */
+    #pragma omp parallel for num_threads(num_hilos) schedule(static, 1) reduction(+:suma_local)
+    for (int tramo = 0; tramo < num_hilos; tramo++) {
+        suma_local += calcular_suma_malla(izquierdos, anchos, limites_hilos[tramo],
+                                          limites_hilos[tramo + 1], regla);
+    }
+    double tiempo_local = MPI_Wtime() - start_time;
+
+    /* Reducción de las sumas locales para obtener la suma total */
+    MPI_Reduce(&suma_local, &suma_total, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    /* Sincronización después del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    end_time = MPI_Wtime();
+
+    double tiempo_max, tiempo_min;
+    MPI_Reduce(&tiempo_local, &tiempo_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&tiempo_local, &tiempo_min, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+
+    /* Proceso raíz muestra el resultado y el tiempo de ejecución */
+    if (rank == 0) {
+        printf("Resultado de la integral aproximada: %.12f\n", suma_total);
+        printf("Tiempo de ejecución: %.6f segundos.\n", end_time - start_time);
+        printf("Tiempo de cálculo por proceso: mínimo %.6f, máximo %.6f segundos.\n", tiempo_min, tiempo_max);
+    }
+
+    free(limites_hilos);
+    free(izquierdos);
+    free(anchos);
+    free(costos);
+    free(cuentas);
+    free(desplazamientos);
+    free(limites);
+    free(malla.izquierdos);
+    free(malla.anchos);
+    free(malla.costos);
+
+    /* Finalización de MPI */
+    MPI_Finalize();
+
+    return 0;
+}
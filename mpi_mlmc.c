@@ -0,0 +1,424 @@
+/*
+ * Programa: mpi_mlmc.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Este programa aproxima con Monte Carlo multinivel (Giles, 2008) la integral sobre [a, b]^dim
+ * de una función Q(ω) que a su vez se calcula con un solucionador interno de resolución
+ * ajustable: aquí Q(ω) = ∫_0^1 cos(t·(ω_1 + ... + ω_dim)) dt, aproximada por la Regla del Punto
+ * Medio con M_l = MALLA_BASE·2^l subintervalos en el nivel l. Como
+ *     E[P_L] = E[P_0] + Σ_{l=1..L} E[P_l - P_{l-1}],
+ * cada corrección se estima con muestras propias, evaluando P_l y P_{l-1} en el mismo ω; su
+ * varianza decrece con l y la mayoría de las muestras caen en los niveles baratos.
+ *
+ * En cada iteración, a partir de la varianza V_l y del costo por muestra C_l medidos hasta el
+ * momento, se calcula el número óptimo de muestras
+ *     N_l = ⌈2 ε⁻² √(V_l / C_l) Σ_k √(V_k C_k)⌉
+ * y se ejecutan las que faltan. Cuando no faltan muestras se estima el sesgo con la última
+ * corrección (convergencia débil de orden ORDEN_DEBIL) y, si supera ε/√2, se agrega un nivel.
+ *
+ * Los niveles con muestras pendientes se ejecutan al mismo tiempo en subcomunicadores
+ * (MPI_Comm_split): se agrupan por LPT según su trabajo estimado N_l·C_l y cada grupo recibe
+ * un número de procesos proporcional a su trabajo. Dentro de un grupo, las muestras de cada
+ * nivel se reparten en tramos contiguos; la muestra i del nivel l usa la posición i del flujo
+ * de Philox del nivel (montecarlo.h), así que no depende del reparto. Las estadísticas de
+ * todos los niveles se combinan con una MPI_Allreduce por iteración y el proceso raíz decide
+ * el plan de la siguiente.
+ *
+ * Compilación:
+ *     mpicc -O2 -o mpi_mlmc mpi_mlmc.c -lm
+ *
+ * Uso:
+ *     mpirun -np <número_de_procesos> ./mpi_mlmc <a> <b> <dim> <epsilon> <muestras_iniciales> <nivel_maximo> [semilla]
+ *     Donde:
+ *         <a> : Límite inferior de integración en cada dimensión (double)
+ *         <b> : Límite superior de integración en cada dimensión (double)
+ *         <dim> : Dimensión del parámetro ω (1 a DIM_MAX_MC)
+ *         <epsilon> : Error cuadrático medio objetivo (double positivo)
+ *         <muestras_iniciales> : Muestras de cada nivel nuevo (entero, al menos 2)
+ *         <nivel_maximo> : Nivel más fino permitido (2 a NIVEL_MAX)
+ *         [semilla] : Semilla de Philox (entero, opcional)
+ *
+ * Ejemplo:
+ *     mpirun -np 4 ./mpi_mlmc 0 3.141592653589793 1 1e-4 1000 20
+ */
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "montecarlo.h"
+
+#define NIVEL_MAX 30
+#define MALLA_BASE 4          // Subintervalos del solucionador interno en el nivel 0
+#define ORDEN_DEBIL 2.0       // |E[P_l - P]| = O(M_l^-ORDEN_DEBIL) para el punto medio
+#define SEMILLA_MLMC 12345
+
+/* Integrando interno g(t, ω); A quien lea esto, puede cambiarlo junto con el solucionador */
+double funcion(double t, const double *omega, int dim) {
+    double suma = 0.0;
+    for (int d = 0; d < dim; d++) {
+        suma += omega[d];
+    }
+    return cos(t * suma);
+}
+
+/* Solucionador interno: Q(ω) ≈ ∫_0^1 g(t, ω) dt con la Regla del Punto Medio y m subintervalos */
+double solucionador(const double *omega, int dim, long m) {
+    double delta_t = 1.0 / m;
+    double suma = 0.0;
+    for (long j = 0; j < m; j++) {
+        suma += funcion((j + 0.5) * delta_t, omega, dim) * delta_t;
+    }
+    return suma;
+}
+
+/* Estructura para almacenar los parámetros de la integral */
+typedef struct {
+    double a;               // Límite inferior en cada dimensión
+    double b;               // Límite superior en cada dimensión
+    int dim;                // Dimensión de ω
+    double epsilon;         // Error cuadrático medio objetivo
+    long muestras_iniciales;
+    int nivel_maximo;
+    uint64_t semilla;
+} MLMCParams;
+
+/* Estado acumulado de un nivel: corrección Y_l = P_l - P_{l-1}, valor fino P_l y tiempo */
+typedef struct {
+    EstadisticaMC correccion;
+    EstadisticaMC fino;
+} EstadisticaNivel;
+
+/* Plan de una iteración, decidido por el proceso raíz */
+typedef struct {
+    int niveles;                 // Niveles activos: 0..niveles-1
+    int terminado;
+    long pendientes[NIVEL_MAX + 1];  // Muestras por ejecutar en cada nivel
+} PlanMLMC;
+
+/* Operación de MPI que combina estadísticas de Welford (tipo: tres doubles contiguos) */
+void combinar_estadisticas_mpi(void *entrada, void *acumulado, int *cantidad, MPI_Datatype *tipo) {
+    (void)tipo;
+    EstadisticaMC *in = entrada, *acc = acumulado;
+    for (int i = 0; i < *cantidad; i++) {
+        EstadisticaMC combinada = in[i];
+        estadistica_combinar(&combinada, &acc[i]);
+        acc[i] = combinada;
+    }
+}
+
+/* Evalúa las muestras [inicio, fin) del nivel l y las agrega a 'e' */
+void muestrear_nivel(const MLMCParams *p, int l, long inicio, long fin, EstadisticaNivel *e) {
+    double omega[DIM_MAX_MC + 1];
+    int por_muestra = p->dim + (p->dim & 1);
+    long m = (long)MALLA_BASE << l;
+    double volumen = pow(p->b - p->a, p->dim);
+
+    for (long i = inicio; i < fin; i++) {
+        philox_uniformes(p->semilla, (uint64_t)l, (uint64_t)i * por_muestra, por_muestra, omega);
+        for (int d = 0; d < p->dim; d++) {
+            omega[d] = p->a + (p->b - p->a) * omega[d];
+        }
+        double fino = volumen * solucionador(omega, p->dim, m);
+        double grueso = l > 0 ? volumen * solucionador(omega, p->dim, m / 2) : 0.0;
+        estadistica_agregar(&e->correccion, fino - grueso);
+        estadistica_agregar(&e->fino, fino);
+    }
+}
+
+/* Reparte 'size' procesos entre grupos en proporción a su trabajo (al menos uno por grupo) */
+void repartir_procesos(const double *trabajo, int grupos, int size, int *procesos) {
+    double total = 0.0;
+    int asignados = 0;
+    for (int g = 0; g < grupos; g++) {
+        total += trabajo[g];
+    }
+    for (int g = 0; g < grupos; g++) {
+        double cuota = total > 0.0 ? (size - grupos) * trabajo[g] / total : 0.0;
+        procesos[g] = 1 + (int)cuota;
+        asignados += procesos[g];
+    }
+    while (asignados < size) {
+        int mejor = 0;
+        double mayor_carga = -1.0;
+        for (int g = 0; g < grupos; g++) {
+            if (trabajo[g] / procesos[g] > mayor_carga) {
+                mayor_carga = trabajo[g] / procesos[g];
+                mejor = g;
+            }
+        }
+        procesos[mejor]++;
+        asignados++;
+    }
+}
+
+/* Costo por muestra del nivel l: el medido o, si aún no hay muestras, el del nivel anterior
+ * escalado por la resolución */
+double costo_nivel(const EstadisticaNivel *estadisticas, const double *tiempos, int l) {
+    if (estadisticas[l].correccion.n > 0.0 && tiempos[l] > 0.0) {
+        return tiempos[l] / estadisticas[l].correccion.n;
+    }
+    if (l > 0) {
+        return 2.0 * costo_nivel(estadisticas, tiempos, l - 1);
+    }
+    return 1e-6;
+}
+
+/* Ejecuta las muestras pendientes del plan con los niveles agrupados en subcomunicadores.
+ * Acumula estadísticas y tiempos (en segundos de proceso) de todos los procesos. */
+void ejecutar_plan(const MLMCParams *p, const PlanMLMC *plan, EstadisticaNivel *estadisticas, double *tiempos,
+                   int rank, int size, MPI_Datatype tipo_estadistica, MPI_Op op_combinar) {
+    int activos[NIVEL_MAX + 1], cantidad_activos = 0;
+    double trabajo_nivel[NIVEL_MAX + 1];
+
+    for (int l = 0; l < plan->niveles; l++) {
+        if (plan->pendientes[l] > 0) {
+            trabajo_nivel[l] = plan->pendientes[l] * costo_nivel(estadisticas, tiempos, l);
+            activos[cantidad_activos++] = l;
+        }
+    }
+
+    /* LPT: los niveles de mayor trabajo primero, cada uno al grupo menos cargado */
+    for (int i = 1; i < cantidad_activos; i++) {
+        for (int j = i; j > 0 && trabajo_nivel[activos[j]] > trabajo_nivel[activos[j - 1]]; j--) {
+            int t = activos[j];
+            activos[j] = activos[j - 1];
+            activos[j - 1] = t;
+        }
+    }
+    int grupos = cantidad_activos < size ? cantidad_activos : size;
+    int grupo_nivel[NIVEL_MAX + 1];
+    double trabajo_grupo[NIVEL_MAX + 1] = {0.0};
+    for (int i = 0; i < cantidad_activos; i++) {
+        int menor = 0;
+        for (int g = 1; g < grupos; g++) {
+            if (trabajo_grupo[g] < trabajo_grupo[menor]) {
+                menor = g;
+            }
+        }
+        grupo_nivel[activos[i]] = menor;
+        trabajo_grupo[menor] += trabajo_nivel[activos[i]];
+    }
+
+    int procesos[NIVEL_MAX + 1];
+    repartir_procesos(trabajo_grupo, grupos, size, procesos);
+    int color = 0, primero_grupo = 0;
+    while (rank >= primero_grupo + procesos[color]) {
+        primero_grupo += procesos[color];
+        color++;
+    }
+
+    if (rank == 0) {
+        for (int i = 0; i < cantidad_activos; i++) {
+            int l = activos[i];
+            printf("    nivel %2d: %10ld muestras en el grupo %d (%d procesos)\n",
+                   l, plan->pendientes[l], grupo_nivel[l], procesos[grupo_nivel[l]]);
+        }
+    }
+
+    MPI_Comm comm_grupo;
+    int rank_grupo, size_grupo;
+    MPI_Comm_split(MPI_COMM_WORLD, color, rank, &comm_grupo);
+    MPI_Comm_rank(comm_grupo, &rank_grupo);
+    MPI_Comm_size(comm_grupo, &size_grupo);
+
+    /* Cada grupo ejecuta sus niveles; las muestras nuevas del nivel l empiezan en las ya hechas */
+    EstadisticaNivel locales[NIVEL_MAX + 1];
+    double tiempos_locales[NIVEL_MAX + 1] = {0.0};
+    memset(locales, 0, sizeof(locales));
+    for (int l = 0; l < plan->niveles; l++) {
+        if (plan->pendientes[l] == 0 || grupo_nivel[l] != color) {
+            continue;
+        }
+        long hechas = (long)estadisticas[l].correccion.n;
+        long inicio = hechas + plan->pendientes[l] * rank_grupo / size_grupo;
+        long fin = hechas + plan->pendientes[l] * (rank_grupo + 1) / size_grupo;
+        double t0 = MPI_Wtime();
+        muestrear_nivel(p, l, inicio, fin, &locales[l]);
+        tiempos_locales[l] = MPI_Wtime() - t0;
+    }
+    MPI_Comm_free(&comm_grupo);
+
+    /* Una reducción para las estadísticas (corrección y valor fino) y otra para los tiempos */
+    EstadisticaNivel nuevas[NIVEL_MAX + 1];
+    double tiempos_nuevos[NIVEL_MAX + 1];
+    MPI_Allreduce(locales, nuevas, 2 * plan->niveles, tipo_estadistica, op_combinar, MPI_COMM_WORLD);
+    MPI_Allreduce(tiempos_locales, tiempos_nuevos, plan->niveles, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    for (int l = 0; l < plan->niveles; l++) {
+        estadistica_combinar(&estadisticas[l].correccion, &nuevas[l].correccion);
+        estadistica_combinar(&estadisticas[l].fino, &nuevas[l].fino);
+        tiempos[l] += tiempos_nuevos[l];
+    }
+}
+
+/* Varianza muestral de un nivel */
+double varianza(const EstadisticaMC *e) {
+    return e->n > 1.0 ? e->m2 / (e->n - 1.0) : 0.0;
+}
+
+/* Decide las muestras pendientes de la siguiente iteración (solo el proceso raíz) */
+void planificar(const MLMCParams *p, const EstadisticaNivel *estadisticas, const double *tiempos, PlanMLMC *plan) {
+    double suma = 0.0;
+    long total_pendientes = 0;
+
+    for (int l = 0; l < plan->niveles; l++) {
+        suma += sqrt(varianza(&estadisticas[l].correccion) * costo_nivel(estadisticas, tiempos, l));
+    }
+    for (int l = 0; l < plan->niveles; l++) {
+        double v = varianza(&estadisticas[l].correccion);
+        double c = costo_nivel(estadisticas, tiempos, l);
+        long optimo = (long)ceil(2.0 / (p->epsilon * p->epsilon) * sqrt(v / c) * suma);
+        long hechas = (long)estadisticas[l].correccion.n;
+        plan->pendientes[l] = optimo > hechas ? optimo - hechas : 0;
+        total_pendientes += plan->pendientes[l];
+    }
+    if (total_pendientes > 0) {
+        return;
+    }
+
+    /* Sesgo estimado con las dos últimas correcciones, escaladas a la última */
+    int L = plan->niveles - 1;
+    double razon = pow(2.0, ORDEN_DEBIL);
+    double ultima = fabs(estadisticas[L].correccion.media);
+    double penultima = fabs(estadisticas[L - 1].correccion.media) / razon;
+    double sesgo = (ultima > penultima ? ultima : penultima) / (razon - 1.0);
+
+    if (sesgo <= p->epsilon / sqrt(2.0)) {
+        plan->terminado = 1;
+    } else if (plan->niveles > p->nivel_maximo) {
+        printf("  Se alcanzó el nivel máximo con sesgo estimado %.3e.\n", sesgo);
+        plan->terminado = 1;
+    } else {
+        plan->pendientes[plan->niveles] = p->muestras_iniciales;
+        plan->niveles++;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+    MLMCParams params;
+    double start_time, end_time;
+
+    /* Inicialización de MPI */
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    /* Proceso raíz procesa los argumentos de línea de comandos */
+    if (rank == 0) {
+        if (argc != 7 && argc != 8) {
+            fprintf(stderr, "Uso: %s <a> <b> <dim> <epsilon> <muestras_iniciales> <nivel_maximo> [semilla]\n", argv[0]);
+            fprintf(stderr, "Donde:\n");
+            fprintf(stderr, "    <a> : Límite inferior de integración en cada dimensión (double)\n");
+            fprintf(stderr, "    <b> : Límite superior de integración en cada dimensión (double)\n");
+            fprintf(stderr, "    <dim> : Dimensión del parámetro ω (1 a %d)\n", DIM_MAX_MC);
+            fprintf(stderr, "    <epsilon> : Error cuadrático medio objetivo (double positivo)\n");
+            fprintf(stderr, "    <muestras_iniciales> : Muestras de cada nivel nuevo (entero, al menos 2)\n");
+            fprintf(stderr, "    <nivel_maximo> : Nivel más fino permitido (2 a %d)\n", NIVEL_MAX);
+            fprintf(stderr, "    [semilla] : Semilla de Philox (entero, opcional)\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        params.a = atof(argv[1]);
+        params.b = atof(argv[2]);
+        params.dim = atoi(argv[3]);
+        params.epsilon = atof(argv[4]);
+        params.muestras_iniciales = atol(argv[5]);
+        params.nivel_maximo = atoi(argv[6]);
+        params.semilla = (argc == 8) ? strtoull(argv[7], NULL, 10) : SEMILLA_MLMC;
+
+        if (params.dim <= 0 || params.dim > DIM_MAX_MC) {
+            fprintf(stderr, "La dimensión debe estar entre 1 y %d.\n", DIM_MAX_MC);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (params.epsilon <= 0.0 || params.muestras_iniciales < 2
+            || params.nivel_maximo < 2 || params.nivel_maximo > NIVEL_MAX) {
+            fprintf(stderr, "epsilon debe ser positivo, las muestras iniciales al menos 2 y el nivel máximo entre 2 y %d.\n",
+                    NIVEL_MAX);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        printf("Aproximando con Monte Carlo multinivel la integral %dD sobre [%.6f, %.6f]^%d con error objetivo %.3e.\n",
+               params.dim, params.a, params.b, params.dim, params.epsilon);
+    }
+
+    /* Difusión de los parámetros a todos los procesos */
+    MPI_Bcast(&params, sizeof(MLMCParams), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    MPI_Datatype tipo_estadistica;
+    MPI_Op op_combinar;
+    MPI_Type_contiguous(3, MPI_DOUBLE, &tipo_estadistica);
+    MPI_Type_commit(&tipo_estadistica);
+    MPI_Op_create(combinar_estadisticas_mpi, 0, &op_combinar);
+
+    EstadisticaNivel estadisticas[NIVEL_MAX + 1];
+    double tiempos[NIVEL_MAX + 1] = {0.0};
+    PlanMLMC plan;
+    memset(estadisticas, 0, sizeof(estadisticas));
+    memset(&plan, 0, sizeof(plan));
+    plan.niveles = 3;
+    for (int l = 0; l < plan.niveles; l++) {
+        plan.pendientes[l] = params.muestras_iniciales;
+    }
+
+    /* Sincronización antes del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    start_time = MPI_Wtime();
+
+    for (int iteracion = 0; !plan.terminado; iteracion++) {
+        if (rank == 0) {
+            printf("  Iteración %d:\n", iteracion);
+        }
+        ejecutar_plan(&params, &plan, estadisticas, tiempos, rank, size, tipo_estadistica, op_combinar);
+
+        /* El proceso raíz decide y difunde el plan siguiente */
+        if (rank == 0) {
+            planificar(&params, estadisticas, tiempos, &plan);
+        }
+        MPI_Bcast(&plan, sizeof(PlanMLMC), MPI_BYTE, 0, MPI_COMM_WORLD);
+    }
+
+    /* Sincronización después del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    end_time = MPI_Wtime();
+
+    /* Proceso raíz muestra el resultado, la tabla de niveles y el tiempo de ejecución */
+    if (rank == 0) {
+        double resultado = 0.0, varianza_estimador = 0.0, costo = 0.0;
+
+        printf("  nivel  subintervalos      muestras       E[Y_l]        V[Y_l]   costo/muestra\n");
+        for (int l = 0; l < plan.niveles; l++) {
+            const EstadisticaMC *y = &estadisticas[l].correccion;
+            double c = costo_nivel(estadisticas, tiempos, l);
+            resultado += y->media;
+            varianza_estimador += varianza(y) / y->n;
+            costo += y->n * c;
+            printf("  %5d  %13ld  %12.0f  %12.4e  %12.4e  %12.4e\n",
+                   l, (long)MALLA_BASE << l, y->n, y->media, varianza(y), c);
+        }
+
+        /* Monte Carlo estándar con el nivel más fino: 2 ε⁻² V[P_L] muestras, cada una con solo la
+         * evaluación fina (M_L de los M_L + M_L/2 subintervalos de una muestra de Y_L) */
+        int L = plan.niveles - 1;
+        double costo_estandar = 2.0 / (params.epsilon * params.epsilon) * varianza(&estadisticas[L].fino)
+                              * costo_nivel(estadisticas, tiempos, L) / 1.5;
+
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Error estándar: %.3e (objetivo de error cuadrático medio %.3e).\n",
+               sqrt(varianza_estimador), params.epsilon);
+        printf("Costo: %.3f s de proceso (Monte Carlo estándar en el nivel %d: %.3f s estimados).\n",
+               costo, L, costo_estandar);
+        printf("Tiempo de ejecución: %.6f segundos.\n", end_time - start_time);
+    }
+
+    MPI_Op_free(&op_combinar);
+    MPI_Type_free(&tipo_estadistica);
+
+    /* Finalización de MPI */
+    MPI_Finalize();
+
+    return 0;
+}
@@ -11,35 +11,214 @@
  * Regla del Punto Medio y luego se realiza una reducción para obtener la suma total
  * que aproxima la integral.
  *
+ * En modo Monte Carlo (mc) se estima la integral de f(x_1)·...·f(x_dim) sobre [a, b]^dim con n
+ * muestras uniformes. Los bloques de muestras se reparten entre procesos como los subintervalos
+ * y cada bloque tiene su propio flujo de Philox (montecarlo.h), así que la secuencia de muestras
+ * no depende del número de procesos. Media y varianza de todos los procesos se combinan con una
+ * sola MPI_Reduce por ronda, con una operación propia que aplica la fórmula de Welford/Chan.
+ *
+ * En los modos de cuasi-Monte Carlo (sobol, reticula) se usan puntos de Sobol o de una retícula
+ * de rango 1 (cuasi_montecarlo.h) con desplazamientos aleatorios. Los procesos se dividen en
+ * grupos (MPI_Comm_split) que calculan réplicas distintas al mismo tiempo, repartiendo los puntos
+ * de cada réplica por bloques; el error estándar sale de la dispersión entre réplicas. En la
+ * retícula, los candidatos a generador se evalúan repartidos entre todos los procesos.
+ *
+ * El modo vr es el Monte Carlo anterior con reducción de varianza (reduccion_varianza.h):
+ * estratificación de la primera coordenada con un estrato por proceso y asignación de Neyman a
+ * partir de una pasada piloto, variables antitéticas y una variable de control con integral
+ * conocida (funcion_control), en cualquier combinación. Los bloques de todos los estratos se
+ * reparten en tramos contiguos entre procesos, así que la asignación de Neyman no desequilibra
+ * la carga, y las estadísticas por estrato (con covarianza) se combinan con una MPI_Allreduce
+ * por fase.
+ *
+ * En modo romberg se calculan a la vez las sumas del punto medio con n, 2n, ..., 2^(K-1)·n
+ * subintervalos. MPI_COMM_WORLD se divide en grupos por nivel con un número de procesos
+ * proporcional al costo del nivel (los niveles se agrupan por LPT si hay menos procesos que
+ * niveles), de modo que todos terminan a la vez, en el tiempo que tardaría el nivel más fino
+ * solo con su parte de los procesos. El proceso raíz extrapola con Richardson (el error del
+ * punto medio tiene solo potencias pares de h).
+ *
+ * En modo reproducible cada término de la suma de Riemann se acumula de forma exacta en un
+ * superacumulador (superacumulador.h) y los superacumuladores de los procesos se suman con una
+ * MPI_Reduce de operación propia sobre un tipo contiguo de int64. Como la suma es exacta, la
+ * operación es conmutativa y asociativa de verdad y el resultado, redondeado una sola vez, es
+ * idéntico bit a bit con cualquier número de procesos y cualquier árbol de reducción. Para
+ * cuantificar el costo se mide también la suma habitual (cómputo local y MPI_SUM) y la latencia
+ * media de ambas reducciones; el tiempo de ejecución informado incluye estas mediciones.
+ *
+ * El modo lote resuelve muchos trabajos seguidos: [a, b] se parte en 'trabajos' piezas y cada
+ * una se integra con n subintervalos repartidos entre los procesos. Primero se ejecuta como
+ * siempre (MPI_Reduce y MPI_Barrier por trabajo) y después en tubería: tras calcular la parte
+ * local del trabajo k se inicia su MPI_Ireduce y se pasa de inmediato al trabajo k+1; las
+ * solicitudes se prueban después de cada trabajo y solo se espera a la más antigua cuando hay
+ * 'ventana' pendientes, sin barreras entre trabajos. Por último se ejecuta por oleadas: cada
+ * proceso calcula su parte de todos los trabajos de una oleada con sumas compensadas (Kahan) y
+ * una sola MPI_Allreduce de un vector de pares (suma, error) devuelve todos los resultados de la
+ * oleada, combinados con TwoSum. El tamaño de la oleada se adapta: con el cómputo por trabajo
+ * y la latencia de la última reducción (máximos entre procesos, que viajan en el mismo vector,
+ * así que todos los procesos eligen el mismo tamaño) se toma la oleada más pequeña en la que la
+ * reducción no pasa de FRACCION_COMUNICACION_OLEADA del tiempo de la oleada. Se informa por
+ * proceso el tiempo de cómputo y el tiempo ocioso (esperando reducciones o barreras) de las
+ * tres formas.
+ *
+ * El modo granja resuelve un lote heterogéneo: 'trabajos' piezas de [a, b], cada una con su
+ * propio número de subintervalos (log-uniforme entre 1 y n) y su regla (punto medio o Simpson),
+ * sorteados con Philox a partir de la semilla. El costo de cada trabajo se estima con las
+ * evaluaciones que hace (n o 2n+1) por el costo de una evaluación de la función, calibrado al
+ * inicio (máximo entre procesos). Los trabajos que superan UMBRAL_TRABAJO_GRANDE de la cuota de
+ * un proceso se dividen en un subcomunicador de los procesos menos cargados, con tantos procesos
+ * como hagan falta para que a cada uno le toque menos que ese umbral; los demás se ejecutan
+ * enteros en un solo proceso, repartidos por LPT (del más caro al más barato, cada uno al
+ * proceso menos cargado). En línea, el proceso que se queda sin trabajo pide más a los otros
+ * (MPI_Send de una petición, atendida con MPI_Iprobe entre trabajos) y recibe los más baratos
+ * de su lista hasta la mitad de su costo restante. Cada ronda de peticiones pregunta de nuevo a
+ * todos (quien no podía ceder puede haber robado después); tras una ronda completa sin recibir
+ * nada entra en una MPI_Ibarrier y sigue respondiendo peticiones hasta que todos terminan. Como
+ * referencia se ejecuta antes el mismo lote con todos los procesos en cada trabajo.
+ *
+ * El modo iterativo repite la integral 'iteraciones' veces moviendo el límite superior desde a
+ * hasta b, como un bucle externo que cambia los parámetros en cada paso. Cada iteración difunde
+ * IntegracionParams y reduce suma_local con colectivas persistentes (colectivas_persistentes.h:
+ * MPI_Bcast_init y MPI_Reduce_init con MPI 4, emuladas con solicitudes persistentes punto a punto
+ * en versiones anteriores) que se preparan una sola vez y se rearrancan con MPI_Start. El mismo
+ * bucle se ejecuta también con MPI_Bcast y MPI_Reduce ordinarias y se compara la latencia media
+ * por iteración, que con n pequeño es casi toda comunicación.
+ *
+ * La variable de entorno RIEMANN_AFINIDAD (compacta, dispersa, fisicos o numa; afinidad.h) fija
+ * cada proceso a CPUs de su máquina según la topología leída de /sys, tratando a los procesos de
+ * cada máquina (MPI_COMM_TYPE_SHARED) como los hilos de la política, y el proceso raíz imprime
+ * la colocación. Conviene lanzar con --bind-to none para que la colocación de mpirun no interfiera.
+ *
  * Compilación:
  *     mpicc -o mpi_riemann_suma mpi_riemann_suma.c -lm
  *
  * Uso:
- *     mpirun -np <número_de_procesos> ./mpi_riemann_suma <a> <b> <n>
+ *     mpirun -np <número_de_procesos> ./mpi_riemann_suma <a> <b> <n> [mc <dim> [semilla]]
+ *     mpirun -np <número_de_procesos> ./mpi_riemann_suma <a> <b> <n> <sobol|reticula> <dim> <replicas> [semilla]
+ *     mpirun -np <número_de_procesos> ./mpi_riemann_suma <a> <b> <n> vr <dim> <tecnicas> [semilla]
+ *     mpirun -np <número_de_procesos> ./mpi_riemann_suma <a> <b> <n> romberg <niveles>
+ *     mpirun -np <número_de_procesos> ./mpi_riemann_suma <a> <b> <n> reproducible
+ *     mpirun -np <número_de_procesos> ./mpi_riemann_suma <a> <b> <n> lote <trabajos> [ventana]
+ *     mpirun -np <número_de_procesos> ./mpi_riemann_suma <a> <b> <n> iterativo <iteraciones>
+ *     mpirun -np <número_de_procesos> ./mpi_riemann_suma <a> <b> <n> granja <trabajos> [semilla]
  *     Donde:
  *         <a> : Límite inferior de integración (double)
  *         <b> : Límite superior de integración (double)
- *         <n> : Número de subintervalos (entero positivo)
+ *         <n> : Número de subintervalos, o de muestras en modo mc (entero positivo)
+ *         mc <dim> [semilla] : Monte Carlo en dimensión dim con la semilla dada
+ *         sobol|reticula <dim> <replicas> [semilla] : Cuasi-Monte Carlo con réplicas desplazadas
+ *         vr <dim> <tecnicas> [semilla] : Monte Carlo con las técnicas dadas, separadas por comas
+ *                                         (estratos, antitetico, control)
+ *         romberg <niveles> : Extrapolación de Richardson de niveles n, 2n, ..., 2^(niveles-1)·n
+ *         reproducible : Suma exacta con superacumulador, idéntica con cualquier número de procesos
+ *         lote <trabajos> [ventana] : Integra 'trabajos' piezas de [a, b] con n subintervalos cada
+ *                                     una, con reducciones bloqueantes, en tubería con a lo sumo
+ *                                     'ventana' reducciones pendientes (por defecto VENTANA_LOTE)
+ *                                     y por oleadas de tamaño adaptativo
+ *         iterativo <iteraciones> : Repite la integral con el límite superior de a a b, con
+ *                                   colectivas persistentes y ordinarias
+ *         granja <trabajos> [semilla] : Lote heterogéneo de hasta n subintervalos por trabajo,
+ *                                       repartido por costo entre procesos y subcomunicadores
  *
  * Ejemplo:
  *     mpirun -np 4 ./mpi_riemann_suma 0 3.141592653589793 100000000
+ *     mpirun -np 4 ./mpi_riemann_suma 0 3.141592653589793 100000000 mc 6
+ *     mpirun -np 4 ./mpi_riemann_suma 0 3.141592653589793 16777216 sobol 6 8
+ *     mpirun -np 4 ./mpi_riemann_suma 0 3.141592653589793 100000000 vr 6 estratos,control
+ *     mpirun -np 8 ./mpi_riemann_suma 0 3.141592653589793 1000 romberg 4
+ *     mpirun -np 4 ./mpi_riemann_suma 0 3.141592653589793 100000000 reproducible
+ *     mpirun -np 4 ./mpi_riemann_suma 0 3.141592653589793 100000 lote 1000 8
+ *     mpirun -np 4 ./mpi_riemann_suma 0 3.141592653589793 1000 iterativo 10000
+ *     mpirun -np 4 ./mpi_riemann_suma 0 3.141592653589793 10000000 granja 500
+ *     RIEMANN_AFINIDAD=dispersa mpirun --bind-to none -np 4 ./mpi_riemann_suma 0 3.141592653589793 100000000
  */
 
+#define _GNU_SOURCE
 #include <mpi.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+#include <limits.h>
+#include "montecarlo.h"
+#include "cuasi_montecarlo.h"
+#include "reduccion_varianza.h"
+#include "afinidad.h"
+#include "superacumulador.h"
+#include "colectivas_persistentes.h"
+
+#define RONDAS_MC 10        // Informes parciales del modo Monte Carlo
+#define SEMILLA_MC 12345
+#define NIVELES_ROMBERG_MAX 24
+#define REPETICIONES_REDUCCION 100  // Reducciones promediadas al medir la latencia del modo reproducible
+#define VENTANA_LOTE 8              // Reducciones pendientes por defecto del modo lote
+#define FRACCION_COMUNICACION_OLEADA 0.05  // Fracción máxima de cada oleada dedicada a la reducción
+#define OLEADA_MAXIMA 1024                 // Trabajos por oleada como máximo
+#define UMBRAL_TRABAJO_GRANDE 0.5          // Fracción de la cuota por proceso a partir de la cual se divide un trabajo
+#define EVALUACIONES_CALIBRACION 262144    // Evaluaciones de la función para calibrar su costo
+#define ETIQUETA_PETICION_GRANJA 7501
+#define ETIQUETA_RESPUESTA_GRANJA 7502
 
 /* Definición de la función a integrar */
 double funcion(double x) {
     return sin(x); // A quien lea esto, puede cambiar la función a integrar por cualquier otra función que desee.
 }
 
+/* Integrando del modo Monte Carlo: producto de la función en cada coordenada */
+double funcion_multidimensional(const double *x, int dim) {
+    double producto = 1.0;
+    for (int d = 0; d < dim; d++) {
+        producto *= funcion(x[d]);
+    }
+    return producto;
+}
+
+/* Variable de control del modo vr: parábola que coincide con sin(x) en 0, π/2 y π. Si se cambia
+ * la función a integrar, conviene cambiar también esta aproximación y su primitiva. */
+double funcion_control(double x) {
+    return 4.0 / (M_PI * M_PI) * x * (M_PI - x);
+}
+
+double primitiva_control(double x) {
+    return 4.0 / (M_PI * M_PI) * (M_PI * x * x / 2.0 - x * x * x / 3.0);
+}
+
+double control_multidimensional(const double *x, int dim) {
+    double producto = 1.0;
+    for (int d = 0; d < dim; d++) {
+        producto *= funcion_control(x[d]);
+    }
+    return producto;
+}
+
+/* Integral exacta de la variable de control sobre una caja */
+double integral_control_caja(const double *inferior, const double *superior, int dim) {
+    double producto = 1.0;
+    for (int d = 0; d < dim; d++) {
+        producto *= primitiva_control(superior[d]) - primitiva_control(inferior[d]);
+    }
+    return producto;
+}
+
+/* Modos de cálculo */
+typedef enum { MODO_RIEMANN, MODO_MONTECARLO, MODO_SOBOL, MODO_RETICULA, MODO_VR, MODO_ROMBERG, MODO_REPRODUCIBLE,
+               MODO_LOTE, MODO_ITERATIVO, MODO_GRANJA } ModoIntegracion;
+
 /* Estructura para almacenar los parámetros de la integral */
 typedef struct {
     double a;      // Límite inferior de integración
     double b;      // Límite superior de integración
-    long n;        // Número de subintervalos
+    long n;        // Número de subintervalos (o de muestras en Monte Carlo)
+    int modo;      // ModoIntegracion
+    int dim;       // Dimensión del modo Monte Carlo
+    int replicas;  // Réplicas desplazadas de los modos de cuasi-Monte Carlo
+    int tecnicas;  // Técnicas de reducción de varianza del modo vr (TECNICA_*)
+    int niveles;   // Niveles de refinamiento del modo romberg
+    uint64_t semilla;  // Semilla de los modos Monte Carlo, cuasi-Monte Carlo y granja
+    int afinidad;  // PoliticaAfinidad leída de RIEMANN_AFINIDAD
+    long trabajos; // Trabajos de los modos lote y granja
+    int ventana;   // Reducciones pendientes como máximo en el modo lote
+    long iteraciones;  // Iteraciones del modo iterativo
 } IntegracionParams;
 
 /* Función para calcular la suma de Riemann utilizando la Regla del Punto Medio */
@@ -56,10 +235,1167 @@ double calcular_suma_riemann(IntegracionParams params, long inicio, long fin) {
     return suma;
 }
 
+/* Operación de MPI que suma superacumuladores (tipo: LIMBS_SUPERACUMULADOR int64 contiguos). La
+ * suma es exacta, así que la operación se declara conmutativa. */
+void combinar_superacumuladores_mpi(void *entrada, void *acumulado, int *cantidad, MPI_Datatype *tipo) {
+    (void)tipo;
+    int64_t *in = entrada, *acc = acumulado;
+    for (int i = 0; i < *cantidad; i++) {
+        superacumulador_combinar(acc + (size_t)i * LIMBS_SUPERACUMULADOR, in + (size_t)i * LIMBS_SUPERACUMULADOR);
+    }
+}
+
+/* Suma de Riemann exacta hasta el redondeo final: cada término entra en el superacumulador
+ * local y los superacumuladores se reducen con una operación propia. Mide además la suma
+ * habitual y la latencia de ambas reducciones. */
+double calcular_integral_reproducible(IntegracionParams params, int rank, long inicio, long fin) {
+    double delta_x = (params.b - params.a) / params.n;
+    Superacumulador local;
+    int64_t total[LIMBS_SUPERACUMULADOR];
+    double suma_habitual = 0.0;
+    double tiempos[4], maximos[4];  // Cómputo y reducción, reproducibles y habituales
+    MPI_Datatype tipo_superacumulador;
+    MPI_Op op_sumar;
+
+    MPI_Type_contiguous(LIMBS_SUPERACUMULADOR, MPI_INT64_T, &tipo_superacumulador);
+    MPI_Type_commit(&tipo_superacumulador);
+    MPI_Op_create(combinar_superacumuladores_mpi, 1, &op_sumar);
+
+    double t = MPI_Wtime();
+    superacumulador_iniciar(&local);
+    for (long i = inicio; i < fin; i++) {
+        double x = params.a + (i + 0.5) * delta_x;
+        superacumulador_sumar(&local, funcion(x) * delta_x);
+    }
+    superacumulador_normalizar(local.limbs);
+    tiempos[0] = MPI_Wtime() - t;
+
+    t = MPI_Wtime();
+    double suma_local = calcular_suma_riemann(params, inicio, fin);
+    tiempos[2] = MPI_Wtime() - t;
+
+    /* Latencia media de cada reducción */
+    MPI_Barrier(MPI_COMM_WORLD);
+    t = MPI_Wtime();
+    for (int r = 0; r < REPETICIONES_REDUCCION; r++) {
+        MPI_Reduce(local.limbs, total, 1, tipo_superacumulador, op_sumar, 0, MPI_COMM_WORLD);
+    }
+    tiempos[1] = (MPI_Wtime() - t) / REPETICIONES_REDUCCION;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    t = MPI_Wtime();
+    for (int r = 0; r < REPETICIONES_REDUCCION; r++) {
+        MPI_Reduce(&suma_local, &suma_habitual, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    }
+    tiempos[3] = (MPI_Wtime() - t) / REPETICIONES_REDUCCION;
+
+    MPI_Reduce(tiempos, maximos, 4, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Op_free(&op_sumar);
+    MPI_Type_free(&tipo_superacumulador);
+
+    if (rank != 0) {
+        return 0.0;
+    }
+    double resultado = superacumulador_a_double(total);
+    printf("Resultado exacto: %a\n", resultado);
+    printf("Suma habitual (MPI_SUM): %.12f (%a)\n", suma_habitual, suma_habitual);
+    printf("Cómputo local: %.6f s con superacumulador, %.6f s con suma habitual (máximo entre procesos).\n",
+           maximos[0], maximos[2]);
+    printf("Reducción: %.1f µs con superacumulador (%zu bytes), %.1f µs con MPI_SUM (%zu bytes).\n",
+           maximos[1] * 1e6, sizeof(local.limbs), maximos[3] * 1e6, sizeof(double));
+    return resultado;
+}
+
+/* Parte local del trabajo k del modo lote: la pieza k de [a, b] con n subintervalos */
+static double suma_local_trabajo(IntegracionParams params, long k, int rank, int size) {
+    IntegracionParams pieza = params;
+    pieza.a = params.a + k * (params.b - params.a) / params.trabajos;
+    pieza.b = (k == params.trabajos - 1) ? params.b : params.a + (k + 1) * (params.b - params.a) / params.trabajos;
+    long por_proceso = params.n / size;
+    long inicio = rank * por_proceso;
+    long fin = (rank == size - 1) ? params.n : inicio + por_proceso;
+    return calcular_suma_riemann(pieza, inicio, fin);
+}
+
+/* Elemento del vector que reduce una oleada: la suma compensada de un trabajo (valor suma +
+ * error) y dos máximos entre procesos, que solo se usan en el primer elemento */
+typedef struct {
+    double suma;
+    double error;
+    double computo;       // Segundos de cómputo por trabajo en esta oleada
+    double comunicacion;  // Segundos de la reducción de la oleada anterior
+} ElementoOleada;
+
+/* Parte local del trabajo k con suma de Kahan; devuelve la suma y deja el error en *error */
+static double suma_local_trabajo_compensada(IntegracionParams params, long k, int rank, int size, double *error) {
+    double a = params.a + k * (params.b - params.a) / params.trabajos;
+    double b = (k == params.trabajos - 1) ? params.b : params.a + (k + 1) * (params.b - params.a) / params.trabajos;
+    double delta_x = (b - a) / params.n;
+    long por_proceso = params.n / size;
+    long inicio = rank * por_proceso;
+    long fin = (rank == size - 1) ? params.n : inicio + por_proceso;
+    double suma = 0.0, compensacion = 0.0;
+    for (long i = inicio; i < fin; i++) {
+        double y = funcion(a + (i + 0.5) * delta_x) * delta_x - compensacion;
+        double t = suma + y;
+        compensacion = (t - suma) - y;
+        suma = t;
+    }
+    *error = -compensacion;
+    return suma;
+}
+
+/* Operación de MPI sobre vectores de ElementoOleada (tipo: cuatro doubles contiguos): suma
+ * compensada con TwoSum de (suma, error) y máximo de los tiempos */
+void combinar_oleada_mpi(void *entrada, void *acumulado, int *cantidad, MPI_Datatype *tipo) {
+    (void)tipo;
+    ElementoOleada *in = entrada, *acc = acumulado;
+    for (int i = 0; i < *cantidad; i++) {
+        double s = in[i].suma + acc[i].suma;
+        double v = s - in[i].suma;
+        double e = (in[i].suma - (s - v)) + (acc[i].suma - v) + in[i].error + acc[i].error;
+        acc[i].suma = s + e;
+        acc[i].error = e - (acc[i].suma - s);
+        acc[i].computo = fmax(acc[i].computo, in[i].computo);
+        acc[i].comunicacion = fmax(acc[i].comunicacion, in[i].comunicacion);
+    }
+}
+
+/* Oleada más pequeña en la que una reducción de 'latencia' segundos no pasa de la fracción
+ * FRACCION_COMUNICACION_OLEADA del tiempo de la oleada con 'computo' segundos por trabajo */
+static int tamano_oleada(double computo, double latencia, long restantes) {
+    double deseado = (computo > 0.0)
+                         ? latencia * (1.0 - FRACCION_COMUNICACION_OLEADA) / (FRACCION_COMUNICACION_OLEADA * computo)
+                         : OLEADA_MAXIMA;
+    long tamano = (deseado >= OLEADA_MAXIMA) ? OLEADA_MAXIMA : (long)ceil(deseado);
+    if (tamano < 1) {
+        tamano = 1;
+    }
+    return (int)(tamano < restantes ? tamano : restantes);
+}
+
+/* Lote de trabajos, primero con reducción y barrera bloqueantes por trabajo, luego en tubería
+ * con MPI_Ireduce y una ventana acotada de solicitudes pendientes y por último por oleadas de
+ * tamaño adaptativo con una sola reducción vectorial compensada por oleada. Cada proceso mide
+ * su tiempo de cómputo y su tiempo ocioso en las tres formas; el raíz imprime la tabla por
+ * proceso. */
+double calcular_integral_lote(IntegracionParams params, int rank, int size) {
+    double *locales = malloc(params.trabajos * sizeof(double));
+    double *resultados = malloc(params.trabajos * sizeof(double));
+    MPI_Request *solicitudes = malloc(params.ventana * sizeof(MPI_Request));
+    double tiempos[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};  // Cómputo y espera: bloqueante, en tubería, por oleadas
+    double t;
+
+    /* Forma bloqueante */
+    double total_bloqueante = 0.0;
+    for (long k = 0; k < params.trabajos; k++) {
+        t = MPI_Wtime();
+        double local = suma_local_trabajo(params, k, rank, size);
+        tiempos[0] += MPI_Wtime() - t;
+
+        t = MPI_Wtime();
+        MPI_Reduce(&local, &resultados[k], 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Barrier(MPI_COMM_WORLD);
+        tiempos[1] += MPI_Wtime() - t;
+        total_bloqueante += resultados[k];
+    }
+
+    /* En tubería: la solicitud del trabajo k ocupa la posición k % ventana */
+    MPI_Barrier(MPI_COMM_WORLD);
+    long completadas = 0;  // Las solicitudes anteriores a esta ya terminaron
+    for (long k = 0; k < params.trabajos; k++) {
+        t = MPI_Wtime();
+        locales[k] = suma_local_trabajo(params, k, rank, size);
+        tiempos[2] += MPI_Wtime() - t;
+
+        t = MPI_Wtime();
+        if (k - completadas == params.ventana) {
+            MPI_Wait(&solicitudes[completadas % params.ventana], MPI_STATUS_IGNORE);
+            completadas++;
+        }
+        MPI_Ireduce(&locales[k], &resultados[k], 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD,
+                    &solicitudes[k % params.ventana]);
+
+        /* Progreso perezoso: retira las solicitudes más antiguas que ya terminaron */
+        int terminada = 1;
+        while (completadas <= k && terminada) {
+            MPI_Test(&solicitudes[completadas % params.ventana], &terminada, MPI_STATUS_IGNORE);
+            completadas += terminada;
+        }
+        tiempos[3] += MPI_Wtime() - t;
+    }
+    t = MPI_Wtime();
+    for (; completadas < params.trabajos; completadas++) {
+        MPI_Wait(&solicitudes[completadas % params.ventana], MPI_STATUS_IGNORE);
+    }
+    tiempos[3] += MPI_Wtime() - t;
+
+    double total = 0.0;
+    for (long k = 0; k < params.trabajos; k++) {
+        total += resultados[k];
+    }
+
+    /* Por oleadas: una MPI_Allreduce de un vector de ElementoOleada por oleada */
+    MPI_Datatype tipo_elemento;
+    MPI_Op op_oleada;
+    MPI_Type_contiguous(4, MPI_DOUBLE, &tipo_elemento);
+    MPI_Type_commit(&tipo_elemento);
+    MPI_Op_create(combinar_oleada_mpi, 1, &op_oleada);
+    int capacidad = (params.trabajos < OLEADA_MAXIMA) ? (int)params.trabajos : OLEADA_MAXIMA;
+    ElementoOleada *oleada = malloc(capacidad * sizeof(ElementoOleada));
+    ElementoOleada *reducida = malloc(capacidad * sizeof(ElementoOleada));
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double total_oleadas = 0.0, latencia = 0.0;
+    long oleadas = 0;
+    int tamano = 1, tamano_minimo = OLEADA_MAXIMA, tamano_maximo = 1;
+    long k = 0;
+    while (k < params.trabajos) {
+        t = MPI_Wtime();
+        for (int j = 0; j < tamano; j++) {
+            oleada[j].suma = suma_local_trabajo_compensada(params, k + j, rank, size, &oleada[j].error);
+            oleada[j].computo = 0.0;
+            oleada[j].comunicacion = 0.0;
+        }
+        double computo = MPI_Wtime() - t;
+        tiempos[4] += computo;
+        oleada[0].computo = computo / tamano;
+        oleada[0].comunicacion = latencia;
+
+        t = MPI_Wtime();
+        MPI_Allreduce(oleada, reducida, tamano, tipo_elemento, op_oleada, MPI_COMM_WORLD);
+        latencia = MPI_Wtime() - t;
+        tiempos[5] += latencia;
+        for (int j = 0; j < tamano; j++) {
+            total_oleadas += reducida[j].suma + reducida[j].error;
+        }
+        oleadas++;
+        tamano_minimo = (tamano < tamano_minimo) ? tamano : tamano_minimo;
+        tamano_maximo = (tamano > tamano_maximo) ? tamano : tamano_maximo;
+
+        /* Todos los procesos ven los mismos máximos, así que eligen el mismo tamaño siguiente */
+        k += tamano;
+        tamano = tamano_oleada(reducida[0].computo, reducida[0].comunicacion, params.trabajos - k);
+    }
+    MPI_Op_free(&op_oleada);
+    MPI_Type_free(&tipo_elemento);
+    free(oleada);
+    free(reducida);
+
+    double *todos = (rank == 0) ? malloc(6 * size * sizeof(double)) : NULL;
+    MPI_Gather(tiempos, 6, MPI_DOUBLE, todos, 6, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        double ocio_bloqueante = 0.0, ocio_tuberia = 0.0, ocio_oleadas = 0.0;
+        printf("| Proceso | Cómputo bloq. (s) | Ocioso bloq. (s) | Cómputo tubería (s) | Ocioso tubería (s) "
+               "| Cómputo oleadas (s) | Ocioso oleadas (s) |\n");
+        for (int r = 0; r < size; r++) {
+            const double *f = &todos[6 * r];
+            printf("| %-7d | %-17.6f | %-16.6f | %-19.6f | %-18.6f | %-19.6f | %-18.6f |\n", r, f[0], f[1], f[2], f[3],
+                   f[4], f[5]);
+            ocio_bloqueante += f[1];
+            ocio_tuberia += f[3];
+            ocio_oleadas += f[5];
+        }
+        printf("Bloqueante: %.12f. Tiempo ocioso total %.6f s en bloqueante y %.6f s en tubería (reducción del %.1f %%).\n",
+               total_bloqueante, ocio_bloqueante, ocio_tuberia,
+               ocio_bloqueante > 0.0 ? 100.0 * (ocio_bloqueante - ocio_tuberia) / ocio_bloqueante : 0.0);
+        printf("Oleadas: %.12f con %ld reducciones para %ld trabajos (oleadas de %d a %d trabajos); tiempo ocioso total %.6f s.\n",
+               total_oleadas, oleadas, params.trabajos, tamano_minimo, tamano_maximo, ocio_oleadas);
+        free(todos);
+    }
+
+    free(locales);
+    free(resultados);
+    free(solicitudes);
+    return total;
+}
+
+typedef enum { REGLA_PUNTO_MEDIO, REGLA_SIMPSON } ReglaGranja;
+
+/* Trabajo del modo granja */
+typedef struct {
+    double a, b;
+    long n;
+    int regla;     // ReglaGranja
+    double costo;  // Segundos estimados
+} TrabajoGranja;
+
+/* Estado de un proceso de la granja: su lista de trabajos enteros pendientes es
+ * lista[siguiente, final), ordenada de más caro a más barato */
+typedef struct {
+    const TrabajoGranja *trabajos;
+    long *lista;
+    long siguiente, final;
+    long *cedidos;        // Búfer de respuesta a las peticiones
+    double *resultados;   // Por trabajo; cero en los que no terminó este proceso
+    long ejecutados;      // Trabajos enteros y partes de trabajos grandes
+    long robados;         // Trabajos recibidos por peticiones
+    double computo;
+} Granja;
+
+/* Suma de la regla del trabajo sobre los subintervalos [inicio, fin) */
+static double evaluar_trabajo(const TrabajoGranja *trabajo, long inicio, long fin) {
+    double h = (trabajo->b - trabajo->a) / trabajo->n;
+    double suma = 0.0;
+    if (trabajo->regla == REGLA_PUNTO_MEDIO) {
+        for (long i = inicio; i < fin; i++) {
+            suma += funcion(trabajo->a + (i + 0.5) * h);
+        }
+        return suma * h;
+    }
+    double izquierda = funcion(trabajo->a + inicio * h);
+    for (long i = inicio; i < fin; i++) {
+        double derecha = funcion(trabajo->a + (i + 1) * h);
+        suma += izquierda + 4.0 * funcion(trabajo->a + (i + 0.5) * h) + derecha;
+        izquierda = derecha;
+    }
+    return suma * h / 6.0;
+}
+
+/* Segundos por evaluación de la función en [a, b] (máximo entre procesos) */
+static double calibrar_costo_evaluacion(IntegracionParams params) {
+    volatile double sumidero;
+    double h = (params.b - params.a) / EVALUACIONES_CALIBRACION;
+    double suma = 0.0, t = MPI_Wtime();
+    for (long i = 0; i < EVALUACIONES_CALIBRACION; i++) {
+        suma += funcion(params.a + (i + 0.5) * h);
+    }
+    sumidero = suma;
+    (void)sumidero;
+    double costo = (MPI_Wtime() - t) / EVALUACIONES_CALIBRACION, maximo;
+    MPI_Allreduce(&costo, &maximo, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return maximo;
+}
+
+/* Lote heterogéneo reproducible: el trabajo k es la pieza k de [a, b] con n log-uniforme en
+ * [1, params.n] y regla al azar */
+static void generar_trabajos_granja(IntegracionParams params, double costo_evaluacion, TrabajoGranja *trabajos) {
+    for (long k = 0; k < params.trabajos; k++) {
+        double u[2];
+        philox_uniformes(params.semilla, (uint64_t)k, 0, 2, u);
+        TrabajoGranja *trabajo = &trabajos[k];
+        trabajo->a = params.a + k * (params.b - params.a) / params.trabajos;
+        trabajo->b = (k == params.trabajos - 1) ? params.b
+                                                : params.a + (k + 1) * (params.b - params.a) / params.trabajos;
+        trabajo->n = (long)exp(u[0] * log((double)params.n));
+        trabajo->n = (trabajo->n < 1) ? 1 : (trabajo->n > params.n ? params.n : trabajo->n);
+        trabajo->regla = (u[1] < 0.5) ? REGLA_PUNTO_MEDIO : REGLA_SIMPSON;
+        double evaluaciones = (trabajo->regla == REGLA_PUNTO_MEDIO) ? trabajo->n : 2.0 * trabajo->n + 1.0;
+        trabajo->costo = evaluaciones * costo_evaluacion;
+    }
+}
+
+static const TrabajoGranja *trabajos_orden;  // Para ordenar índices por costo con qsort
+
+static int comparar_costo_descendente(const void *x, const void *y) {
+    double cx = trabajos_orden[*(const long *)x].costo, cy = trabajos_orden[*(const long *)y].costo;
+    if (cx != cy) {
+        return cx < cy ? 1 : -1;
+    }
+    return (*(const long *)x > *(const long *)y) - (*(const long *)x < *(const long *)y);
+}
+
+/* Proceso de menor carga que no está en 'excluidos' (NULL: ninguno) */
+static int proceso_menos_cargado(const double *carga, const char *excluidos, int size) {
+    int menor = -1;
+    for (int r = 0; r < size; r++) {
+        if ((excluidos == NULL || !excluidos[r]) && (menor < 0 || carga[r] < carga[menor])) {
+            menor = r;
+        }
+    }
+    return menor;
+}
+
+/* Responde las peticiones pendientes cediendo los trabajos más baratos de la lista hasta la
+ * mitad de su costo restante (ninguno si queda menos de dos) */
+static void atender_peticiones(Granja *granja) {
+    int hay;
+    MPI_Status estado;
+    MPI_Iprobe(MPI_ANY_SOURCE, ETIQUETA_PETICION_GRANJA, MPI_COMM_WORLD, &hay, &estado);
+    while (hay) {
+        MPI_Recv(NULL, 0, MPI_BYTE, estado.MPI_SOURCE, ETIQUETA_PETICION_GRANJA, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        double restante = 0.0, cedido = 0.0;
+        for (long i = granja->siguiente; i < granja->final; i++) {
+            restante += granja->trabajos[granja->lista[i]].costo;
+        }
+        int cantidad = 0;
+        while (granja->final - granja->siguiente > 1 && cedido < restante / 2.0) {
+            long id = granja->lista[--granja->final];
+            cedido += granja->trabajos[id].costo;
+            granja->cedidos[cantidad++] = id;
+        }
+        MPI_Send(granja->cedidos, cantidad, MPI_LONG, estado.MPI_SOURCE, ETIQUETA_RESPUESTA_GRANJA, MPI_COMM_WORLD);
+        MPI_Iprobe(MPI_ANY_SOURCE, ETIQUETA_PETICION_GRANJA, MPI_COMM_WORLD, &hay, &estado);
+    }
+}
+
+/* Pide trabajo a 'victima' atendiendo mientras tanto las peticiones de los demás; devuelve
+ * cuántos trabajos recibió (quedan en la lista, que estaba vacía) */
+static int pedir_trabajo(Granja *granja, int victima) {
+    int hay = 0, cantidad;
+    MPI_Status estado;
+    MPI_Send(NULL, 0, MPI_BYTE, victima, ETIQUETA_PETICION_GRANJA, MPI_COMM_WORLD);
+    while (!hay) {
+        atender_peticiones(granja);
+        MPI_Iprobe(victima, ETIQUETA_RESPUESTA_GRANJA, MPI_COMM_WORLD, &hay, &estado);
+        if (!hay) {
+            sched_yield();
+        }
+    }
+    MPI_Get_count(&estado, MPI_LONG, &cantidad);
+    granja->siguiente = 0;
+    granja->final = cantidad;
+    MPI_Recv(granja->lista, cantidad, MPI_LONG, victima, ETIQUETA_RESPUESTA_GRANJA, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    granja->robados += cantidad;
+    return cantidad;
+}
+
+/* Modo granja: referencia con todos los procesos en cada trabajo y luego la granja con
+ * subcomunicadores para los trabajos grandes, LPT para los pequeños y peticiones de trabajo */
+double calcular_integral_granja(IntegracionParams params, int rank, int size) {
+    long total_trabajos = params.trabajos;
+    TrabajoGranja *trabajos = malloc(total_trabajos * sizeof(TrabajoGranja));
+    double costo_evaluacion = calibrar_costo_evaluacion(params);
+    generar_trabajos_granja(params, costo_evaluacion, trabajos);
+
+    /* Referencia: cada trabajo repartido entre todos los procesos */
+    double total_referencia = 0.0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t = MPI_Wtime();
+    for (long k = 0; k < total_trabajos; k++) {
+        long por_proceso = trabajos[k].n / size;
+        long inicio = rank * por_proceso;
+        long fin = (rank == size - 1) ? trabajos[k].n : inicio + por_proceso;
+        double local = evaluar_trabajo(&trabajos[k], inicio, fin), suma = 0.0;
+        MPI_Reduce(&local, &suma, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        total_referencia += suma;
+    }
+    double tiempo_referencia = MPI_Wtime() - t;
+
+    /* Plan, idéntico en todos los procesos: grandes a los menos cargados, pequeños por LPT */
+    long *orden = malloc(total_trabajos * sizeof(long));
+    double costo_total = 0.0;
+    for (long k = 0; k < total_trabajos; k++) {
+        orden[k] = k;
+        costo_total += trabajos[k].costo;
+    }
+    trabajos_orden = trabajos;
+    qsort(orden, total_trabajos, sizeof(long), comparar_costo_descendente);
+
+    double umbral = UMBRAL_TRABAJO_GRANDE * costo_total / size;
+    double *carga = calloc(size, sizeof(double));
+    char *elegidos = malloc(size);  // Miembros del subcomunicador del trabajo grande actual
+    long grandes = 0;
+    while (size > 1 && grandes < total_trabajos && trabajos[orden[grandes]].costo > umbral) {
+        grandes++;
+    }
+    MPI_Comm *comms = malloc((grandes > 0 ? grandes : 1) * sizeof(MPI_Comm));
+    for (long j = 0; j < grandes; j++) {
+        const TrabajoGranja *trabajo = &trabajos[orden[j]];
+        int procesos = (int)ceil(trabajo->costo / umbral);
+        procesos = (procesos > size) ? size : procesos;
+        int color = MPI_UNDEFINED;
+        memset(elegidos, 0, size);
+        for (int m = 0; m < procesos; m++) {
+            int miembro = proceso_menos_cargado(carga, elegidos, size);
+            elegidos[miembro] = 1;
+            color = (miembro == rank) ? 0 : color;
+        }
+        for (int r = 0; r < size; r++) {
+            carga[r] += elegidos[r] ? trabajo->costo / procesos : 0.0;
+        }
+        MPI_Comm_split(MPI_COMM_WORLD, color, rank, &comms[j]);
+    }
+
+    Granja granja = {trabajos, malloc(total_trabajos * sizeof(long)), 0, 0, malloc(total_trabajos * sizeof(long)),
+                     calloc(total_trabajos, sizeof(double)), 0, 0, 0.0};
+    for (long j = grandes; j < total_trabajos; j++) {
+        int destino = proceso_menos_cargado(carga, NULL, size);
+        carga[destino] += trabajos[orden[j]].costo;
+        if (destino == rank) {
+            granja.lista[granja.final++] = orden[j];
+        }
+    }
+    double makespan_previsto = carga[0];
+    for (int r = 1; r < size; r++) {
+        makespan_previsto = fmax(makespan_previsto, carga[r]);
+    }
+    double carga_prevista = carga[rank];
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double inicio_granja = MPI_Wtime();
+
+    /* Trabajos grandes en el orden global, cada uno en su subcomunicador */
+    for (long j = 0; j < grandes; j++) {
+        if (comms[j] == MPI_COMM_NULL) {
+            continue;
+        }
+        int rank_grupo, size_grupo;
+        MPI_Comm_rank(comms[j], &rank_grupo);
+        MPI_Comm_size(comms[j], &size_grupo);
+        const TrabajoGranja *trabajo = &trabajos[orden[j]];
+        long por_proceso = trabajo->n / size_grupo;
+        long inicio = rank_grupo * por_proceso;
+        long fin = (rank_grupo == size_grupo - 1) ? trabajo->n : inicio + por_proceso;
+        t = MPI_Wtime();
+        double local = evaluar_trabajo(trabajo, inicio, fin), suma = 0.0;
+        granja.computo += MPI_Wtime() - t;
+        MPI_Reduce(&local, &suma, 1, MPI_DOUBLE, MPI_SUM, 0, comms[j]);
+        if (rank_grupo == 0) {
+            granja.resultados[orden[j]] = suma;
+        }
+        granja.ejecutados++;
+        MPI_Comm_free(&comms[j]);
+        atender_peticiones(&granja);
+    }
+
+    /* Trabajos enteros propios y, al acabarlos, pedidos a los demás. Cada ronda vuelve a
+     * preguntar a todos, porque un proceso que no podía ceder puede haber robado trabajo
+     * después; se termina tras una ronda completa sin recibir nada. */
+    for (;;) {
+        while (granja.siguiente < granja.final) {
+            long id = granja.lista[granja.siguiente++];
+            t = MPI_Wtime();
+            granja.resultados[id] = evaluar_trabajo(&trabajos[id], 0, trabajos[id].n);
+            granja.computo += MPI_Wtime() - t;
+            granja.ejecutados++;
+            atender_peticiones(&granja);
+        }
+        int recibidos = 0;
+        for (int desplazamiento = 1; desplazamiento < size && !recibidos; desplazamiento++) {
+            recibidos = pedir_trabajo(&granja, (rank + desplazamiento) % size);
+        }
+        if (!recibidos) {
+            break;
+        }
+    }
+
+    /* Terminación: todos sin trabajo; se siguen respondiendo peticiones hasta entonces */
+    MPI_Request barrera;
+    int terminada = 0;
+    MPI_Ibarrier(MPI_COMM_WORLD, &barrera);
+    while (!terminada) {
+        atender_peticiones(&granja);
+        MPI_Test(&barrera, &terminada, MPI_STATUS_IGNORE);
+        if (!terminada) {
+            sched_yield();
+        }
+    }
+    double tiempo_granja = MPI_Wtime() - inicio_granja;
+
+    double *resultados = (rank == 0) ? malloc(total_trabajos * sizeof(double)) : NULL;
+    MPI_Reduce(granja.resultados, resultados, total_trabajos, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    double estadisticas[5] = {(double)granja.ejecutados, (double)granja.robados, carga_prevista, granja.computo,
+                              tiempo_granja - granja.computo};
+    double *todas = (rank == 0) ? malloc(5 * size * sizeof(double)) : NULL;
+    MPI_Gather(estadisticas, 5, MPI_DOUBLE, todas, 5, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    double total = 0.0;
+    if (rank == 0) {
+        for (long k = 0; k < total_trabajos; k++) {
+            total += resultados[k];
+        }
+        printf("Costo estimado del lote: %.6f s (%.2f ns por evaluación); %ld trabajos grandes en subcomunicadores "
+               "y %ld enteros por LPT; makespan previsto %.6f s.\n",
+               costo_total, costo_evaluacion * 1e9, grandes, total_trabajos - grandes, makespan_previsto);
+        printf("| Proceso | Trabajos | Robados | Carga LPT (s) | Cómputo (s) | Ocioso (s) |\n");
+        for (int r = 0; r < size; r++) {
+            const double *f = &todas[5 * r];
+            printf("| %-7d | %-8ld | %-7ld | %-13.6f | %-11.6f | %-10.6f |\n", r, (long)f[0], (long)f[1], f[2], f[3],
+                   f[4]);
+        }
+        printf("Todos los procesos en cada trabajo: %.12f en %.6f s. Granja: %.12f en %.6f s (%.2fx).\n",
+               total_referencia, tiempo_referencia, total, tiempo_granja,
+               tiempo_granja > 0.0 ? tiempo_referencia / tiempo_granja : 0.0);
+        free(resultados);
+        free(todas);
+    }
+
+    free(granja.lista);
+    free(granja.cedidos);
+    free(granja.resultados);
+    free(comms);
+    free(elegidos);
+    free(carga);
+    free(orden);
+    free(trabajos);
+    return total;
+}
+
+/* Bucle iterativo con colectivas persistentes: los búferes viven en la estructura, que no debe
+ * moverse entre bucle_iterativo_iniciar y bucle_iterativo_liberar */
+typedef struct {
+    IntegracionParams params;  // Lo escribe el raíz antes de cada paso
+    double suma_local;
+    double suma_total;         // Válida en el raíz después de cada paso
+    DifusionPersistente difusion;
+    ReduccionPersistente reduccion;
+} BucleIterativo;
+
+void bucle_iterativo_iniciar(BucleIterativo *bucle, IntegracionParams params) {
+    bucle->params = params;
+    bucle->suma_local = 0.0;
+    bucle->suma_total = 0.0;
+    difusion_persistente_iniciar(&bucle->difusion, &bucle->params, sizeof(IntegracionParams), MPI_BYTE, 0,
+                                 MPI_COMM_WORLD);
+    reduccion_persistente_iniciar(&bucle->reduccion, &bucle->suma_local, &bucle->suma_total, 1, 0, MPI_COMM_WORLD);
+}
+
+/* Un paso: difunde los parámetros del raíz, calcula la parte local y la reduce en el raíz */
+double bucle_iterativo_paso(BucleIterativo *bucle, int rank, int size) {
+    difusion_persistente_ejecutar(&bucle->difusion);
+    long por_proceso = bucle->params.n / size;
+    long inicio = rank * por_proceso;
+    long fin = (rank == size - 1) ? bucle->params.n : inicio + por_proceso;
+    bucle->suma_local = calcular_suma_riemann(bucle->params, inicio, fin);
+    reduccion_persistente_ejecutar(&bucle->reduccion);
+    return bucle->suma_total;
+}
+
+void bucle_iterativo_liberar(BucleIterativo *bucle) {
+    difusion_persistente_liberar(&bucle->difusion);
+    reduccion_persistente_liberar(&bucle->reduccion);
+}
+
+/* Límite superior de la iteración k: recorre (a, b] en pasos iguales */
+static double limite_iteracion(IntegracionParams params, long k) {
+    return (k == params.iteraciones - 1) ? params.b
+                                         : params.a + (k + 1) * (params.b - params.a) / params.iteraciones;
+}
+
+/* Modo iterativo: el mismo bucle con colectivas ordinarias y con persistentes. Devuelve la
+ * integral de la última iteración (la de [a, b]) con colectivas persistentes. */
+double calcular_integral_iterativa(IntegracionParams params, int rank, int size) {
+    double tiempos[3], maximos[3];  // Latencia ordinaria, preparación y latencia persistentes
+    double t, total_ordinario = 0.0;
+
+    /* Colectivas ordinarias */
+    IntegracionParams actuales = params;
+    MPI_Barrier(MPI_COMM_WORLD);
+    t = MPI_Wtime();
+    for (long k = 0; k < params.iteraciones; k++) {
+        if (rank == 0) {
+            actuales.b = limite_iteracion(params, k);
+        }
+        MPI_Bcast(&actuales, sizeof(IntegracionParams), MPI_BYTE, 0, MPI_COMM_WORLD);
+        long por_proceso = actuales.n / size;
+        long inicio = rank * por_proceso;
+        long fin = (rank == size - 1) ? actuales.n : inicio + por_proceso;
+        double suma_local = calcular_suma_riemann(actuales, inicio, fin);
+        MPI_Reduce(&suma_local, &total_ordinario, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    }
+    tiempos[0] = (MPI_Wtime() - t) / params.iteraciones;
+
+    /* Colectivas persistentes: se preparan una vez y cada iteración solo las rearranca */
+    BucleIterativo bucle;
+    MPI_Barrier(MPI_COMM_WORLD);
+    t = MPI_Wtime();
+    bucle_iterativo_iniciar(&bucle, params);
+    tiempos[1] = MPI_Wtime() - t;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    t = MPI_Wtime();
+    for (long k = 0; k < params.iteraciones; k++) {
+        if (rank == 0) {
+            bucle.params.b = limite_iteracion(params, k);
+        }
+        bucle_iterativo_paso(&bucle, rank, size);
+    }
+    tiempos[2] = (MPI_Wtime() - t) / params.iteraciones;
+    double total = bucle.suma_total;
+    bucle_iterativo_liberar(&bucle);
+
+    MPI_Reduce(tiempos, maximos, 3, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        printf("Colectivas persistentes: %s.\n", COLECTIVAS_PERSISTENTES_NATIVAS
+                                                     ? "MPI_Bcast_init y MPI_Reduce_init"
+                                                     : "emuladas con MPI_Send_init y MPI_Recv_init");
+        printf("Ordinarias: %.12f. Latencia por iteración: %.2f µs con MPI_Bcast y MPI_Reduce, %.2f µs persistentes "
+               "(%+.1f %%; preparación %.1f µs).\n",
+               total_ordinario, maximos[0] * 1e6, maximos[2] * 1e6,
+               maximos[0] > 0.0 ? 100.0 * (maximos[2] - maximos[0]) / maximos[0] : 0.0, maximos[1] * 1e6);
+    }
+    return total;
+}
+
+/* Operación de MPI que combina estadísticas de Welford (tipo: tres doubles contiguos) */
+void combinar_estadisticas_mpi(void *entrada, void *acumulado, int *cantidad, MPI_Datatype *tipo) {
+    (void)tipo;
+    EstadisticaMC *in = entrada, *acc = acumulado;
+    for (int i = 0; i < *cantidad; i++) {
+        /* MPI calcula acumulado = entrada ∘ acumulado, con la entrada del proceso de menor rango */
+        EstadisticaMC combinada = in[i];
+        estadistica_combinar(&combinada, &acc[i]);
+        acc[i] = combinada;
+    }
+}
+
+/* Integral de Monte Carlo sobre [a, b]^dim. En cada ronda los bloques se reparten como los
+ * subintervalos (tramos contiguos por proceso) y las estadísticas se reducen con una sola
+ * llamada; el proceso raíz informa la estimación parcial y su error estándar. */
+double calcular_integral_montecarlo(IntegracionParams params, int rank, int size, double *error_estandar) {
+    long bloques = (params.n + TAMANO_BLOQUE_MC - 1) / TAMANO_BLOQUE_MC;
+    long rondas = bloques < RONDAS_MC ? bloques : RONDAS_MC;
+    double volumen = pow(params.b - params.a, params.dim);
+    EstadisticaMC total = {0.0, 0.0, 0.0};
+    MPI_Datatype tipo_estadistica;
+    MPI_Op op_combinar;
+
+    MPI_Type_contiguous(3, MPI_DOUBLE, &tipo_estadistica);
+    MPI_Type_commit(&tipo_estadistica);
+    MPI_Op_create(combinar_estadisticas_mpi, 0, &op_combinar);
+
+    for (long ronda = 0; ronda < rondas; ronda++) {
+        long primero = bloques * ronda / rondas;
+        long bloques_ronda = bloques * (ronda + 1) / rondas - primero;
+        long bloques_por_proceso = bloques_ronda / size;
+        long inicio = primero + rank * bloques_por_proceso;
+        long fin = (rank == size - 1) ? primero + bloques_ronda : inicio + bloques_por_proceso;
+        EstadisticaMC local = {0.0, 0.0, 0.0}, ronda_total;
+
+        for (long k = inicio; k < fin; k++) {
+            long muestras = (k == bloques - 1) ? params.n - k * TAMANO_BLOQUE_MC : TAMANO_BLOQUE_MC;
+            EstadisticaMC e = estadistica_bloque_mc(funcion_multidimensional, params.dim, params.a, params.b,
+                                                    params.semilla, (uint64_t)k, muestras);
+            estadistica_combinar(&local, &e);
+        }
+
+        MPI_Reduce(&local, &ronda_total, 1, tipo_estadistica, op_combinar, 0, MPI_COMM_WORLD);
+
+        if (rank == 0) {
+            estadistica_combinar(&total, &ronda_total);
+            printf("  %.0f muestras: %.12f ± %.3e\n", total.n, volumen * total.media,
+                   volumen * estadistica_error_estandar(&total));
+        }
+    }
+
+    MPI_Op_free(&op_combinar);
+    MPI_Type_free(&tipo_estadistica);
+
+    *error_estandar = volumen * estadistica_error_estandar(&total);
+    return volumen * total.media;
+}
+
+/* Operación de MPI que combina estadísticas con covarianza (tipo: seis doubles contiguos) */
+void combinar_estadisticas_control_mpi(void *entrada, void *acumulado, int *cantidad, MPI_Datatype *tipo) {
+    (void)tipo;
+    EstadisticaControl *in = entrada, *acc = acumulado;
+    for (int i = 0; i < *cantidad; i++) {
+        EstadisticaControl combinada = in[i];
+        estadistica_control_combinar(&combinada, &acc[i]);
+        acc[i] = combinada;
+    }
+}
+
+/* Reúne en todos los procesos las estadísticas por estrato de una fase del modo vr */
+void reducir_estadisticas_control(EstadisticaControl *estadisticas, int cantidad) {
+    MPI_Datatype tipo_estadistica;
+    MPI_Op op_combinar;
+
+    MPI_Type_contiguous(6, MPI_DOUBLE, &tipo_estadistica);
+    MPI_Type_commit(&tipo_estadistica);
+    MPI_Op_create(combinar_estadisticas_control_mpi, 0, &op_combinar);
+
+    MPI_Allreduce(MPI_IN_PLACE, estadisticas, cantidad, tipo_estadistica, op_combinar, MPI_COMM_WORLD);
+
+    MPI_Op_free(&op_combinar);
+    MPI_Type_free(&tipo_estadistica);
+}
+
+/* Integral de Monte Carlo con reducción de varianza; con estratificación hay un estrato por
+ * proceso. El proceso raíz informa las muestras de cada estrato. */
+double calcular_integral_reduccion_varianza(IntegracionParams params, int rank, int size, double *error_estandar) {
+    PlanVR plan = {funcion_multidimensional, NULL, integral_control_caja, params.dim, params.a, params.b,
+                   params.tecnicas, (params.tecnicas & TECNICA_ESTRATOS) ? size : 1, params.semilla, 0, NULL, NULL};
+    if (params.tecnicas & TECNICA_CONTROL) {
+        plan.control = control_multidimensional;
+    }
+    EstadisticaControl *por_estrato = malloc(plan.estratos * sizeof(EstadisticaControl));
+
+    double resultado = integral_reduccion_varianza(&plan, params.n, rank, size, reducir_estadisticas_control,
+                                                   por_estrato, error_estandar);
+
+    if (rank == 0 && plan.estratos > 1) {
+        for (int s = 0; s < plan.estratos; s++) {
+            printf("  Estrato %d: %.0f muestras\n", s, por_estrato[s].n);
+        }
+    }
+
+    free(por_estrato);
+    return resultado;
+}
+
+/* Integral por Romberg en paralelo: el nivel k (n·2^k subintervalos) lo calcula un grupo de
+ * procesos de tamaño proporcional a 2^k con la suma de Riemann particionada de siempre. El
+ * proceso raíz extrapola; en *error_estimado queda la diferencia entre los dos últimos
+ * elementos de la diagonal de la tabla. */
+double calcular_integral_romberg(IntegracionParams params, int rank, int size, double *error_estimado) {
+    int niveles = params.niveles;
+    int grupos = niveles < size ? niveles : size;
+    int grupo_nivel[NIVELES_ROMBERG_MAX];
+    int procesos[NIVELES_ROMBERG_MAX];
+    double costo_grupo[NIVELES_ROMBERG_MAX] = {0.0};
+
+    /* LPT: del nivel más fino (más caro) al más grueso, cada uno al grupo menos cargado */
+    for (int k = niveles - 1; k >= 0; k--) {
+        int menor = 0;
+        for (int g = 1; g < grupos; g++) {
+            if (costo_grupo[g] < costo_grupo[menor]) {
+                menor = g;
+            }
+        }
+        grupo_nivel[k] = menor;
+        costo_grupo[menor] += ldexp(1.0, k);
+    }
+
+    /* Procesos por grupo: uno como mínimo y el resto por restos mayores del costo */
+    double costo_total = ldexp(1.0, niveles) - 1.0;
+    int asignados = 0;
+    for (int g = 0; g < grupos; g++) {
+        procesos[g] = 1 + (int)((size - grupos) * costo_grupo[g] / costo_total);
+        asignados += procesos[g];
+    }
+    while (asignados < size) {
+        int mayor = 0;
+        for (int g = 1; g < grupos; g++) {
+            if (costo_grupo[g] / procesos[g] > costo_grupo[mayor] / procesos[mayor]) {
+                mayor = g;
+            }
+        }
+        procesos[mayor]++;
+        asignados++;
+    }
+
+    int color = 0, primero_grupo = 0;
+    while (rank >= primero_grupo + procesos[color]) {
+        primero_grupo += procesos[color];
+        color++;
+    }
+
+    MPI_Comm comm_grupo;
+    int rank_grupo, size_grupo;
+    MPI_Comm_split(MPI_COMM_WORLD, color, rank, &comm_grupo);
+    MPI_Comm_rank(comm_grupo, &rank_grupo);
+    MPI_Comm_size(comm_grupo, &size_grupo);
+
+    /* Cada grupo calcula sus niveles; los demás dejan cero para la suma final */
+    double sumas_locales[NIVELES_ROMBERG_MAX] = {0.0}, sumas[NIVELES_ROMBERG_MAX];
+    double tiempos_locales[NIVELES_ROMBERG_MAX] = {0.0}, tiempos[NIVELES_ROMBERG_MAX];
+    for (int k = 0; k < niveles; k++) {
+        if (grupo_nivel[k] != color) {
+            continue;
+        }
+        IntegracionParams nivel = params;
+        nivel.n = params.n << k;
+        long por_proceso = nivel.n / size_grupo;
+        long inicio = rank_grupo * por_proceso;
+        long fin = (rank_grupo == size_grupo - 1) ? nivel.n : inicio + por_proceso;
+        double suma = 0.0, t0 = MPI_Wtime();
+
+        double suma_local = calcular_suma_riemann(nivel, inicio, fin);
+        MPI_Reduce(&suma_local, &suma, 1, MPI_DOUBLE, MPI_SUM, 0, comm_grupo);
+        tiempos_locales[k] = MPI_Wtime() - t0;
+        if (rank_grupo == 0) {
+            sumas_locales[k] = suma;
+        }
+    }
+    MPI_Comm_free(&comm_grupo);
+
+    MPI_Reduce(sumas_locales, sumas, niveles, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(tiempos_locales, tiempos, niveles, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    /* Tabla de Richardson: R[k][j] = R[k][j-1] + (R[k][j-1] - R[k-1][j-1]) / (4^j - 1) */
+    double resultado = 0.0;
+    *error_estimado = 0.0;
+    if (rank == 0) {
+        double fila_anterior[NIVELES_ROMBERG_MAX], fila[NIVELES_ROMBERG_MAX], diagonal_anterior = 0.0;
+        for (int k = 0; k < niveles; k++) {
+            fila[0] = sumas[k];
+            for (int j = 1; j <= k; j++) {
+                fila[j] = fila[j - 1] + (fila[j - 1] - fila_anterior[j - 1]) / (ldexp(1.0, 2 * j) - 1.0);
+            }
+            printf("  Nivel %2d (%ld subintervalos, grupo %d de %d procesos, %.6f s): %.15f -> %.15f\n",
+                   k, params.n << k, grupo_nivel[k], procesos[grupo_nivel[k]], tiempos[k], sumas[k], fila[k]);
+            diagonal_anterior = k > 0 ? fila_anterior[k - 1] : 0.0;
+            memcpy(fila_anterior, fila, sizeof(fila));
+        }
+        resultado = fila[niveles - 1];
+        *error_estimado = fabs(fila[niveles - 1] - diagonal_anterior);
+    }
+    return resultado;
+}
+
+/* Integral de cuasi-Monte Carlo. Los procesos forman min(réplicas, procesos) grupos; el grupo g
+ * calcula las réplicas g, g + grupos, ..., con los bloques de puntos repartidos entre sus
+ * miembros. Las estimaciones de todas las réplicas se reúnen en el proceso raíz. */
+double calcular_integral_cuasi_montecarlo(IntegracionParams params, int rank, int size, double *error_estandar) {
+    long bloques = (params.n + TAMANO_BLOQUE_MC - 1) / TAMANO_BLOQUE_MC;
+    double volumen = pow(params.b - params.a, params.dim);
+    double *estimaciones = calloc(params.replicas, sizeof(double));
+    double *todas = calloc(params.replicas, sizeof(double));
+    Sobol sobol = {0};
+    Reticula reticula = {0};
+
+    if (params.modo == MODO_SOBOL) {
+        sobol_iniciar(&sobol, params.dim);
+    } else {
+        /* Cada proceso evalúa una parte de los candidatos a α y se elige el de menor P_2 */
+        int candidatos = reticula_numero_candidatos((uint64_t)params.n, params.dim);
+        struct { double criterio; int candidato; } mejor_local = {INFINITY, 0}, mejor;
+        for (int c = rank; c < candidatos; c += size) {
+            double criterio = reticula_criterio_p2((uint64_t)params.n, params.dim,
+                                                   reticula_candidato((uint64_t)params.n, c));
+            if (criterio < mejor_local.criterio) {
+                mejor_local.criterio = criterio;
+                mejor_local.candidato = c;
+            }
+        }
+        MPI_Allreduce(&mejor_local, &mejor, 1, MPI_DOUBLE_INT, MPI_MINLOC, MPI_COMM_WORLD);
+        uint64_t alfa = reticula_candidato((uint64_t)params.n, mejor.candidato);
+        reticula_iniciar(&reticula, (uint64_t)params.n, params.dim, alfa);
+        if (rank == 0) {
+            printf("  Retícula de Korobov con α = %llu (P_2 = %.3e, %d candidatos).\n",
+                   (unsigned long long)alfa, mejor.criterio, candidatos);
+        }
+    }
+
+    /* Grupos de procesos que calculan réplicas distintas de forma concurrente */
+    int grupos = params.replicas < size ? params.replicas : size;
+    int color = rank % grupos;
+    int rank_grupo, size_grupo;
+    MPI_Comm comm_grupo;
+    MPI_Comm_split(MPI_COMM_WORLD, color, rank, &comm_grupo);
+    MPI_Comm_rank(comm_grupo, &rank_grupo);
+    MPI_Comm_size(comm_grupo, &size_grupo);
+
+    long bloques_por_proceso = bloques / size_grupo;
+    long primero = rank_grupo * bloques_por_proceso;
+    long ultimo = (rank_grupo == size_grupo - 1) ? bloques : primero + bloques_por_proceso;
+
+    for (int r = color; r < params.replicas; r += grupos) {
+        uint32_t digital[DIM_MAX_QMC];
+        double modulo_uno[DIM_MAX_QMC];
+        double suma_local = 0.0, suma_grupo = 0.0;
+        desplazamientos_replica(params.semilla, r, params.dim, digital, modulo_uno);
+
+        for (long k = primero; k < ultimo; k++) {
+            uint64_t inicio = (uint64_t)k * TAMANO_BLOQUE_MC;
+            uint64_t fin = (k == bloques - 1) ? (uint64_t)params.n : inicio + TAMANO_BLOQUE_MC;
+            suma_local += (params.modo == MODO_SOBOL)
+                ? sobol_suma_bloque(&sobol, digital, inicio, fin, funcion_multidimensional, params.a, params.b)
+                : reticula_suma_bloque(&reticula, modulo_uno, inicio, fin, funcion_multidimensional,
+                                       params.a, params.b);
+        }
+
+        MPI_Reduce(&suma_local, &suma_grupo, 1, MPI_DOUBLE, MPI_SUM, 0, comm_grupo);
+        if (rank_grupo == 0) {
+            estimaciones[r] = volumen * suma_grupo / params.n;
+        }
+    }
+
+    MPI_Reduce(estimaciones, todas, params.replicas, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    EstadisticaMC estadistica = {0.0, 0.0, 0.0};
+    if (rank == 0) {
+        for (int r = 0; r < params.replicas; r++) {
+            estadistica_agregar(&estadistica, todas[r]);
+            printf("  Réplica %d: %.12f\n", r, todas[r]);
+        }
+    }
+
+    MPI_Comm_free(&comm_grupo);
+    free(estimaciones);
+    free(todas);
+
+    *error_estandar = estadistica_error_estandar(&estadistica);
+    return estadistica.media;
+}
+
+/* Fija cada proceso según la política, con los procesos de la misma máquina en el papel de los
+ * hilos, y reúne en el proceso raíz la descripción de la colocación */
+void colocar_procesos(PoliticaAfinidad politica, int rank, int size) {
+    static Topologia topologia;
+    MPI_Comm comm_maquina;
+    int rank_local, size_local, longitud_nombre;
+    char maquina[MPI_MAX_PROCESSOR_NAME];
+    char descripcion[256], descripcion_cpus[96];
+    cpu_set_t conjunto;
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &comm_maquina);
+    MPI_Comm_rank(comm_maquina, &rank_local);
+    MPI_Comm_size(comm_maquina, &size_local);
+    MPI_Get_processor_name(maquina, &longitud_nombre);
+
+    topologia_descubrir(&topologia, 0);
+    afinidad_conjunto(&topologia, politica, rank_local, size_local, &conjunto);
+    int fijado = afinidad_fijar_hilo(&conjunto);
+    afinidad_describir(&topologia, &conjunto, descripcion_cpus, sizeof(descripcion_cpus));
+    snprintf(descripcion, sizeof(descripcion), "%.64s, local %d → %s%s", maquina, rank_local, descripcion_cpus,
+             fijado ? "" : " (rechazada por el sistema)");
+
+    char *descripciones = (rank == 0) ? malloc((size_t)size * sizeof(descripcion)) : NULL;
+    MPI_Gather(descripcion, sizeof(descripcion), MPI_CHAR, descripciones, sizeof(descripcion), MPI_CHAR, 0,
+               MPI_COMM_WORLD);
+    if (rank == 0) {
+        topologia_imprimir(&topologia);
+        printf("Colocación %s de %d procesos:\n", afinidad_nombre(politica), size);
+        for (int r = 0; r < size; r++) {
+            printf("  Proceso %d (%s)\n", r, descripciones + (size_t)r * sizeof(descripcion));
+        }
+        free(descripciones);
+    }
+    MPI_Comm_free(&comm_maquina);
+}
+
+void imprimir_uso(const char *programa) {
+    fprintf(stderr, "Uso: %s <a> <b> <n> [mc <dim> [semilla]]\n", programa);
+    fprintf(stderr, "     %s <a> <b> <n> <sobol|reticula> <dim> <replicas> [semilla]\n", programa);
+    fprintf(stderr, "     %s <a> <b> <n> vr <dim> <tecnicas> [semilla]\n", programa);
+    fprintf(stderr, "     %s <a> <b> <n> romberg <niveles>\n", programa);
+    fprintf(stderr, "     %s <a> <b> <n> reproducible\n", programa);
+    fprintf(stderr, "     %s <a> <b> <n> lote <trabajos> [ventana]\n", programa);
+    fprintf(stderr, "     %s <a> <b> <n> iterativo <iteraciones>\n", programa);
+    fprintf(stderr, "     %s <a> <b> <n> granja <trabajos> [semilla]\n", programa);
+    fprintf(stderr, "Donde:\n");
+    fprintf(stderr, "    <a> : Límite inferior de integración (double)\n");
+    fprintf(stderr, "    <b> : Límite superior de integración (double)\n");
+    fprintf(stderr, "    <n> : Número de subintervalos, o de muestras en modo mc (entero positivo)\n");
+    fprintf(stderr, "    mc <dim> [semilla] : Monte Carlo en dimensión dim (1 a %d)\n", DIM_MAX_MC);
+    fprintf(stderr, "    sobol|reticula <dim> <replicas> [semilla] : Cuasi-Monte Carlo en dimensión dim (1 a %d)\n",
+            DIM_MAX_QMC);
+    fprintf(stderr, "    vr <dim> <tecnicas> [semilla] : Monte Carlo con reducción de varianza; tecnicas es una lista\n");
+    fprintf(stderr, "                                    separada por comas de estratos, antitetico y control\n");
+    fprintf(stderr, "    romberg <niveles> : Extrapolación de Richardson con n, 2n, ..., 2^(niveles-1)·n (2 a %d niveles)\n",
+            NIVELES_ROMBERG_MAX);
+    fprintf(stderr, "    reproducible : Suma exacta con superacumulador, idéntica bit a bit con cualquier número de procesos\n");
+    fprintf(stderr, "    lote <trabajos> [ventana] : Trabajos de n subintervalos con reducciones en tubería (ventana por defecto %d)\n",
+            VENTANA_LOTE);
+    fprintf(stderr, "                                y por oleadas de tamaño adaptativo\n");
+    fprintf(stderr, "    iterativo <iteraciones> : Bucle de integrales hasta b con colectivas persistentes y ordinarias\n");
+    fprintf(stderr, "    granja <trabajos> [semilla] : Lote heterogéneo (hasta n subintervalos por trabajo) repartido por costo\n");
+    fprintf(stderr, "Variable de entorno RIEMANN_AFINIDAD: compacta, dispersa, fisicos o numa\n");
+}
+
+/* Interpreta la línea de comandos en el proceso raíz; devuelve 0 si es inválida */
+int leer_argumentos(int argc, char *argv[], IntegracionParams *params) {
+    if (argc < 4) {
+        imprimir_uso(argv[0]);
+        return 0;
+    }
+
+    params->a = atof(argv[1]);
+    params->b = atof(argv[2]);
+    params->n = atol(argv[3]);
+    params->modo = MODO_RIEMANN;
+    params->dim = 1;
+    params->replicas = 0;
+    params->tecnicas = 0;
+    params->niveles = 0;
+    params->semilla = SEMILLA_MC;
+    params->trabajos = 0;
+    params->ventana = VENTANA_LOTE;
+    params->iteraciones = 0;
+
+    int politica_valida;
+    params->afinidad = afinidad_leer_politica(getenv("RIEMANN_AFINIDAD"), &politica_valida);
+    if (!politica_valida) {
+        fprintf(stderr, "RIEMANN_AFINIDAD debe ser compacta, dispersa, fisicos o numa.\n");
+        return 0;
+    }
+
+    if (argc == 4) {
+        /* Suma de Riemann clásica */
+    } else if (strcmp(argv[4], "mc") == 0 && argc >= 6 && argc <= 7) {
+        params->modo = MODO_MONTECARLO;
+        params->dim = atoi(argv[5]);
+        if (argc == 7) {
+            params->semilla = strtoull(argv[6], NULL, 10);
+        }
+    } else if ((strcmp(argv[4], "sobol") == 0 || strcmp(argv[4], "reticula") == 0) && argc >= 7 && argc <= 8) {
+        params->modo = strcmp(argv[4], "sobol") == 0 ? MODO_SOBOL : MODO_RETICULA;
+        params->dim = atoi(argv[5]);
+        params->replicas = atoi(argv[6]);
+        if (argc == 8) {
+            params->semilla = strtoull(argv[7], NULL, 10);
+        }
+    } else if (strcmp(argv[4], "vr") == 0 && argc >= 7 && argc <= 8) {
+        params->modo = MODO_VR;
+        params->dim = atoi(argv[5]);
+        params->tecnicas = leer_tecnicas_vr(argv[6]);
+        if (argc == 8) {
+            params->semilla = strtoull(argv[7], NULL, 10);
+        }
+    } else if (strcmp(argv[4], "romberg") == 0 && argc == 6) {
+        params->modo = MODO_ROMBERG;
+        params->niveles = atoi(argv[5]);
+    } else if (strcmp(argv[4], "reproducible") == 0 && argc == 5) {
+        params->modo = MODO_REPRODUCIBLE;
+    } else if (strcmp(argv[4], "lote") == 0 && argc >= 6 && argc <= 7) {
+        params->modo = MODO_LOTE;
+        params->trabajos = atol(argv[5]);
+        if (argc == 7) {
+            params->ventana = atoi(argv[6]);
+        }
+    } else if (strcmp(argv[4], "granja") == 0 && argc >= 6 && argc <= 7) {
+        params->modo = MODO_GRANJA;
+        params->trabajos = atol(argv[5]);
+        if (argc == 7) {
+            params->semilla = strtoull(argv[6], NULL, 10);
+        }
+    } else if (strcmp(argv[4], "iterativo") == 0 && argc == 6) {
+        params->modo = MODO_ITERATIVO;
+        params->iteraciones = atol(argv[5]);
+    } else {
+        imprimir_uso(argv[0]);
+        return 0;
+    }
+
+    if (params->n <= 0) {
+        fprintf(stderr, "El número de subintervalos debe ser un entero positivo.\n");
+        return 0;
+    }
+    if ((params->modo == MODO_MONTECARLO || params->modo == MODO_VR) && (params->dim <= 0 || params->dim > DIM_MAX_MC)) {
+        fprintf(stderr, "La dimensión debe estar entre 1 y %d.\n", DIM_MAX_MC);
+        return 0;
+    }
+    if (params->modo == MODO_VR && params->tecnicas == 0) {
+        fprintf(stderr, "Las técnicas deben ser estratos, antitetico o control, separadas por comas.\n");
+        return 0;
+    }
+    if ((params->modo == MODO_SOBOL || params->modo == MODO_RETICULA)
+        && (params->dim <= 0 || params->dim > DIM_MAX_QMC || params->replicas < 2
+            || (unsigned long)params->n > UINT32_MAX)) {
+        fprintf(stderr, "La dimensión debe estar entre 1 y %d, las réplicas ser al menos 2 y n menor que 2^32.\n",
+                DIM_MAX_QMC);
+        return 0;
+    }
+    if (params->modo == MODO_LOTE && (params->trabajos <= 0 || params->ventana <= 0)) {
+        fprintf(stderr, "El número de trabajos y la ventana deben ser enteros positivos.\n");
+        return 0;
+    }
+    if (params->modo == MODO_GRANJA && params->trabajos <= 0) {
+        fprintf(stderr, "El número de trabajos debe ser un entero positivo.\n");
+        return 0;
+    }
+    if (params->modo == MODO_ITERATIVO && params->iteraciones <= 0) {
+        fprintf(stderr, "El número de iteraciones debe ser un entero positivo.\n");
+        return 0;
+    }
+    if (params->modo == MODO_ROMBERG
+        && (params->niveles < 2 || params->niveles > NIVELES_ROMBERG_MAX
+            || params->n > (LONG_MAX >> (params->niveles - 1)))) {
+        fprintf(stderr, "Los niveles deben estar entre 2 y %d, y n·2^(niveles-1) caber en un long.\n",
+                NIVELES_ROMBERG_MAX);
+        return 0;
+    }
+    return 1;
+}
+
 int main(int argc, char *argv[]) {
     int rank, size;
     IntegracionParams params;
     double suma_local = 0.0, suma_total = 0.0;
+    double error_estandar = 0.0;
     double start_time, end_time;
 
     /* Inicialización de MPI */
@@ -69,31 +1405,48 @@ int main(int argc, char *argv[]) {
 
     /* Proceso raíz procesa los argumentos de línea de comandos */
     if (rank == 0) {
-        if (argc != 4) {
-            fprintf(stderr, "Uso: %s <a> <b> <n>\n", argv[0]);
-            fprintf(stderr, "Donde:\n");
-            fprintf(stderr, "    <a> : Límite inferior de integración (double)\n");
-            fprintf(stderr, "    <b> : Límite superior de integración (double)\n");
-            fprintf(stderr, "    <n> : Número de subintervalos (entero positivo)\n");
+        if (!leer_argumentos(argc, argv, &params)) {
             MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
         }
 
-        params.a = atof(argv[1]);
-        params.b = atof(argv[2]);
-        params.n = atol(argv[3]);
-
-        if (params.n <= 0) {
-            fprintf(stderr, "El número de subintervalos debe ser un entero positivo.\n");
-            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        if (params.modo == MODO_MONTECARLO) {
+            printf("Aproximando por Monte Carlo la integral de sin(x_1)···sin(x_%d) en [%.6f, %.6f]^%d con %ld muestras.\n",
+                   params.dim, params.a, params.b, params.dim, params.n);
+        } else if (params.modo == MODO_ROMBERG) {
+            printf("Aproximando por Romberg la integral de sin(x) desde %.6f hasta %.6f con %d niveles desde %ld subintervalos.\n",
+                   params.a, params.b, params.niveles, params.n);
+        } else if (params.modo == MODO_VR) {
+            printf("Aproximando por Monte Carlo (%s) la integral de sin(x_1)···sin(x_%d) en [%.6f, %.6f]^%d con %ld evaluaciones.\n",
+                   argv[6], params.dim, params.a, params.b, params.dim, params.n);
+        } else if (params.modo == MODO_SOBOL || params.modo == MODO_RETICULA) {
+            printf("Aproximando por cuasi-Monte Carlo (%s) la integral de sin(x_1)···sin(x_%d) en [%.6f, %.6f]^%d con %ld puntos y %d réplicas.\n",
+                   argv[4], params.dim, params.a, params.b, params.dim, params.n, params.replicas);
+        } else if (params.modo == MODO_LOTE) {
+            printf("Aproximando la integral de sin(x) desde %.6f hasta %.6f con %ld trabajos de %ld subintervalos (ventana %d).\n",
+                   params.a, params.b, params.trabajos, params.n, params.ventana);
+        } else if (params.modo == MODO_GRANJA) {
+            printf("Aproximando la integral de sin(x) desde %.6f hasta %.6f con una granja de %ld trabajos de hasta %ld subintervalos.\n",
+                   params.a, params.b, params.trabajos, params.n);
+        } else if (params.modo == MODO_ITERATIVO) {
+            printf("Aproximando la integral de sin(x) desde %.6f hasta %.6f en %ld iteraciones que mueven el límite superior, con %ld subintervalos.\n",
+                   params.a, params.b, params.iteraciones, params.n);
+        } else if (params.modo == MODO_REPRODUCIBLE) {
+            printf("Aproximando de forma reproducible la integral de sin(x) desde %.6f hasta %.6f con %ld subintervalos.\n",
+                   params.a, params.b, params.n);
+        } else {
+            printf("Aproximando la integral de sin(x) desde %.6f hasta %.6f con %ld subintervalos.\n",
+                   params.a, params.b, params.n);
         }
-
-        printf("Aproximando la integral de sin(x) desde %.6f hasta %.6f con %ld subintervalos.\n",
-               params.a, params.b, params.n);
     }
 
     /* Difusión de los parámetros a todos los procesos */
     MPI_Bcast(&params, sizeof(IntegracionParams), MPI_BYTE, 0, MPI_COMM_WORLD);
 
+    /* Colocación de los procesos (RIEMANN_AFINIDAD) */
+    if (params.afinidad != AFINIDAD_NINGUNA) {
+        colocar_procesos(params.afinidad, rank, size);
+    }
+
     /* Cálculo de la porción de trabajo para cada proceso */
     long subintervalos_por_proceso = params.n / size;
     long inicio = rank * subintervalos_por_proceso;
@@ -103,11 +1456,37 @@ int main(int argc, char *argv[]) {
     MPI_Barrier(MPI_COMM_WORLD);
     start_time = MPI_Wtime();
 
-    /* Cálculo de la suma local */
-    suma_local = calcular_suma_riemann(params, inicio, fin);
+    if (params.modo == MODO_MONTECARLO) {
+        /* Monte Carlo: reparto por bloques y reducción de media y varianza */
+        suma_total = calcular_integral_montecarlo(params, rank, size, &error_estandar);
+    } else if (params.modo == MODO_ROMBERG) {
+        /* Niveles de refinamiento concurrentes en grupos de procesos */
+        suma_total = calcular_integral_romberg(params, rank, size, &error_estandar);
+    } else if (params.modo == MODO_VR) {
+        /* Monte Carlo con reducción de varianza */
+        suma_total = calcular_integral_reduccion_varianza(params, rank, size, &error_estandar);
+    } else if (params.modo == MODO_SOBOL || params.modo == MODO_RETICULA) {
+        /* Cuasi-Monte Carlo: réplicas concurrentes en grupos de procesos */
+        suma_total = calcular_integral_cuasi_montecarlo(params, rank, size, &error_estandar);
+    } else if (params.modo == MODO_LOTE) {
+        /* Lote de trabajos con reducciones bloqueantes y en tubería */
+        suma_total = calcular_integral_lote(params, rank, size);
+    } else if (params.modo == MODO_GRANJA) {
+        /* Lote heterogéneo repartido por costo */
+        suma_total = calcular_integral_granja(params, rank, size);
+    } else if (params.modo == MODO_ITERATIVO) {
+        /* Bucle de integrales con colectivas persistentes */
+        suma_total = calcular_integral_iterativa(params, rank, size);
+    } else if (params.modo == MODO_REPRODUCIBLE) {
+        /* Suma exacta con superacumuladores y reducción propia */
+        suma_total = calcular_integral_reproducible(params, rank, inicio, fin);
+    } else {
+        /* Cálculo de la suma local */
+        suma_local = calcular_suma_riemann(params, inicio, fin);
 
-    /* Reducción de las sumas locales para obtener la suma total */
-    MPI_Reduce(&suma_local, &suma_total, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        /* Reducción de las sumas locales para obtener la suma total */
+        MPI_Reduce(&suma_local, &suma_total, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    }
 
     /* Sincronización después del cálculo */
     MPI_Barrier(MPI_COMM_WORLD);
@@ -116,6 +1495,12 @@ int main(int argc, char *argv[]) {
     /* Proceso raíz muestra el resultado y el tiempo de ejecución */
     if (rank == 0) {
         printf("Resultado de la integral aproximada: %.12f\n", suma_total);
+        if (params.modo == MODO_ROMBERG) {
+            printf("Error estimado: %.3e\n", error_estandar);
+        } else if (params.modo != MODO_RIEMANN && params.modo != MODO_REPRODUCIBLE && params.modo != MODO_LOTE
+                   && params.modo != MODO_ITERATIVO && params.modo != MODO_GRANJA) {
+            printf("Error estándar: %.3e\n", error_estandar);
+        }
         printf("Tiempo de ejecución: %.6f segundos.\n", end_time - start_time);
     }
 
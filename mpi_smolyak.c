@@ -0,0 +1,436 @@
+/*
+ * Programa: mpi_smolyak.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Este programa aproxima integrales suaves de dimensión moderada (5 a 20) sobre [a, b]^dim
+ * con cuadratura de rejilla dispersa de Smolyak, construida con la técnica de combinación
+ * a partir de reglas de Clenshaw-Curtis anidadas:
+ *     A(q, d) = Σ_{q-d+1 <= |l| <= q} (-1)^{q-|l|} C(d-1, q-|l|) U^{l_1} ⊗ ... ⊗ U^{l_d},
+ * con q = d + nivel - 1. Como las reglas son anidadas, los nodos de todos los productos
+ * tensoriales caen en la rejilla 1D más fina y se fusionan en un único conjunto de puntos con
+ * pesos combinados, que es mucho menor que la rejilla tensorial completa.
+ *
+ * El conjunto de puntos y pesos se calcula una sola vez por (dim, nivel) y se guarda en un
+ * archivo de caché (smolyak_d<dim>_n<nivel>.cache); las ejecuciones siguientes lo leen sin
+ * reconstruirlo. Los puntos se reparten en tramos contiguos entre procesos y cada proceso los
+ * evalúa por lotes en paralelo con hilos de OpenMP.
+ *
+ * Compilación:
+ *     mpicc -fopenmp -O2 -o mpi_smolyak mpi_smolyak.c -lm
+ *
+ * Uso:
+ *     mpirun -np <número_de_procesos> ./mpi_smolyak <a> <b> <dim> <nivel> <numero_de_hilos>
+ *     Donde:
+ *         <a> : Límite inferior de integración en cada dimensión (double)
+ *         <b> : Límite superior de integración en cada dimensión (double)
+ *         <dim> : Dimensión de la integral (1 a 20)
+ *         <nivel> : Nivel de la rejilla dispersa (1 a 12)
+ *         <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)
+ *
+ * Ejemplo:
+ *     mpirun -np 4 ./mpi_smolyak 0 1 10 5 2
+ */
+
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DIM_MAX 20
+#define NIVEL_MAX 12
+#define TAMANO_LOTE 256
+#define MAGIA_CACHE "SMOLYAK1"
+
+/* Definición de la función a integrar */
+double funcion(const double *x, int dim) {
+    double suma = 0.0;
+    for (int d = 0; d < dim; d++) {
+        suma += x[d];
+    }
+    return exp(suma / dim); // A quien lea esto, puede cambiar la función a integrar por cualquier otra función que desee.
+}
+
+/* Estructura para almacenar los parámetros de la integral */
+typedef struct {
+    double a;      // Límite inferior en cada dimensión
+    double b;      // Límite superior en cada dimensión
+    int dim;       // Dimensión
+    int nivel;     // Nivel de Smolyak
+    int hilos;     // Hilos de OpenMP por proceso
+} SmolyakParams;
+
+/* Rejilla dispersa en coordenadas de referencia [-1, 1]^dim; pesos para ese dominio */
+typedef struct {
+    long puntos;
+    double *nodos;   // nodos[i * dim + d]
+    double *pesos;
+} RejillaDispersa;
+
+/* Tabla hash de puntos, indexada por sus coordenadas enteras en la rejilla 1D más fina */
+typedef struct {
+    int dim;
+    long capacidad;
+    long cantidad;
+    unsigned short *claves;  // claves[ranura * dim + d]
+    double *pesos;
+    char *ocupada;
+} TablaPuntos;
+
+/* Número de nodos de Clenshaw-Curtis del nivel l */
+static long nodos_cc(int l) {
+    return l == 1 ? 1 : (1L << (l - 1)) + 1;
+}
+
+/* Pesos de Clenshaw-Curtis del nivel l en [-1, 1] */
+static void pesos_cc(int l, double *pesos) {
+    if (l == 1) {
+        pesos[0] = 2.0;
+        return;
+    }
+    long n = nodos_cc(l) - 1;
+    for (long j = 0; j <= n; j++) {
+        double s = 0.0;
+        for (long k = 1; k <= n / 2; k++) {
+            double b = (2 * k == n) ? 1.0 : 2.0;
+            s += b / (4.0 * k * k - 1.0) * cos(2.0 * M_PI * k * j / n);
+        }
+        double c = (j == 0 || j == n) ? 1.0 : 2.0;
+        pesos[j] = c / n * (1.0 - s);
+    }
+}
+
+static unsigned long hash_clave(const unsigned short *clave, int dim) {
+    unsigned long h = 1469598103934665603UL;
+    for (int d = 0; d < dim; d++) {
+        h = (h ^ clave[d]) * 1099511628211UL;
+    }
+    return h;
+}
+
+static void tabla_crear(TablaPuntos *t, int dim, long capacidad) {
+    t->dim = dim;
+    t->capacidad = capacidad;
+    t->cantidad = 0;
+    t->claves = malloc(capacidad * dim * sizeof(unsigned short));
+    t->pesos = malloc(capacidad * sizeof(double));
+    t->ocupada = calloc(capacidad, 1);
+}
+
+static void tabla_liberar(TablaPuntos *t) {
+    free(t->claves);
+    free(t->pesos);
+    free(t->ocupada);
+}
+
+static void tabla_sumar(TablaPuntos *t, const unsigned short *clave, double peso);
+
+static void tabla_crecer(TablaPuntos *t) {
+    TablaPuntos nueva;
+    tabla_crear(&nueva, t->dim, 2 * t->capacidad);
+    for (long i = 0; i < t->capacidad; i++) {
+        if (t->ocupada[i]) {
+            tabla_sumar(&nueva, &t->claves[i * t->dim], t->pesos[i]);
+        }
+    }
+    tabla_liberar(t);
+    *t = nueva;
+}
+
+static void tabla_sumar(TablaPuntos *t, const unsigned short *clave, double peso) {
+    if (2 * (t->cantidad + 1) > t->capacidad) {
+        tabla_crecer(t);
+    }
+    long i = (long)(hash_clave(clave, t->dim) & (unsigned long)(t->capacidad - 1));
+    while (t->ocupada[i] && memcmp(&t->claves[i * t->dim], clave, t->dim * sizeof(unsigned short)) != 0) {
+        i = (i + 1) & (t->capacidad - 1);
+    }
+    if (!t->ocupada[i]) {
+        t->ocupada[i] = 1;
+        memcpy(&t->claves[i * t->dim], clave, t->dim * sizeof(unsigned short));
+        t->pesos[i] = 0.0;
+        t->cantidad++;
+    }
+    t->pesos[i] += peso;
+}
+
+static double coeficiente_binomial(int n, int k) {
+    double c = 1.0;
+    for (int i = 1; i <= k; i++) {
+        c = c * (n - k + i) / i;
+    }
+    return c;
+}
+
+/* Suma a la tabla el producto tensorial U^{l_1} ⊗ ... ⊗ U^{l_d} multiplicado por 'coeficiente' */
+static void agregar_producto(TablaPuntos *t, const int *l, int nivel, double coeficiente,
+                             double pesos_1d[][(1 << (NIVEL_MAX - 1)) + 1]) {
+    int dim = t->dim;
+    long indices[DIM_MAX] = {0};
+    unsigned short clave[DIM_MAX];
+
+    for (;;) {
+        double peso = coeficiente;
+        for (int d = 0; d < dim; d++) {
+            /* Índice del nodo en la rejilla más fina, de 2^(nivel-1) intervalos */
+            if (l[d] == 1) {
+                clave[d] = (unsigned short)(nivel == 1 ? 0 : 1 << (nivel - 2));
+            } else {
+                clave[d] = (unsigned short)(indices[d] << (nivel - l[d]));
+            }
+            peso *= pesos_1d[l[d]][indices[d]];
+        }
+        tabla_sumar(t, clave, peso);
+
+        int d = 0;
+        while (d < dim && ++indices[d] == nodos_cc(l[d])) {
+            indices[d] = 0;
+            d++;
+        }
+        if (d == dim) {
+            break;
+        }
+    }
+}
+
+/* Recorre los multiíndices l >= 1 con |l| = objetivo */
+static void recorrer_multiindices(TablaPuntos *t, int *l, int d, int restante, int nivel,
+                                  double coeficiente, double pesos_1d[][(1 << (NIVEL_MAX - 1)) + 1]) {
+    if (d == t->dim - 1) {
+        if (restante >= 1 && restante <= nivel) {
+            l[d] = restante;
+            agregar_producto(t, l, nivel, coeficiente, pesos_1d);
+        }
+        return;
+    }
+    for (int v = 1; v <= nivel && v <= restante - (t->dim - 1 - d); v++) {
+        l[d] = v;
+        recorrer_multiindices(t, l, d + 1, restante - v, nivel, coeficiente, pesos_1d);
+    }
+}
+
+/* Construye la rejilla dispersa con la técnica de combinación */
+static void construir_rejilla(int dim, int nivel, RejillaDispersa *rejilla) {
+    static double pesos_1d[NIVEL_MAX + 1][(1 << (NIVEL_MAX - 1)) + 1];
+    int q = dim + nivel - 1;
+    int l[DIM_MAX];
+    TablaPuntos tabla;
+
+    for (int k = 1; k <= nivel; k++) {
+        pesos_cc(k, pesos_1d[k]);
+    }
+
+    tabla_crear(&tabla, dim, 1024);
+    int minimo = q - dim + 1 > dim ? q - dim + 1 : dim;
+    for (int suma = minimo; suma <= q; suma++) {
+        double coeficiente = ((q - suma) % 2 ? -1.0 : 1.0) * coeficiente_binomial(dim - 1, q - suma);
+        recorrer_multiindices(&tabla, l, 0, suma, nivel, coeficiente, pesos_1d);
+    }
+
+    long finos = nivel == 1 ? 0 : 1L << (nivel - 1);
+    rejilla->puntos = 0;
+    rejilla->nodos = malloc(tabla.cantidad * dim * sizeof(double));
+    rejilla->pesos = malloc(tabla.cantidad * sizeof(double));
+    for (long i = 0; i < tabla.capacidad; i++) {
+        if (!tabla.ocupada[i] || tabla.pesos[i] == 0.0) {
+            continue;
+        }
+        for (int d = 0; d < dim; d++) {
+            unsigned short j = tabla.claves[i * dim + d];
+            rejilla->nodos[rejilla->puntos * dim + d] = finos == 0 ? 0.0 : cos(M_PI * j / finos);
+        }
+        rejilla->pesos[rejilla->puntos] = tabla.pesos[i];
+        rejilla->puntos++;
+    }
+    tabla_liberar(&tabla);
+}
+
+static int leer_cache(const char *ruta, int dim, int nivel, RejillaDispersa *rejilla) {
+    FILE *archivo = fopen(ruta, "rb");
+    if (archivo == NULL) {
+        return 0;
+    }
+    char magia[8];
+    int dim_archivo, nivel_archivo;
+    long puntos;
+    int correcto = fread(magia, 1, 8, archivo) == 8 && memcmp(magia, MAGIA_CACHE, 8) == 0
+                   && fread(&dim_archivo, sizeof(int), 1, archivo) == 1 && dim_archivo == dim
+                   && fread(&nivel_archivo, sizeof(int), 1, archivo) == 1 && nivel_archivo == nivel
+                   && fread(&puntos, sizeof(long), 1, archivo) == 1 && puntos > 0;
+    if (correcto) {
+        rejilla->puntos = puntos;
+        rejilla->nodos = malloc(puntos * dim * sizeof(double));
+        rejilla->pesos = malloc(puntos * sizeof(double));
+        correcto = fread(rejilla->nodos, sizeof(double), puntos * dim, archivo) == (size_t)(puntos * dim)
+                   && fread(rejilla->pesos, sizeof(double), puntos, archivo) == (size_t)puntos;
+        if (!correcto) {
+            free(rejilla->nodos);
+            free(rejilla->pesos);
+        }
+    }
+    fclose(archivo);
+    return correcto;
+}
+
+static void escribir_cache(const char *ruta, int dim, int nivel, const RejillaDispersa *rejilla) {
+    FILE *archivo = fopen(ruta, "wb");
+    if (archivo == NULL) {
+        fprintf(stderr, "Aviso: no se pudo escribir la caché %s.\n", ruta);
+        return;
+    }
+    fwrite(MAGIA_CACHE, 1, 8, archivo);
+    fwrite(&dim, sizeof(int), 1, archivo);
+    fwrite(&nivel, sizeof(int), 1, archivo);
+    fwrite(&rejilla->puntos, sizeof(long), 1, archivo);
+    fwrite(rejilla->nodos, sizeof(double), rejilla->puntos * dim, archivo);
+    fwrite(rejilla->pesos, sizeof(double), rejilla->puntos, archivo);
+    fclose(archivo);
+}
+
+/* Suma ponderada sobre los puntos locales, evaluados por lotes en paralelo */
+double calcular_suma_smolyak(const SmolyakParams *params, const double *nodos, const double *pesos,
+                             long puntos) {
+    int dim = params->dim;
+    double centro = 0.5 * (params->a + params->b);
+    double semiancho = 0.5 * (params->b - params->a);
+    long lotes = (puntos + TAMANO_LOTE - 1) / TAMANO_LOTE;
+    double suma = 0.0;
+
+    #pragma omp parallel for schedule(dynamic, 4) num_threads(params->hilos) reduction(+:suma)
+    for (long lote = 0; lote < lotes; lote++) {
+        long inicio = lote * TAMANO_LOTE;
+        long fin = inicio + TAMANO_LOTE < puntos ? inicio + TAMANO_LOTE : puntos;
+        double x[DIM_MAX];
+        double suma_lote = 0.0;
+        for (long i = inicio; i < fin; i++) {
+            for (int d = 0; d < dim; d++) {
+                x[d] = centro + semiancho * nodos[i * dim + d];
+            }
+            suma_lote += pesos[i] * funcion(x, dim);
+        }
+        suma += suma_lote;
+    }
+
+    return suma * pow(semiancho, dim);
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+    SmolyakParams params;
+    RejillaDispersa rejilla = {0, NULL, NULL};
+    double suma_local = 0.0, suma_total = 0.0;
+    double start_time, end_time;
+
+    /* Inicialización de MPI */
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    /* Proceso raíz procesa los argumentos y obtiene la rejilla (de la caché o construida) */
+    if (rank == 0) {
+        if (argc != 6) {
+            fprintf(stderr, "Uso: %s <a> <b> <dim> <nivel> <numero_de_hilos>\n", argv[0]);
+            fprintf(stderr, "Donde:\n");
+            fprintf(stderr, "    <a> : Límite inferior de integración en cada dimensión (double)\n");
+            fprintf(stderr, "    <b> : Límite superior de integración en cada dimensión (double)\n");
+            fprintf(stderr, "    <dim> : Dimensión de la integral (1 a %d)\n", DIM_MAX);
+            fprintf(stderr, "    <nivel> : Nivel de la rejilla dispersa (1 a %d)\n", NIVEL_MAX);
+            fprintf(stderr, "    <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        params.a = atof(argv[1]);
+        params.b = atof(argv[2]);
+        params.dim = atoi(argv[3]);
+        params.nivel = atoi(argv[4]);
+        params.hilos = atoi(argv[5]);
+
+        if (params.dim < 1 || params.dim > DIM_MAX || params.nivel < 1 || params.nivel > NIVEL_MAX) {
+            fprintf(stderr, "La dimensión debe estar entre 1 y %d y el nivel entre 1 y %d.\n", DIM_MAX, NIVEL_MAX);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (params.hilos <= 0) {
+            fprintf(stderr, "El número de hilos debe ser un entero positivo.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        char ruta[64];
+        snprintf(ruta, sizeof(ruta), "smolyak_d%d_n%d.cache", params.dim, params.nivel);
+        double t0 = MPI_Wtime();
+        if (leer_cache(ruta, params.dim, params.nivel, &rejilla)) {
+            printf("Rejilla leída de %s en %.6f segundos.\n", ruta, MPI_Wtime() - t0);
+        } else {
+            construir_rejilla(params.dim, params.nivel, &rejilla);
+            escribir_cache(ruta, params.dim, params.nivel, &rejilla);
+            printf("Rejilla construida y guardada en %s en %.6f segundos.\n", ruta, MPI_Wtime() - t0);
+        }
+
+        printf("Aproximando la integral %dD sobre [%.6f, %.6f]^%d con Smolyak de nivel %d (%ld puntos).\n",
+               params.dim, params.a, params.b, params.dim, params.nivel, rejilla.puntos);
+    }
+
+    /* Difusión de los parámetros y reparto de los puntos en tramos contiguos */
+    MPI_Bcast(&params, sizeof(SmolyakParams), MPI_BYTE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&rejilla.puntos, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+
+    int dim = params.dim;
+    long puntos_por_proceso = rejilla.puntos / size;
+    long inicio = rank * puntos_por_proceso;
+    long fin = (rank == size - 1) ? rejilla.puntos : inicio + puntos_por_proceso;
+    long locales = fin - inicio;
+
+    int *cuentas = malloc(size * sizeof(int)), *desplazamientos = malloc(size * sizeof(int));
+    int *cuentas_nodos = malloc(size * sizeof(int)), *desplazamientos_nodos = malloc(size * sizeof(int));
+    for (int p = 0; p < size; p++) {
+        long p_inicio = p * puntos_por_proceso;
+        long p_fin = (p == size - 1) ? rejilla.puntos : p_inicio + puntos_por_proceso;
+        cuentas[p] = (int)(p_fin - p_inicio);
+        desplazamientos[p] = (int)p_inicio;
+        cuentas_nodos[p] = cuentas[p] * dim;
+        desplazamientos_nodos[p] = desplazamientos[p] * dim;
+    }
+
+    double *nodos = malloc((locales > 0 ? locales : 1) * dim * sizeof(double));
+    double *pesos = malloc((locales > 0 ? locales : 1) * sizeof(double));
+    MPI_Scatterv(rejilla.nodos, cuentas_nodos, desplazamientos_nodos, MPI_DOUBLE,
+                 nodos, (int)(locales * dim), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Scatterv(rejilla.pesos, cuentas, desplazamientos, MPI_DOUBLE,
+                 pesos, (int)locales, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    /* Sincronización antes del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    start_time = MPI_Wtime();
+
+    /* Cálculo de la suma local */
+    suma_local = calcular_suma_smolyak(&params, nodos, pesos, locales);
+
+    /* Reducción de las sumas locales para obtener la suma total */
+    MPI_Reduce(&suma_local, &suma_total, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    /* Sincronización después del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    end_time = MPI_Wtime();
+
+    /* Proceso raíz muestra el resultado y el tiempo de ejecución */
+    if (rank == 0) {
+        printf("Resultado de la integral aproximada: %.12f\n", suma_total);
+        printf("Tiempo de ejecución: %.6f segundos.\n", end_time - start_time);
+    }
+
+    free(nodos);
+    free(pesos);
+    free(cuentas);
+    free(desplazamientos);
+    free(cuentas_nodos);
+    free(desplazamientos_nodos);
+    free(rejilla.nodos);
+    free(rejilla.pesos);
+
+    /* Finalización de MPI */
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,326 @@
+/*
+ * Programa: mpi_vegas.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Este programa aproxima integrales sobre [a, b]^dim con el algoritmo VEGAS de Lepage:
+ * Monte Carlo con muestreo por importancia sobre una rejilla separable que se adapta entre
+ * iteraciones. En cada dimensión la rejilla tiene BINS_VEGAS intervalos de igual probabilidad;
+ * un punto uniforme y en (0, 1)^dim se lleva al intervalo floor(y·BINS_VEGAS) y el jacobiano
+ * de la transformación corrige el peso de la muestra.
+ *
+ * En cada iteración las muestras se reparten por bloques de TAMANO_BLOQUE_MC entre procesos e
+ * hilos de OpenMP. Cada hilo acumula la suma de f·J, la de (f·J)² y un histograma por dimensión
+ * y por intervalo con (f·J)²; todo se combina con una sola MPI_Allreduce por iteración. El
+ * proceso raíz redistribuye los límites de los intervalos según el histograma (suavizado y
+ * amortiguado con el exponente ALFA_VEGAS) y difunde la nueva rejilla.
+ *
+ * Las estimaciones de las iteraciones se combinan con pesos 1/σ², y χ²/gl indica si son
+ * consistentes. La primera iteración usa la rejilla uniforme, es decir, es Monte Carlo simple:
+ * su varianza por muestra sirve de referencia para la eficiencia de la última iteración.
+ *
+ * Los aleatorios salen de Philox (montecarlo.h) con un flujo por iteración y bloque, de modo
+ * que las muestras no dependen del número de procesos ni de hilos.
+ *
+ * Compilación:
+ *     mpicc -fopenmp -O2 -o mpi_vegas mpi_vegas.c -lm
+ *
+ * Uso:
+ *     mpirun -np <número_de_procesos> ./mpi_vegas <a> <b> <dim> <muestras_por_iteracion> <iteraciones> <numero_de_hilos> [semilla]
+ *     Donde:
+ *         <a> : Límite inferior de integración en cada dimensión (double)
+ *         <b> : Límite superior de integración en cada dimensión (double)
+ *         <dim> : Dimensión de la integral (1 a DIM_MAX_MC)
+ *         <muestras_por_iteracion> : Muestras de cada iteración (entero positivo)
+ *         <iteraciones> : Número de iteraciones de adaptación (al menos 2)
+ *         <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)
+ *         [semilla] : Semilla de Philox (entero, opcional)
+ *
+ * Ejemplo:
+ *     mpirun -np 4 ./mpi_vegas 0 1 6 1000000 10 2
+ */
+
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "montecarlo.h"
+
+#define BINS_VEGAS 50       // Intervalos de la rejilla por dimensión
+#define ALFA_VEGAS 1.5      // Amortiguamiento del refinamiento (0 congela la rejilla)
+#define SEMILLA_VEGAS 12345
+
+/* Definición de la función a integrar: un pico gaussiano estrecho centrado en 0.5 */
+double funcion(const double *x, int dim) {
+    double r2 = 0.0;
+    for (int d = 0; d < dim; d++) {
+        r2 += (x[d] - 0.5) * (x[d] - 0.5);
+    }
+    return exp(-r2 / (2.0 * 0.05 * 0.05)); // A quien lea esto, puede cambiar la función a integrar por cualquier otra función que desee.
+}
+
+/* Estructura para almacenar los parámetros de la integral */
+typedef struct {
+    double a;           // Límite inferior en cada dimensión
+    double b;           // Límite superior en cada dimensión
+    int dim;            // Dimensión
+    long n;             // Muestras por iteración
+    int iteraciones;    // Iteraciones de adaptación
+    int hilos;          // Hilos de OpenMP por proceso
+    uint64_t semilla;   // Semilla de Philox
+} VegasParams;
+
+/* Rejilla separable: limites[d][i] es el borde izquierdo del intervalo i en (0, 1) */
+typedef struct {
+    int dim;
+    double limites[DIM_MAX_MC][BINS_VEGAS + 1];
+} Rejilla;
+
+static void rejilla_uniforme(Rejilla *r, int dim) {
+    r->dim = dim;
+    for (int d = 0; d < dim; d++) {
+        for (int i = 0; i <= BINS_VEGAS; i++) {
+            r->limites[d][i] = (double)i / BINS_VEGAS;
+        }
+    }
+}
+
+/* Acumula las muestras de un bloque: suma de f·J, de (f·J)² y el histograma de (f·J)²
+ * (BINS_VEGAS entradas por dimensión). */
+static void muestrear_bloque(const Rejilla *r, const VegasParams *p, uint64_t bloque, long muestras,
+                             double *suma, double *suma2, double *histograma) {
+    double u[MUESTRAS_POR_TANDA * DIM_MAX_MC + 1];
+    double x[DIM_MAX_MC];
+    int intervalo[DIM_MAX_MC];
+    int dim = r->dim;
+    int por_muestra = dim + (dim & 1);
+    double volumen = pow(p->b - p->a, dim);
+
+    for (long inicio = 0; inicio < muestras; inicio += MUESTRAS_POR_TANDA) {
+        int tanda = muestras - inicio < MUESTRAS_POR_TANDA ? (int)(muestras - inicio) : MUESTRAS_POR_TANDA;
+        philox_uniformes(p->semilla, bloque, (uint64_t)inicio * por_muestra, tanda * por_muestra, u);
+        for (int s = 0; s < tanda; s++) {
+            double jacobiano = volumen;
+            for (int d = 0; d < dim; d++) {
+                double y = u[s * por_muestra + d] * BINS_VEGAS;
+                int i = y < BINS_VEGAS ? (int)y : BINS_VEGAS - 1;  // u * BINS_VEGAS puede redondear a BINS_VEGAS
+                double izquierdo = r->limites[d][i];
+                double ancho = r->limites[d][i + 1] - izquierdo;
+                x[d] = p->a + (p->b - p->a) * (izquierdo + (y - i) * ancho);
+                jacobiano *= ancho * BINS_VEGAS;
+                intervalo[d] = i;
+            }
+            double valor = funcion(x, dim) * jacobiano;
+            double cuadrado = valor * valor;
+            *suma += valor;
+            *suma2 += cuadrado;
+            for (int d = 0; d < dim; d++) {
+                histograma[d * BINS_VEGAS + intervalo[d]] += cuadrado;
+            }
+        }
+    }
+}
+
+/* Redistribuye los límites de cada dimensión para que todos los intervalos reciban la misma
+ * parte del histograma suavizado y comprimido (Lepage, 1978). */
+static void refinar_rejilla(Rejilla *r, const double *histograma) {
+    double peso[BINS_VEGAS];
+    double nuevos[BINS_VEGAS + 1];
+
+    for (int d = 0; d < r->dim; d++) {
+        const double *h = &histograma[d * BINS_VEGAS];
+        double total = 0.0;
+
+        /* Suavizado con los vecinos para no seguir el ruido de un solo intervalo */
+        for (int i = 0; i < BINS_VEGAS; i++) {
+            double izquierda = i > 0 ? h[i - 1] : h[i];
+            double derecha = i < BINS_VEGAS - 1 ? h[i + 1] : h[i];
+            peso[i] = (i == 0 || i == BINS_VEGAS - 1) ? (h[i] + (i == 0 ? derecha : izquierda)) / 2.0
+                                                      : (izquierda + h[i] + derecha) / 3.0;
+            total += peso[i];
+        }
+        if (total <= 0.0) {
+            continue;
+        }
+
+        /* Compresión ((1 - p)/ln(1/p))^α: la rejilla se mueve sin oscilar entre iteraciones */
+        double suma_pesos = 0.0;
+        for (int i = 0; i < BINS_VEGAS; i++) {
+            double fraccion = peso[i] / total;
+            peso[i] = fraccion > 0.0 && fraccion < 1.0 ? pow((1.0 - fraccion) / log(1.0 / fraccion), ALFA_VEGAS) : 0.0;
+            suma_pesos += peso[i];
+        }
+        if (suma_pesos <= 0.0) {
+            continue;
+        }
+
+        /* Cada nuevo intervalo acumula suma_pesos / BINS_VEGAS del peso de los anteriores */
+        double por_intervalo = suma_pesos / BINS_VEGAS;
+        double acumulado = 0.0;
+        int i = 0;
+        nuevos[0] = 0.0;
+        for (int k = 1; k < BINS_VEGAS; k++) {
+            double objetivo = k * por_intervalo;
+            while (acumulado + peso[i] < objetivo && i < BINS_VEGAS - 1) {
+                acumulado += peso[i];
+                i++;
+            }
+            double izquierdo = r->limites[d][i];
+            double ancho = r->limites[d][i + 1] - izquierdo;
+            nuevos[k] = izquierdo + ancho * (peso[i] > 0.0 ? (objetivo - acumulado) / peso[i] : 0.0);
+        }
+        nuevos[BINS_VEGAS] = 1.0;
+        memcpy(r->limites[d], nuevos, sizeof(nuevos));
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+    VegasParams params;
+    double start_time, end_time;
+
+    /* Inicialización de MPI */
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    /* Proceso raíz procesa los argumentos de línea de comandos */
+    if (rank == 0) {
+        if (argc != 7 && argc != 8) {
+            fprintf(stderr, "Uso: %s <a> <b> <dim> <muestras_por_iteracion> <iteraciones> <numero_de_hilos> [semilla]\n", argv[0]);
+            fprintf(stderr, "Donde:\n");
+            fprintf(stderr, "    <a> : Límite inferior de integración en cada dimensión (double)\n");
+            fprintf(stderr, "    <b> : Límite superior de integración en cada dimensión (double)\n");
+            fprintf(stderr, "    <dim> : Dimensión de la integral (1 a %d)\n", DIM_MAX_MC);
+            fprintf(stderr, "    <muestras_por_iteracion> : Muestras de cada iteración (entero positivo)\n");
+            fprintf(stderr, "    <iteraciones> : Número de iteraciones de adaptación (al menos 2)\n");
+            fprintf(stderr, "    <numero_de_hilos> : Número de hilos de OpenMP por proceso (entero positivo)\n");
+            fprintf(stderr, "    [semilla] : Semilla de Philox (entero, opcional)\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        params.a = atof(argv[1]);
+        params.b = atof(argv[2]);
+        params.dim = atoi(argv[3]);
+        params.n = atol(argv[4]);
+        params.iteraciones = atoi(argv[5]);
+        params.hilos = atoi(argv[6]);
+        params.semilla = (argc == 8) ? strtoull(argv[7], NULL, 10) : SEMILLA_VEGAS;
+
+        if (params.dim <= 0 || params.dim > DIM_MAX_MC) {
+            fprintf(stderr, "La dimensión debe estar entre 1 y %d.\n", DIM_MAX_MC);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (params.n < 2 || params.iteraciones < 2 || params.hilos <= 0) {
+            fprintf(stderr, "Se requieren al menos 2 muestras, 2 iteraciones y un número de hilos positivo.\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        printf("Aproximando con VEGAS la integral %dD sobre [%.6f, %.6f]^%d con %d iteraciones de %ld muestras.\n",
+               params.dim, params.a, params.b, params.dim, params.iteraciones, params.n);
+    }
+
+    /* Difusión de los parámetros a todos los procesos */
+    MPI_Bcast(&params, sizeof(VegasParams), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    int dim = params.dim;
+    int tamano_histograma = dim * BINS_VEGAS;
+    int tamano_reduccion = 2 + tamano_histograma;  // suma, suma de cuadrados, histograma
+    double *local = malloc(tamano_reduccion * sizeof(double));
+    double *global = malloc(tamano_reduccion * sizeof(double));
+    Rejilla *rejilla = malloc(sizeof(Rejilla));
+    rejilla_uniforme(rejilla, dim);
+
+    /* Reparto contiguo de los bloques de cada iteración entre procesos */
+    long bloques = (params.n + TAMANO_BLOQUE_MC - 1) / TAMANO_BLOQUE_MC;
+    long bloques_por_proceso = bloques / size;
+    long primero = rank * bloques_por_proceso;
+    long ultimo = (rank == size - 1) ? bloques : primero + bloques_por_proceso;
+
+    double suma_pesos = 0.0, suma_ponderada = 0.0, suma_chi2 = 0.0;
+    double varianza_uniforme = 0.0, varianza_ultima = 0.0;
+
+    /* Sincronización antes del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    start_time = MPI_Wtime();
+
+    for (int it = 0; it < params.iteraciones; it++) {
+        memset(local, 0, tamano_reduccion * sizeof(double));
+
+        #pragma omp parallel num_threads(params.hilos)
+        {
+            double suma = 0.0, suma2 = 0.0;
+            double *histograma = calloc(tamano_histograma, sizeof(double));
+
+            #pragma omp for schedule(static)
+            for (long k = primero; k < ultimo; k++) {
+                long muestras = (k == bloques - 1) ? params.n - k * TAMANO_BLOQUE_MC : TAMANO_BLOQUE_MC;
+                uint64_t bloque = ((uint64_t)it << 40) | (uint64_t)k;
+                muestrear_bloque(rejilla, &params, bloque, muestras, &suma, &suma2, histograma);
+            }
+
+            #pragma omp critical
+            {
+                local[0] += suma;
+                local[1] += suma2;
+                for (int j = 0; j < tamano_histograma; j++) {
+                    local[2 + j] += histograma[j];
+                }
+            }
+            free(histograma);
+        }
+
+        /* Una sola reducción por iteración: sumas e histogramas de todos los procesos */
+        MPI_Allreduce(local, global, tamano_reduccion, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+        double media = global[0] / params.n;
+        double varianza_muestra = (global[1] / params.n - media * media) * params.n / (params.n - 1);
+        double varianza = varianza_muestra / params.n;
+        if (it == 0) {
+            varianza_uniforme = varianza_muestra;
+        }
+        varianza_ultima = varianza_muestra;
+
+        /* Combinación ponderada por 1/σ² de las iteraciones */
+        double peso = varianza > 0.0 ? 1.0 / varianza : 1.0;
+        suma_pesos += peso;
+        suma_ponderada += peso * media;
+        suma_chi2 += peso * media * media;
+
+        if (rank == 0) {
+            printf("  Iteración %d: %.12f ± %.3e\n", it, media, sqrt(varianza));
+            refinar_rejilla(rejilla, &global[2]);
+        }
+
+        /* MPI no garantiza que la Allreduce dé bits idénticos en todos los procesos: la rejilla
+         * del raíz es la única que se usa */
+        MPI_Bcast(rejilla, sizeof(Rejilla), MPI_BYTE, 0, MPI_COMM_WORLD);
+    }
+
+    /* Sincronización después del cálculo */
+    MPI_Barrier(MPI_COMM_WORLD);
+    end_time = MPI_Wtime();
+
+    /* Proceso raíz muestra el resultado y el tiempo de ejecución */
+    if (rank == 0) {
+        double resultado = suma_ponderada / suma_pesos;
+        double chi2_gl = (suma_chi2 - resultado * resultado * suma_pesos) / (params.iteraciones - 1);
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Error estándar: %.3e (χ²/gl = %.3f).\n", 1.0 / sqrt(suma_pesos), chi2_gl);
+        printf("Eficiencia frente a Monte Carlo uniforme: %.3f (varianza por muestra %.3e contra %.3e).\n",
+               varianza_uniforme / varianza_ultima, varianza_ultima, varianza_uniforme);
+        printf("Tiempo de ejecución: %.6f segundos.\n", end_time - start_time);
+    }
+
+    free(local);
+    free(global);
+    free(rejilla);
+
+    /* Finalización de MPI */
+    MPI_Finalize();
+
+    return 0;
+}
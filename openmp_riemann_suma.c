@@ -9,31 +9,360 @@
  * de subintervalos (n) como argumentos de línea de comandos. Se utiliza la Regla del Punto
  * Medio para una mayor precisión en la aproximación.
  *
+ * En modo Monte Carlo (mc) se estima la integral de f(x_1)·...·f(x_dim) sobre [a, b]^dim con n
+ * muestras uniformes. Los aleatorios provienen de Philox (montecarlo.h), con un flujo propio
+ * por bloque de muestras, por lo que el resultado no depende del número de hilos. Durante el
+ * cálculo se informa la estimación parcial y su error estándar.
+ *
+ * En los modos de cuasi-Monte Carlo (sobol, reticula) se usan puntos de Sobol o de una retícula
+ * de rango 1 (cuasi_montecarlo.h) con desplazamientos aleatorios; cada réplica usa un
+ * desplazamiento independiente y el error estándar se estima con la dispersión entre réplicas.
+ *
+ * El modo vr es el Monte Carlo anterior con reducción de varianza (reduccion_varianza.h):
+ * estratificación de la primera coordenada con un estrato por hilo y asignación de Neyman a
+ * partir de una pasada piloto, variables antitéticas y una variable de control con integral
+ * conocida (funcion_control), en cualquier combinación.
+ *
+ * El modo adaptativo aplica Gauss-Kronrod (G7-K15) y biseca recursivamente cada subintervalo
+ * cuyo error supera su parte de la tolerancia. Cada bisección es una tarea de OpenMP hasta la
+ * profundidad PROFUNDIDAD_TAREAS (por debajo, la recursión es secuencial para no crear tareas
+ * diminutas), de modo que el robo de trabajo del runtime reparte las zonas que piden mucho
+ * refinamiento. Los subintervalos aceptados se guardan en una arena por hilo y el error se
+ * acumula por hilo sin sincronización; la integral final se suma en orden de izquierda a
+ * derecha, así que no depende de qué hilo ejecutó cada tarea. Además de sin(x) hay integrandos
+ * con rasgos locales agudos (pico, escalon, raiz) para las pruebas de rendimiento
+ * (benchmark_adaptativo.sh).
+ *
+ * El modo pool calcula la suma de Riemann con el pool de hilos de pool_hilos.h en lugar del
+ * pragma de OpenMP: trabajadores pthread persistentes con deques de Chase-Lev y robo de trabajo.
+ * La suma se reduce por tramos fijos de 'grano' subintervalos en orden de tramo, así que con un
+ * grano explícito el resultado no depende del número de hilos; el grano por defecto depende del
+ * número de hilos y con él cambia la agrupación de la suma. El tiempo informado excluye la creación del pool,
+ * que se informa aparte (benchmark_backends.sh compara ambos backends).
+ *
+ * El modo lote resuelve muchos trabajos pequeños: [a, b] se parte en 'trabajos' piezas y cada una
+ * se integra con n subintervalos. Se mide primero el enfoque por llamada (una región paralela de
+ * calcular_suma_riemann_openmp por trabajo) y después una sesión: una sola región paralela viva
+ * durante todo el lote, en la que el hilo 0 publica los trabajos en una cola compartida (por
+ * rondas de 'por_ronda' trabajos, esperando a que termine cada ronda) y los hilos toman el
+ * siguiente trabajo con un contador atómico. Un hilo sin trabajo gira GIROS_SESION veces y
+ * luego duerme en una variable de condición hasta que se publique más. Se informan los trabajos
+ * por segundo de ambos enfoques.
+ *
+ * La variable de entorno RIEMANN_AFINIDAD (compacta, dispersa, fisicos o numa; afinidad.h) fija
+ * cada hilo de OpenMP, y cada trabajador del pool, según la topología leída de /sys, y se
+ * imprime la colocación elegida. Con numero_de_hilos = 0 se usa un hilo por núcleo físico.
+ *
+ * El modo autoajuste mide variantes del núcleo de la suma de Riemann sobre esta máquina: factor
+ * de desenrollado con acumuladores independientes (1, 2, 4, 8), acumulación simple o de Kahan,
+ * bucles omp simd de ancho 4 u 8, tamaño de bloque y planificación de OpenMP con su trozo. La
+ * búsqueda es por coordenadas (núcleo, luego bloque, luego planificación), cada medición es la
+ * mejor de REPETICIONES_AJUSTE con a lo sumo N_MAXIMO_AJUSTE subintervalos, y solo se aceptan
+ * variantes cuyo resultado difiere del de Kahan en menos de la tolerancia relativa dada. El
+ * ganador se guarda como perfil (perfiles_ajuste.h) con clave modelo de CPU, hash del integrando
+ * y número de hilos; el modo por defecto carga el perfil de su clave al arrancar, si existe, y
+ * lo usa sin volver a medir.
+ *
+ * El modo reproducible da un resultado idéntico bit a bit con cualquier número de hilos y
+ * planificación: la suma se parte en bloques de tamaño fijo (BLOQUE_REPRODUCIBLE subintervalos,
+ * o el indicado), cada bloque se suma secuencialmente y las sumas de bloque se combinan en un
+ * árbol binario fijo que solo depende del número de bloques. También se mide la reducción
+ * habitual (reduction(+:suma)) con los mismos hilos para informar la sobrecarga: tras una
+ * llamada de calentamiento (arranque del equipo de libgomp), ambas sumas se miden
+ * REPETICIONES_REPRODUCIBLE veces alternadas y se comparan las medianas.
+ *
  * Compilación:
- *     gcc -fopenmp -O2 -o openmp_riemann_suma openmp_riemann_suma.c -lm
+ *     gcc -fopenmp -pthread -O2 -o openmp_riemann_suma openmp_riemann_suma.c -lm
  *
  * Uso:
- *     ./openmp_riemann_suma <a> <b> <n> <numero_de_hilos>
+ *     ./openmp_riemann_suma <a> <b> <n> <numero_de_hilos> [mc <dim> [semilla]]
+ *     ./openmp_riemann_suma <a> <b> <n> <numero_de_hilos> <sobol|reticula> <dim> <replicas> [semilla]
+ *     ./openmp_riemann_suma <a> <b> <n> <numero_de_hilos> vr <dim> <tecnicas> [semilla]
+ *     ./openmp_riemann_suma <a> <b> <n> <numero_de_hilos> adaptativo <tolerancia> [integrando]
+ *     ./openmp_riemann_suma <a> <b> <n> <numero_de_hilos> pool [grano]
+ *     ./openmp_riemann_suma <a> <b> <n> <numero_de_hilos> lote <trabajos> [por_ronda]
+ *     ./openmp_riemann_suma <a> <b> <n> <numero_de_hilos> autoajuste [tolerancia]
+ *     ./openmp_riemann_suma <a> <b> <n> <numero_de_hilos> reproducible [bloque]
  *     Donde:
  *         <a> : Límite inferior de integración (double)
  *         <b> : Límite superior de integración (double)
- *         <n> : Número de subintervalos (entero positivo)
- *         <numero_de_hilos> : Número de hilos de OpenMP (entero positivo)
+ *         <n> : Número de subintervalos, o de muestras en modo mc (entero positivo)
+ *         <numero_de_hilos> : Número de hilos de OpenMP (0 = uno por núcleo físico)
+ *         mc <dim> [semilla] : Monte Carlo en dimensión dim con la semilla dada
+ *         sobol|reticula <dim> <replicas> [semilla] : Cuasi-Monte Carlo con réplicas desplazadas
+ *         vr <dim> <tecnicas> [semilla] : Monte Carlo con las técnicas dadas, separadas por comas
+ *                                         (estratos, antitetico, control)
+ *         adaptativo <tolerancia> [integrando] : Cuadratura adaptativa con tareas hasta el error
+ *                                                absoluto dado, partiendo de n subintervalos;
+ *                                                integrando es seno (por defecto), pico,
+ *                                                escalon o raiz
+ *         pool [grano] : Suma de Riemann con el pool de hilos propio, en tramos de grano
+ *                        subintervalos (por defecto n / (16 · hilos); fijarlo hace el resultado
+ *                        idéntico con cualquier número de hilos)
+ *         lote <trabajos> [por_ronda] : Integra 'trabajos' piezas de [a, b] con n subintervalos
+ *                                       cada una, por llamada y en una sesión persistente que
+ *                                       publica los trabajos en rondas (por defecto, una sola)
+ *         autoajuste [tolerancia] : Ajusta el núcleo de la suma de Riemann con la tolerancia
+ *                                   relativa dada (por defecto 1e-12) y guarda el perfil
+ *         reproducible [bloque] : Suma por bloques fijos y árbol fijo, idéntica con cualquier
+ *                                 número de hilos (bloque por defecto BLOQUE_REPRODUCIBLE)
  *
  * Ejemplo:
  *     ./openmp_riemann_suma 0 3.141592653589793 100000000 4
+ *     ./openmp_riemann_suma 0 3.141592653589793 100000000 4 mc 6
+ *     ./openmp_riemann_suma 0 3.141592653589793 16777216 4 sobol 6 8
+ *     ./openmp_riemann_suma 0 3.141592653589793 100000000 4 vr 6 estratos,antitetico,control
+ *     ./openmp_riemann_suma 0 10 16 4 adaptativo 1e-10 pico
+ *     ./openmp_riemann_suma 0 3.141592653589793 100000000 4 pool
+ *     ./openmp_riemann_suma 0 3.141592653589793 1000 4 lote 100000 64
+ *     RIEMANN_AFINIDAD=dispersa ./openmp_riemann_suma 0 3.141592653589793 100000000 0
+ *     ./openmp_riemann_suma 0 3.141592653589793 100000000 4 autoajuste
+ *     ./openmp_riemann_suma 0 3.141592653589793 100000000 4 reproducible
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <omp.h>
+#include "montecarlo.h"
+#include "cuasi_montecarlo.h"
+#include "reduccion_varianza.h"
+#include "pool_hilos.h"
+#include "afinidad.h"
+#include "perfiles_ajuste.h"
+
+#define RONDAS_MC 10        // Informes parciales del modo Monte Carlo
+#define SEMILLA_MC 12345
+#define PROFUNDIDAD_TAREAS 12     // Profundidad hasta la que cada bisección es una tarea
+#define PROFUNDIDAD_MAXIMA 60     // Los subintervalos más profundos se aceptan sin más
+#define TAMANO_BLOQUE_ARENA 4096  // Subintervalos por bloque de la arena de cada hilo
+#define TRAMOS_POR_HILO_POOL 16   // Grano por defecto del modo pool: n / (TRAMOS_POR_HILO_POOL · hilos)
+#define GIROS_SESION 4096         // Giros de un hilo sin trabajo antes de dormir en el modo lote
+#define BLOQUE_AJUSTE 4096        // Bloque inicial de la búsqueda del autoajuste
+#define REPETICIONES_AJUSTE 3
+#define N_MAXIMO_AJUSTE 4194304   // Subintervalos máximos por medición del autoajuste
+#define TOLERANCIA_AJUSTE 1e-12   // Tolerancia relativa por defecto del autoajuste
+#define BLOQUE_REPRODUCIBLE 8192  // Subintervalos por bloque del modo reproducible
+#define REPETICIONES_REPRODUCIBLE 7  // Mediciones alternadas de cada suma en el modo reproducible
 
 /* Definición de la función a integrar */
 double funcion(double x) {
     return sin(x); // Puedes cambiar esta función según tus necesidades
 }
 
+/* Integrando del modo Monte Carlo: producto de la función en cada coordenada */
+double funcion_multidimensional(const double *x, int dim) {
+    double producto = 1.0;
+    for (int d = 0; d < dim; d++) {
+        producto *= funcion(x[d]);
+    }
+    return producto;
+}
+
+/* Integrandos con rasgos locales agudos para el modo adaptativo */
+double funcion_pico(double x) {
+    return 1e-2 / ((x - 1.0) * (x - 1.0) + 1e-4);  // Lorentziana de ancho 0.01 en x = 1
+}
+
+double funcion_escalon(double x) {
+    return x < 2.0 ? sin(x) : sin(x) + 1.0;  // Discontinuidad en x = 2
+}
+
+double funcion_raiz(double x) {
+    return sqrt(fabs(x - 3.0));  // Derivada singular en x = 3
+}
+
+/* Variable de control del modo vr: parábola que coincide con sin(x) en 0, π/2 y π. Si se cambia
+ * la función a integrar, conviene cambiar también esta aproximación y su primitiva. */
+double funcion_control(double x) {
+    return 4.0 / (M_PI * M_PI) * x * (M_PI - x);
+}
+
+double primitiva_control(double x) {
+    return 4.0 / (M_PI * M_PI) * (M_PI * x * x / 2.0 - x * x * x / 3.0);
+}
+
+double control_multidimensional(const double *x, int dim) {
+    double producto = 1.0;
+    for (int d = 0; d < dim; d++) {
+        producto *= funcion_control(x[d]);
+    }
+    return producto;
+}
+
+/* Integral exacta de la variable de control sobre una caja */
+double integral_control_caja(const double *inferior, const double *superior, int dim) {
+    double producto = 1.0;
+    for (int d = 0; d < dim; d++) {
+        producto *= primitiva_control(superior[d]) - primitiva_control(inferior[d]);
+    }
+    return producto;
+}
+
+/* Subintervalo aceptado por el modo adaptativo */
+typedef struct {
+    double izquierdo;
+    double derecho;
+    double integral;
+    double error;
+} Intervalo;
+
+/* Arena de un hilo: bloques de TAMANO_BLOQUE_ARENA intervalos que nunca se mueven, y el error
+ * acumulado por el hilo. Se alinea a 64 bytes para que los hilos no compartan líneas de caché. */
+typedef struct {
+    Intervalo **bloques;
+    int num_bloques;
+    int capacidad_bloques;
+    long usados;          // Intervalos ocupados en el último bloque
+    long total;
+    double error;
+    int profundidad_maxima;
+} __attribute__((aligned(64))) ArenaHilo;
+
+static Intervalo *arena_reservar(ArenaHilo *arena) {
+    if (arena->num_bloques == 0 || arena->usados == TAMANO_BLOQUE_ARENA) {
+        if (arena->num_bloques == arena->capacidad_bloques) {
+            arena->capacidad_bloques = arena->capacidad_bloques ? 2 * arena->capacidad_bloques : 16;
+            arena->bloques = realloc(arena->bloques, arena->capacidad_bloques * sizeof(Intervalo *));
+        }
+        arena->bloques[arena->num_bloques++] = malloc(TAMANO_BLOQUE_ARENA * sizeof(Intervalo));
+        arena->usados = 0;
+    }
+    arena->total++;
+    return &arena->bloques[arena->num_bloques - 1][arena->usados++];
+}
+
+/* Regla de Gauss-Kronrod de 15 puntos con la de Gauss de 7 encajada; devuelve |K15 - G7| */
+static double gauss_kronrod(double (*f)(double), double izquierdo, double derecho, double *integral) {
+    static const double nodos[8] = {
+        0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+    static const double pesos_kronrod[8] = {
+        0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+    static const double pesos_gauss[4] = {
+        0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+    double centro = 0.5 * (izquierdo + derecho);
+    double semiancho = 0.5 * (derecho - izquierdo);
+    double f_centro = f(centro);
+    double kronrod = pesos_kronrod[7] * f_centro;
+    double gauss = pesos_gauss[3] * f_centro;
+
+    for (int j = 0; j < 7; j++) {
+        double suma = f(centro - semiancho * nodos[j]) + f(centro + semiancho * nodos[j]);
+        kronrod += pesos_kronrod[j] * suma;
+        if (j % 2 == 1) {
+            gauss += pesos_gauss[j / 2] * suma;
+        }
+    }
+    *integral = kronrod * semiancho;
+    return fabs((kronrod - gauss) * semiancho);
+}
+
+/* Acepta [izquierdo, derecho] si su error cabe en su parte de la tolerancia (proporcional al
+ * ancho); si no, lo biseca. Cerca de la raíz cada mitad es una tarea; más abajo la recursión
+ * sigue en el mismo hilo. */
+static void adaptar_intervalo(double (*f)(double), double izquierdo, double derecho, double densidad_tolerancia,
+                              int profundidad, ArenaHilo *arenas) {
+    double integral;
+    double error = gauss_kronrod(f, izquierdo, derecho, &integral);
+
+    if (error <= densidad_tolerancia * (derecho - izquierdo) || profundidad >= PROFUNDIDAD_MAXIMA) {
+        ArenaHilo *arena = &arenas[omp_get_thread_num()];
+        Intervalo *intervalo = arena_reservar(arena);
+        intervalo->izquierdo = izquierdo;
+        intervalo->derecho = derecho;
+        intervalo->integral = integral;
+        intervalo->error = error;
+        arena->error += error;
+        if (profundidad > arena->profundidad_maxima) {
+            arena->profundidad_maxima = profundidad;
+        }
+        return;
+    }
+
+    double medio = 0.5 * (izquierdo + derecho);
+    if (profundidad < PROFUNDIDAD_TAREAS) {
+        #pragma omp task
+        adaptar_intervalo(f, izquierdo, medio, densidad_tolerancia, profundidad + 1, arenas);
+        #pragma omp task
+        adaptar_intervalo(f, medio, derecho, densidad_tolerancia, profundidad + 1, arenas);
+    } else {
+        adaptar_intervalo(f, izquierdo, medio, densidad_tolerancia, profundidad + 1, arenas);
+        adaptar_intervalo(f, medio, derecho, densidad_tolerancia, profundidad + 1, arenas);
+    }
+}
+
+static int comparar_intervalos(const void *x, const void *y) {
+    const Intervalo *p = x, *q = y;
+    return (p->izquierdo > q->izquierdo) - (p->izquierdo < q->izquierdo);
+}
+
+/* Cuadratura adaptativa con tareas de OpenMP hasta el error absoluto 'tolerancia', partiendo
+ * de n subintervalos iguales */
+double calcular_integral_adaptativa_openmp(double (*f)(double), double a, double b, long n, double tolerancia,
+                                           int num_hilos, double *error_estimado, long *intervalos,
+                                           int *profundidad_maxima) {
+    ArenaHilo *arenas = aligned_alloc(64, num_hilos * sizeof(ArenaHilo));
+    memset(arenas, 0, num_hilos * sizeof(ArenaHilo));
+
+    #pragma omp parallel num_threads(num_hilos)
+    {
+        #pragma omp single
+        for (long i = 0; i < n; i++) {
+            double izquierdo = a + i * (b - a) / n;
+            double derecho = (i == n - 1) ? b : a + (i + 1) * (b - a) / n;
+            #pragma omp task
+            adaptar_intervalo(f, izquierdo, derecho, tolerancia / (b - a), 0, arenas);
+        }
+    }
+
+    /* Reunión de las arenas y suma en orden de izquierda a derecha */
+    long total = 0;
+    for (int h = 0; h < num_hilos; h++) {
+        total += arenas[h].total;
+    }
+    Intervalo *todos = malloc(total * sizeof(Intervalo));
+    long copiados = 0;
+    *error_estimado = 0.0;
+    *profundidad_maxima = 0;
+    for (int h = 0; h < num_hilos; h++) {
+        for (int k = 0; k < arenas[h].num_bloques; k++) {
+            long cantidad = (k == arenas[h].num_bloques - 1) ? arenas[h].usados : TAMANO_BLOQUE_ARENA;
+            memcpy(&todos[copiados], arenas[h].bloques[k], cantidad * sizeof(Intervalo));
+            copiados += cantidad;
+            free(arenas[h].bloques[k]);
+        }
+        free(arenas[h].bloques);
+        *error_estimado += arenas[h].error;
+        if (arenas[h].profundidad_maxima > *profundidad_maxima) {
+            *profundidad_maxima = arenas[h].profundidad_maxima;
+        }
+    }
+    qsort(todos, total, sizeof(Intervalo), comparar_intervalos);
+
+    double suma = 0.0;
+    for (long i = 0; i < total; i++) {
+        suma += todos[i].integral;
+    }
+
+    free(todos);
+    free(arenas);
+    *intervalos = total;
+    return suma;
+}
+
 /* Función para calcular la suma de Riemann utilizando la Regla del Punto Medio con OpenMP */
 double calcular_suma_riemann_openmp(double a, double b, long n, int num_hilos) {
     double delta_x = (b - a) / n;
@@ -48,14 +377,598 @@ double calcular_suma_riemann_openmp(double a, double b, long n, int num_hilos) {
     return suma;
 }
 
+/* Tramo [i0, i1) de la suma de Riemann para el pool de hilos */
+typedef struct {
+    double a;
+    double delta_x;
+} ContextoRiemannPool;
+
+static double cuerpo_riemann_pool(void *contexto, long i0, long i1) {
+    const ContextoRiemannPool *c = contexto;
+    double suma = 0.0;
+    for (long i = i0; i < i1; i++) {
+        double x = c->a + (i + 0.5) * c->delta_x;
+        suma += funcion(x) * c->delta_x;
+    }
+    return suma;
+}
+
+/* Suma de Riemann con el pool de hilos en lugar del pragma de OpenMP */
+double calcular_suma_riemann_pool(PoolHilos *pool, double a, double b, long n, long grano) {
+    ContextoRiemannPool contexto = {a, (b - a) / n};
+    return pool_paralelo_reduce(pool, 0, n, grano, cuerpo_riemann_pool, &contexto);
+}
+
+/* Variantes del núcleo del autoajuste: suma de f en los puntos medios de los subintervalos
+ * [i0, i1), sin el factor delta_x. Las simples y las de Kahan usan U acumuladores
+ * independientes para romper la dependencia entre sumas; las simd piden vectorizar el bucle,
+ * lo que solo ocurre si la función tiene versión vectorial (por ejemplo, sin de libmvec con
+ * -ffast-math). */
+#define DEFINIR_NUCLEO_SIMPLE(U)                                                  \
+    static double nucleo_simple##U(double a, double delta_x, long i0, long i1) { \
+        double s[U] = {0.0};                                                      \
+        long i = i0;                                                              \
+        for (; i + U <= i1; i += U) {                                             \
+            for (int k = 0; k < U; k++) {                                         \
+                s[k] += funcion(a + (i + k + 0.5) * delta_x);                     \
+            }                                                                     \
+        }                                                                         \
+        for (; i < i1; i++) {                                                     \
+            s[0] += funcion(a + (i + 0.5) * delta_x);                             \
+        }                                                                         \
+        double suma = 0.0;                                                        \
+        for (int k = 0; k < U; k++) {                                             \
+            suma += s[k];                                                         \
+        }                                                                         \
+        return suma;                                                              \
+    }
+
+#define DEFINIR_NUCLEO_KAHAN(U)                                                  \
+    static double nucleo_kahan##U(double a, double delta_x, long i0, long i1) { \
+        double s[U] = {0.0}, c[U] = {0.0};                                       \
+        long i = i0;                                                             \
+        for (; i < i1; i += U) {                                                 \
+            for (int k = 0; k < U && i + k < i1; k++) {                          \
+                double y = funcion(a + (i + k + 0.5) * delta_x) - c[k];          \
+                double t = s[k] + y;                                             \
+                c[k] = (t - s[k]) - y;                                           \
+                s[k] = t;                                                        \
+            }                                                                    \
+        }                                                                        \
+        double suma = 0.0;                                                       \
+        for (int k = 0; k < U; k++) {                                            \
+            suma += s[k] - c[k];                                                 \
+        }                                                                        \
+        return suma;                                                             \
+    }
+
+#define PRAGMA(x) _Pragma(#x)
+#define DEFINIR_NUCLEO_SIMD(W)                                                  \
+    static double nucleo_simd##W(double a, double delta_x, long i0, long i1) { \
+        double suma = 0.0;                                                      \
+        PRAGMA(omp simd simdlen(W) reduction(+:suma))                           \
+        for (long i = i0; i < i1; i++) {                                        \
+            suma += funcion(a + (i + 0.5) * delta_x);                           \
+        }                                                                       \
+        return suma;                                                            \
+    }
+
+DEFINIR_NUCLEO_SIMPLE(1)
+DEFINIR_NUCLEO_SIMPLE(2)
+DEFINIR_NUCLEO_SIMPLE(4)
+DEFINIR_NUCLEO_SIMPLE(8)
+DEFINIR_NUCLEO_KAHAN(1)
+DEFINIR_NUCLEO_KAHAN(2)
+DEFINIR_NUCLEO_KAHAN(4)
+DEFINIR_NUCLEO_KAHAN(8)
+DEFINIR_NUCLEO_SIMD(4)
+DEFINIR_NUCLEO_SIMD(8)
+
+typedef struct {
+    const char *nombre;
+    double (*sumar)(double a, double delta_x, long i0, long i1);
+} NucleoRiemann;
+
+static const NucleoRiemann NUCLEOS[] = {
+    {"simple1", nucleo_simple1}, {"simple2", nucleo_simple2}, {"simple4", nucleo_simple4},
+    {"simple8", nucleo_simple8}, {"kahan1", nucleo_kahan1},   {"kahan2", nucleo_kahan2},
+    {"kahan4", nucleo_kahan4},   {"kahan8", nucleo_kahan8},   {"simd4", nucleo_simd4},
+    {"simd8", nucleo_simd8}};
+#define NUM_NUCLEOS ((int)(sizeof(NUCLEOS) / sizeof(NUCLEOS[0])))
+#define NUCLEO_REFERENCIA 4  // kahan1: referencia de exactitud del autoajuste
+
+/* Configuración del núcleo: variante, subintervalos por bloque y planificación de los bloques */
+typedef struct {
+    int nucleo;
+    long bloque;
+    omp_sched_t planificacion;
+    int trozo;  // Bloques por trozo (0 = valor por defecto de la planificación)
+} ConfiguracionNucleo;
+
+static const char *nombre_planificacion(omp_sched_t planificacion) {
+    return planificacion == omp_sched_dynamic ? "dynamic" : planificacion == omp_sched_guided ? "guided" : "static";
+}
+
+/* Suma de Riemann con una configuración del núcleo; los bloques se reparten con la
+ * planificación elegida (schedule(runtime)) */
+double calcular_suma_riemann_ajustada(double a, double b, long n, int num_hilos, const ConfiguracionNucleo *c) {
+    double delta_x = (b - a) / n;
+    long bloques = (n + c->bloque - 1) / c->bloque;
+    double (*sumar)(double, double, long, long) = NUCLEOS[c->nucleo].sumar;
+    double suma = 0.0;
+
+    omp_set_schedule(c->planificacion, c->trozo);
+    #pragma omp parallel for schedule(runtime) reduction(+:suma) num_threads(num_hilos)
+    for (long k = 0; k < bloques; k++) {
+        long i0 = k * c->bloque;
+        long i1 = (i0 + c->bloque < n) ? i0 + c->bloque : n;
+        suma += sumar(a, delta_x, i0, i1);
+    }
+
+    return suma * delta_x;
+}
+
+/* Mejor tiempo de REPETICIONES_AJUSTE ejecuciones, en nanosegundos por evaluación */
+static double medir_configuracion(double a, double b, long n, int num_hilos, const ConfiguracionNucleo *c,
+                                  double *resultado) {
+    double mejor = INFINITY;
+    for (int r = 0; r < REPETICIONES_AJUSTE; r++) {
+        double inicio = omp_get_wtime();
+        *resultado = calcular_suma_riemann_ajustada(a, b, n, num_hilos, c);
+        double tiempo = omp_get_wtime() - inicio;
+        mejor = tiempo < mejor ? tiempo : mejor;
+    }
+    return mejor * 1e9 / n;
+}
+
+/* Mide una configuración candidata y la adopta si es exacta y más rápida que la mejor actual */
+static void probar_configuracion(double a, double b, long n, int num_hilos, double referencia, double tolerancia,
+                                 const ConfiguracionNucleo *candidata, ConfiguracionNucleo *mejor, double *mejor_ns) {
+    double resultado;
+    double ns = medir_configuracion(a, b, n, num_hilos, candidata, &resultado);
+    double error = fabs(resultado - referencia) / fmax(fabs(referencia), 1.0);
+    int exacta = error <= tolerancia;
+
+    printf("  %-8s bloque %-6ld %-7s trozo %-3d: %8.3f ns/evaluación, error relativo %.1e%s\n",
+           NUCLEOS[candidata->nucleo].nombre, candidata->bloque, nombre_planificacion(candidata->planificacion),
+           candidata->trozo, ns, error, exacta ? "" : " (descartada)");
+    if (exacta && ns < *mejor_ns) {
+        *mejor = *candidata;
+        *mejor_ns = ns;
+    }
+}
+
+/* Búsqueda por coordenadas de la configuración más rápida dentro de la tolerancia relativa
+ * respecto del núcleo de Kahan; devuelve el tiempo por evaluación del ganador */
+double autoajustar_nucleo(double a, double b, long n, int num_hilos, double tolerancia, ConfiguracionNucleo *mejor) {
+    static const long bloques[] = {256, 1024, 4096, 16384, 65536};
+    static const omp_sched_t planificaciones[] = {omp_sched_static, omp_sched_dynamic, omp_sched_guided};
+    static const int trozos[] = {0, 1, 4, 16};
+    long n_ajuste = n < N_MAXIMO_AJUSTE ? n : N_MAXIMO_AJUSTE;
+    ConfiguracionNucleo candidata = {NUCLEO_REFERENCIA, BLOQUE_AJUSTE, omp_sched_static, 0};
+    double referencia;
+    double mejor_ns = INFINITY;
+
+    medir_configuracion(a, b, n_ajuste, num_hilos, &candidata, &referencia);
+    *mejor = candidata;
+
+    printf("Núcleo (%ld subintervalos por medición):\n", n_ajuste);
+    for (int k = 0; k < NUM_NUCLEOS; k++) {
+        candidata.nucleo = k;
+        probar_configuracion(a, b, n_ajuste, num_hilos, referencia, tolerancia, &candidata, mejor, &mejor_ns);
+    }
+
+    printf("Tamaño de bloque:\n");
+    candidata = *mejor;
+    for (size_t k = 0; k < sizeof(bloques) / sizeof(bloques[0]); k++) {
+        candidata.bloque = bloques[k];
+        probar_configuracion(a, b, n_ajuste, num_hilos, referencia, tolerancia, &candidata, mejor, &mejor_ns);
+    }
+
+    printf("Planificación:\n");
+    candidata = *mejor;
+    for (size_t p = 0; p < sizeof(planificaciones) / sizeof(planificaciones[0]); p++) {
+        for (size_t t = 0; t < sizeof(trozos) / sizeof(trozos[0]); t++) {
+            candidata.planificacion = planificaciones[p];
+            candidata.trozo = trozos[t];
+            probar_configuracion(a, b, n_ajuste, num_hilos, referencia, tolerancia, &candidata, mejor, &mejor_ns);
+        }
+    }
+    return mejor_ns;
+}
+
+/* Traduce un perfil guardado a una configuración; devuelve 0 si el perfil no es válido */
+static int configuracion_desde_perfil(const PerfilAjuste *perfil, ConfiguracionNucleo *c) {
+    c->nucleo = -1;
+    for (int k = 0; k < NUM_NUCLEOS; k++) {
+        if (strcmp(perfil->nucleo, NUCLEOS[k].nombre) == 0) {
+            c->nucleo = k;
+        }
+    }
+    c->bloque = perfil->bloque;
+    c->trozo = perfil->trozo;
+    c->planificacion = strcmp(perfil->planificacion, "dynamic") == 0 ? omp_sched_dynamic
+                       : strcmp(perfil->planificacion, "guided") == 0 ? omp_sched_guided
+                                                                       : omp_sched_static;
+    return c->nucleo >= 0 && c->bloque > 0 && c->trozo >= 0;
+}
+
+/* Trabajo del modo lote: suma de Riemann de [izquierdo, derecho] con n subintervalos */
+typedef struct {
+    double izquierdo;
+    double derecho;
+    long n;
+} TrabajoRiemann;
+
+/* Sesión del modo lote: cola de un productor (el hilo 0) y varios consumidores sobre el arreglo
+ * de trabajos. 'publicados' marca hasta dónde es visible la cola y 'siguiente' reparte turnos. */
+typedef struct {
+    const TrabajoRiemann *trabajos;
+    double *resultados;
+    atomic_long publicados;
+    atomic_long siguiente;
+    atomic_long completados;
+    atomic_int durmientes;
+    atomic_int cerrada;
+    atomic_long siestas;
+    pthread_mutex_t candado;
+    pthread_cond_t hay_trabajo;
+} SesionOpenMP;
+
+static inline void pausa_cpu(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static double suma_riemann_tramo(double a, double b, long n) {
+    double delta_x = (b - a) / n;
+    double suma = 0.0;
+    for (long i = 0; i < n; i++) {
+        double x = a + (i + 0.5) * delta_x;
+        suma += funcion(x) * delta_x;
+    }
+    return suma;
+}
+
+static void sesion_ejecutar(SesionOpenMP *sesion, long k) {
+    const TrabajoRiemann *t = &sesion->trabajos[k];
+    sesion->resultados[k] = suma_riemann_tramo(t->izquierdo, t->derecho, t->n);
+    atomic_fetch_add_explicit(&sesion->completados, 1, memory_order_release);
+}
+
+/* Hace visibles los trabajos hasta 'hasta' y despierta a los hilos dormidos, si los hay. El
+ * orden secuencialmente consistente entre 'publicados' y 'durmientes' garantiza que un hilo que
+ * se va a dormir ve la publicación o bien el productor lo ve a él. */
+static void sesion_publicar(SesionOpenMP *sesion, long hasta) {
+    atomic_store(&sesion->publicados, hasta);
+    if (atomic_load(&sesion->durmientes) > 0) {
+        pthread_mutex_lock(&sesion->candado);
+        pthread_cond_broadcast(&sesion->hay_trabajo);
+        pthread_mutex_unlock(&sesion->candado);
+    }
+}
+
+/* Bucle de un consumidor: toma un turno y espera (girando y luego durmiendo) a que su trabajo
+ * se publique; sale cuando la sesión se cierra con su turno sin publicar. */
+static void sesion_trabajador(SesionOpenMP *sesion) {
+    for (;;) {
+        long turno = atomic_fetch_add(&sesion->siguiente, 1);
+        int giros = 0;
+        while (atomic_load(&sesion->publicados) <= turno) {
+            if (atomic_load(&sesion->cerrada)) {
+                return;
+            }
+            if (++giros < GIROS_SESION) {
+                pausa_cpu();
+                continue;
+            }
+            pthread_mutex_lock(&sesion->candado);
+            atomic_fetch_add(&sesion->durmientes, 1);
+            atomic_fetch_add_explicit(&sesion->siestas, 1, memory_order_relaxed);
+            while (atomic_load(&sesion->publicados) <= turno && !atomic_load(&sesion->cerrada)) {
+                pthread_cond_wait(&sesion->hay_trabajo, &sesion->candado);
+            }
+            atomic_fetch_sub(&sesion->durmientes, 1);
+            pthread_mutex_unlock(&sesion->candado);
+            giros = 0;
+        }
+        sesion_ejecutar(sesion, turno);
+    }
+}
+
+/* Resuelve el lote con una sola región paralela. El hilo 0 publica cada ronda y, mientras
+ * espera a que termine, toma trabajos publicados sin bloquearse (nunca reserva un turno futuro,
+ * porque es él quien debe publicarlo). */
+void calcular_lote_sesion_openmp(const TrabajoRiemann *trabajos, long total, long por_ronda, int num_hilos,
+                                 double *resultados, long *siestas) {
+    SesionOpenMP sesion = {.trabajos = trabajos, .resultados = resultados};
+    atomic_init(&sesion.publicados, 0);
+    atomic_init(&sesion.siguiente, 0);
+    atomic_init(&sesion.completados, 0);
+    atomic_init(&sesion.durmientes, 0);
+    atomic_init(&sesion.cerrada, 0);
+    atomic_init(&sesion.siestas, 0);
+    pthread_mutex_init(&sesion.candado, NULL);
+    pthread_cond_init(&sesion.hay_trabajo, NULL);
+
+    #pragma omp parallel num_threads(num_hilos)
+    {
+        if (omp_get_thread_num() != 0) {
+            sesion_trabajador(&sesion);
+        } else {
+            for (long inicio = 0; inicio < total; inicio += por_ronda) {
+                long hasta = (inicio + por_ronda < total) ? inicio + por_ronda : total;
+                sesion_publicar(&sesion, hasta);
+                int giros = 0;
+                while (atomic_load_explicit(&sesion.completados, memory_order_acquire) < hasta) {
+                    long turno = atomic_load(&sesion.siguiente);
+                    if (turno < hasta && atomic_compare_exchange_weak(&sesion.siguiente, &turno, turno + 1)) {
+                        sesion_ejecutar(&sesion, turno);
+                    } else if (++giros < GIROS_SESION) {
+                        pausa_cpu();
+                    } else {
+                        sched_yield();  // Cede el núcleo a los hilos que tienen turnos pendientes
+                    }
+                }
+            }
+            pthread_mutex_lock(&sesion.candado);
+            atomic_store(&sesion.cerrada, 1);
+            pthread_cond_broadcast(&sesion.hay_trabajo);
+            pthread_mutex_unlock(&sesion.candado);
+        }
+    }
+
+    pthread_mutex_destroy(&sesion.candado);
+    pthread_cond_destroy(&sesion.hay_trabajo);
+    *siestas = atomic_load(&sesion.siestas);
+}
+
+/* Política de colocación de los hilos, común a OpenMP y al pool */
+typedef struct {
+    const Topologia *topologia;
+    PoliticaAfinidad politica;
+    int hilos;
+} PlanAfinidad;
+
+static void fijar_trabajador_pool(int trabajador, void *contexto) {
+    const PlanAfinidad *plan = contexto;
+    cpu_set_t conjunto;
+    afinidad_conjunto(plan->topologia, plan->politica, trabajador, plan->hilos, &conjunto);
+    afinidad_fijar_hilo(&conjunto);
+}
+
+/* Fija cada hilo del equipo de OpenMP según la política e imprime la colocación. libgomp
+ * reutiliza los mismos hilos en las regiones paralelas siguientes con igual número de hilos,
+ * así que la afinidad se conserva. */
+void colocar_hilos_openmp(const PlanAfinidad *plan) {
+    char (*descripciones)[96] = calloc(plan->hilos, sizeof(*descripciones));
+    int rechazados = 0, equipo = plan->hilos;
+
+    #pragma omp parallel num_threads(plan->hilos) reduction(+:rechazados)
+    {
+        int hilo = omp_get_thread_num();
+        #pragma omp single
+        equipo = omp_get_num_threads();
+        cpu_set_t conjunto;
+        afinidad_conjunto(plan->topologia, plan->politica, hilo, plan->hilos, &conjunto);
+        rechazados += !afinidad_fijar_hilo(&conjunto);
+        afinidad_describir(plan->topologia, &conjunto, descripciones[hilo], sizeof(descripciones[hilo]));
+    }
+
+    printf("Colocación %s de %d hilos:\n", afinidad_nombre(plan->politica), equipo);
+    for (int h = 0; h < equipo; h++) {
+        printf("  Hilo %d → %s\n", h, descripciones[h]);
+    }
+    if (equipo < plan->hilos) {
+        printf("  Advertencia: OpenMP creó %d de los %d hilos pedidos.\n", equipo, plan->hilos);
+    }
+    if (rechazados > 0) {
+        printf("  Advertencia: el sistema rechazó la afinidad de %d hilos.\n", rechazados);
+    }
+    free(descripciones);
+}
+
+static int comparar_tiempos(const void *x, const void *y) {
+    double tx = *(const double *)x, ty = *(const double *)y;
+    return (tx > ty) - (tx < ty);
+}
+
+static double mediana_tiempos(double *tiempos, int cantidad) {
+    qsort(tiempos, cantidad, sizeof(double), comparar_tiempos);
+    return (cantidad % 2) ? tiempos[cantidad / 2] : 0.5 * (tiempos[cantidad / 2 - 1] + tiempos[cantidad / 2]);
+}
+
+/* Suma de Riemann reproducible: bloques de 'bloque' subintervalos sumados en orden y
+ * combinados en un árbol binario fijo (en el nivel con paso s, el nodo i acumula al i + s).
+ * Ni los bloques ni el árbol dependen del número de hilos, así que el resultado tampoco. */
+double calcular_suma_riemann_reproducible(double a, double b, long n, long bloque, int num_hilos) {
+    double delta_x = (b - a) / n;
+    long bloques = (n + bloque - 1) / bloque;
+    double *parciales = malloc(bloques * sizeof(double));
+
+    #pragma omp parallel num_threads(num_hilos)
+    {
+        #pragma omp for schedule(static)
+        for (long k = 0; k < bloques; k++) {
+            long fin = (k == bloques - 1) ? n : (k + 1) * bloque;
+            double suma = 0.0;
+            for (long i = k * bloque; i < fin; i++) {
+                double x = a + (i + 0.5) * delta_x;
+                suma += funcion(x) * delta_x;
+            }
+            parciales[k] = suma;
+        }
+
+        for (long paso = 1; paso < bloques; paso *= 2) {
+            #pragma omp for schedule(static)
+            for (long i = 0; i < bloques - paso; i += 2 * paso) {
+                parciales[i] += parciales[i + paso];
+            }
+        }
+    }
+
+    double suma = parciales[0];
+    free(parciales);
+    return suma;
+}
+
+/* Integral de Monte Carlo sobre [a, b]^dim con n muestras. Los bloques de cada ronda se
+ * evalúan en paralelo y se combinan en orden de bloque, de modo que el resultado es idéntico
+ * con cualquier número de hilos. */
+double calcular_integral_montecarlo_openmp(double a, double b, long n, int dim, uint64_t semilla,
+                                           int num_hilos, double *error_estandar) {
+    long bloques = (n + TAMANO_BLOQUE_MC - 1) / TAMANO_BLOQUE_MC;
+    long rondas = bloques < RONDAS_MC ? bloques : RONDAS_MC;
+    double volumen = pow(b - a, dim);
+    EstadisticaMC total = {0.0, 0.0, 0.0};
+    EstadisticaMC *parciales = malloc(((bloques + rondas - 1) / rondas) * sizeof(EstadisticaMC));
+
+    for (long ronda = 0; ronda < rondas; ronda++) {
+        long primero = bloques * ronda / rondas;
+        long ultimo = bloques * (ronda + 1) / rondas;
+
+        #pragma omp parallel for schedule(static) num_threads(num_hilos)
+        for (long k = primero; k < ultimo; k++) {
+            long muestras = (k == bloques - 1) ? n - k * TAMANO_BLOQUE_MC : TAMANO_BLOQUE_MC;
+            parciales[k - primero] = estadistica_bloque_mc(funcion_multidimensional, dim, a, b,
+                                                           semilla, (uint64_t)k, muestras);
+        }
+
+        for (long k = primero; k < ultimo; k++) {
+            estadistica_combinar(&total, &parciales[k - primero]);
+        }
+        printf("  %.0f muestras: %.12f ± %.3e\n", total.n, volumen * total.media,
+               volumen * estadistica_error_estandar(&total));
+    }
+
+    free(parciales);
+    *error_estandar = volumen * estadistica_error_estandar(&total);
+    return volumen * total.media;
+}
+
+/* Integral de cuasi-Monte Carlo con 'replicas' desplazamientos aleatorios independientes.
+ * Los puntos de cada réplica se reparten por bloques entre hilos; cada bloque salta
+ * directamente a su primer punto. */
+double calcular_integral_cuasi_montecarlo_openmp(double a, double b, long n, int dim, int usar_sobol,
+                                                 int replicas, uint64_t semilla, int num_hilos,
+                                                 double *error_estandar) {
+    long bloques = (n + TAMANO_BLOQUE_MC - 1) / TAMANO_BLOQUE_MC;
+    double volumen = pow(b - a, dim);
+    double *sumas = malloc(bloques * sizeof(double));
+    EstadisticaMC estimaciones = {0.0, 0.0, 0.0};
+    Sobol sobol;
+    Reticula reticula;
+
+    if (usar_sobol) {
+        sobol_iniciar(&sobol, dim);
+    } else {
+        /* Elección de α entre los candidatos por el criterio P_2 */
+        int candidatos = reticula_numero_candidatos((uint64_t)n, dim);
+        uint64_t mejor_alfa = 0;
+        double mejor_criterio = INFINITY;
+        omp_set_num_threads(num_hilos);
+        for (int c = 0; c < candidatos; c++) {
+            uint64_t alfa = reticula_candidato((uint64_t)n, c);
+            double criterio = reticula_criterio_p2((uint64_t)n, dim, alfa);
+            if (criterio < mejor_criterio) {
+                mejor_criterio = criterio;
+                mejor_alfa = alfa;
+            }
+        }
+        reticula_iniciar(&reticula, (uint64_t)n, dim, mejor_alfa);
+        printf("  Retícula de Korobov con α = %llu (P_2 = %.3e, %d candidatos).\n",
+               (unsigned long long)mejor_alfa, mejor_criterio, candidatos);
+    }
+
+    for (int r = 0; r < replicas; r++) {
+        uint32_t digital[DIM_MAX_QMC];
+        double modulo_uno[DIM_MAX_QMC];
+        desplazamientos_replica(semilla, r, dim, digital, modulo_uno);
+
+        #pragma omp parallel for schedule(static) num_threads(num_hilos)
+        for (long k = 0; k < bloques; k++) {
+            uint64_t inicio = (uint64_t)k * TAMANO_BLOQUE_MC;
+            uint64_t fin = (k == bloques - 1) ? (uint64_t)n : inicio + TAMANO_BLOQUE_MC;
+            sumas[k] = usar_sobol
+                ? sobol_suma_bloque(&sobol, digital, inicio, fin, funcion_multidimensional, a, b)
+                : reticula_suma_bloque(&reticula, modulo_uno, inicio, fin, funcion_multidimensional, a, b);
+        }
+
+        double suma = 0.0;
+        for (long k = 0; k < bloques; k++) {
+            suma += sumas[k];
+        }
+        double estimacion = volumen * suma / n;
+        estadistica_agregar(&estimaciones, estimacion);
+        printf("  Réplica %d: %.12f\n", r, estimacion);
+    }
+
+    free(sumas);
+    *error_estandar = estadistica_error_estandar(&estimaciones);
+    return estimaciones.media;
+}
+
+/* Integral de Monte Carlo con reducción de varianza; con estratificación hay un estrato por hilo */
+double calcular_integral_reduccion_varianza_openmp(double a, double b, long n, int dim, int tecnicas,
+                                                   uint64_t semilla, int num_hilos, double *error_estandar) {
+    PlanVR plan = {funcion_multidimensional, NULL, integral_control_caja, dim, a, b, tecnicas,
+                   (tecnicas & TECNICA_ESTRATOS) ? num_hilos : 1, semilla, 0, NULL, NULL};
+    if (tecnicas & TECNICA_CONTROL) {
+        plan.control = control_multidimensional;
+    }
+    EstadisticaControl *por_estrato = malloc(plan.estratos * sizeof(EstadisticaControl));
+
+    omp_set_num_threads(num_hilos);
+    double resultado = integral_reduccion_varianza(&plan, n, 0, 1, NULL, por_estrato, error_estandar);
+
+    if (plan.estratos > 1) {
+        for (int s = 0; s < plan.estratos; s++) {
+            printf("  Estrato %d: %.0f muestras\n", s, por_estrato[s].n);
+        }
+    }
+
+    free(por_estrato);
+    return resultado;
+}
+
 int main(int argc, char *argv[]) {
-    if (argc != 5) {
-        fprintf(stderr, "Uso: %s <a> <b> <n> <numero_de_hilos>\n", argv[0]);
+    int modo_mc = argc >= 7 && argc <= 8 && strcmp(argv[5], "mc") == 0;
+    int modo_qmc = argc >= 8 && argc <= 9 && (strcmp(argv[5], "sobol") == 0 || strcmp(argv[5], "reticula") == 0);
+    int modo_vr = argc >= 8 && argc <= 9 && strcmp(argv[5], "vr") == 0;
+    int modo_adaptativo = argc >= 7 && argc <= 8 && strcmp(argv[5], "adaptativo") == 0;
+    int modo_pool = argc >= 6 && argc <= 7 && strcmp(argv[5], "pool") == 0;
+    int modo_lote = argc >= 7 && argc <= 8 && strcmp(argv[5], "lote") == 0;
+    int modo_autoajuste = argc >= 6 && argc <= 7 && strcmp(argv[5], "autoajuste") == 0;
+    int modo_reproducible = argc >= 6 && argc <= 7 && strcmp(argv[5], "reproducible") == 0;
+
+    if (argc != 5 && !modo_mc && !modo_qmc && !modo_vr && !modo_adaptativo && !modo_pool && !modo_lote
+        && !modo_autoajuste && !modo_reproducible) {
+        fprintf(stderr, "Uso: %s <a> <b> <n> <numero_de_hilos> [mc <dim> [semilla]]\n", argv[0]);
+        fprintf(stderr, "     %s <a> <b> <n> <numero_de_hilos> <sobol|reticula> <dim> <replicas> [semilla]\n", argv[0]);
+        fprintf(stderr, "     %s <a> <b> <n> <numero_de_hilos> vr <dim> <tecnicas> [semilla]\n", argv[0]);
+        fprintf(stderr, "     %s <a> <b> <n> <numero_de_hilos> adaptativo <tolerancia> [integrando]\n", argv[0]);
+        fprintf(stderr, "     %s <a> <b> <n> <numero_de_hilos> pool [grano]\n", argv[0]);
+        fprintf(stderr, "     %s <a> <b> <n> <numero_de_hilos> lote <trabajos> [por_ronda]\n", argv[0]);
+        fprintf(stderr, "     %s <a> <b> <n> <numero_de_hilos> autoajuste [tolerancia]\n", argv[0]);
+        fprintf(stderr, "     %s <a> <b> <n> <numero_de_hilos> reproducible [bloque]\n", argv[0]);
         fprintf(stderr, "Donde:\n");
         fprintf(stderr, "    <a> : Límite inferior de integración (double)\n");
         fprintf(stderr, "    <b> : Límite superior de integración (double)\n");
-        fprintf(stderr, "    <n> : Número de subintervalos (entero positivo)\n");
-        fprintf(stderr, "    <numero_de_hilos> : Número de hilos de OpenMP (entero positivo)\n");
+        fprintf(stderr, "    <n> : Número de subintervalos, o de muestras en modo mc (entero positivo)\n");
+        fprintf(stderr, "    <numero_de_hilos> : Número de hilos de OpenMP (0 = uno por núcleo físico)\n");
+        fprintf(stderr, "    mc <dim> [semilla] : Monte Carlo en dimensión dim (1 a %d)\n", DIM_MAX_MC);
+        fprintf(stderr, "    sobol|reticula <dim> <replicas> [semilla] : Cuasi-Monte Carlo en dimensión dim (1 a %d)\n", DIM_MAX_QMC);
+        fprintf(stderr, "    vr <dim> <tecnicas> [semilla] : Monte Carlo con reducción de varianza; tecnicas es una lista\n");
+        fprintf(stderr, "                                    separada por comas de estratos, antitetico y control\n");
+        fprintf(stderr, "    adaptativo <tolerancia> [integrando] : Cuadratura adaptativa desde n subintervalos;\n");
+        fprintf(stderr, "                                           integrando es seno, pico, escalon o raiz\n");
+        fprintf(stderr, "    pool [grano] : Suma de Riemann con el pool de hilos propio (robo de trabajo)\n");
+        fprintf(stderr, "    lote <trabajos> [por_ronda] : Lote de trabajos de n subintervalos, por llamada y en sesión\n");
+        fprintf(stderr, "    autoajuste [tolerancia] : Ajusta el núcleo de la suma de Riemann y guarda el perfil en %s\n",
+                ruta_perfiles());
+        fprintf(stderr, "    reproducible [bloque] : Suma idéntica bit a bit con cualquier número de hilos\n");
+        fprintf(stderr, "Variable de entorno RIEMANN_AFINIDAD: compacta, dispersa, fisicos o numa\n");
         return EXIT_FAILURE;
     }
 
@@ -64,18 +977,319 @@ int main(int argc, char *argv[]) {
     long n = atol(argv[3]);
     int num_hilos = atoi(argv[4]);
 
-    if (n <= 0 || num_hilos <= 0) {
-        fprintf(stderr, "El número de subintervalos y el número de hilos deben ser enteros positivos.\n");
+    if (n <= 0 || num_hilos < 0) {
+        fprintf(stderr, "El número de subintervalos debe ser un entero positivo y el de hilos no negativo.\n");
         return EXIT_FAILURE;
     }
 
+    /* Topología, número de hilos por defecto y colocación */
+    static Topologia topologia;
+    int politica_valida;
+    PoliticaAfinidad politica = afinidad_leer_politica(getenv("RIEMANN_AFINIDAD"), &politica_valida);
+    if (!politica_valida) {
+        fprintf(stderr, "RIEMANN_AFINIDAD debe ser compacta, dispersa, fisicos o numa.\n");
+        return EXIT_FAILURE;
+    }
+    topologia_descubrir(&topologia, 1);
+    if (num_hilos == 0) {
+        num_hilos = topologia.num_nucleos > 0 ? topologia.num_nucleos : 1;
+    }
+    PlanAfinidad plan_afinidad = {&topologia, politica, num_hilos};
+    if (politica != AFINIDAD_NINGUNA) {
+        topologia_imprimir(&topologia);
+        colocar_hilos_openmp(&plan_afinidad);
+    }
+
+    if (modo_mc) {
+        int dim = atoi(argv[6]);
+        uint64_t semilla = (argc == 8) ? strtoull(argv[7], NULL, 10) : SEMILLA_MC;
+        double error_estandar;
+
+        if (dim <= 0 || dim > DIM_MAX_MC) {
+            fprintf(stderr, "La dimensión debe estar entre 1 y %d.\n", DIM_MAX_MC);
+            return EXIT_FAILURE;
+        }
+
+        printf("Aproximando por Monte Carlo la integral de sin(x_1)···sin(x_%d) en [%.6f, %.6f]^%d con %ld muestras utilizando %d hilos.\n",
+               dim, a, b, dim, n, num_hilos);
+
+        double start_time = omp_get_wtime();
+        double resultado = calcular_integral_montecarlo_openmp(a, b, n, dim, semilla, num_hilos, &error_estandar);
+        double tiempo_ejecucion = omp_get_wtime() - start_time;
+
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Error estándar: %.3e\n", error_estandar);
+        printf("Tiempo de ejecución: %.6f segundos.\n", tiempo_ejecucion);
+        return EXIT_SUCCESS;
+    }
+
+    if (modo_adaptativo) {
+        double tolerancia = atof(argv[6]);
+        const char *nombre = (argc == 8) ? argv[7] : "seno";
+        double (*f)(double) = NULL;
+        double error_estimado;
+        long intervalos;
+        int profundidad_maxima;
+
+        if (strcmp(nombre, "seno") == 0) {
+            f = funcion;
+        } else if (strcmp(nombre, "pico") == 0) {
+            f = funcion_pico;
+        } else if (strcmp(nombre, "escalon") == 0) {
+            f = funcion_escalon;
+        } else if (strcmp(nombre, "raiz") == 0) {
+            f = funcion_raiz;
+        }
+        if (f == NULL || tolerancia <= 0.0) {
+            fprintf(stderr, "La tolerancia debe ser positiva y el integrando seno, pico, escalon o raiz.\n");
+            return EXIT_FAILURE;
+        }
+
+        printf("Aproximando de forma adaptativa la integral de %s desde %.6f hasta %.6f con tolerancia %.3e utilizando %d hilos.\n",
+               nombre, a, b, tolerancia, num_hilos);
+
+        double start_time = omp_get_wtime();
+        double resultado = calcular_integral_adaptativa_openmp(f, a, b, n, tolerancia, num_hilos, &error_estimado,
+                                                               &intervalos, &profundidad_maxima);
+        double tiempo_ejecucion = omp_get_wtime() - start_time;
+
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Error estimado: %.3e (%ld subintervalos, profundidad máxima %d).\n",
+               error_estimado, intervalos, profundidad_maxima);
+        printf("Tiempo de ejecución: %.6f segundos.\n", tiempo_ejecucion);
+        return EXIT_SUCCESS;
+    }
+
+    if (modo_pool) {
+        long grano = (argc == 7) ? atol(argv[6]) : n / (TRAMOS_POR_HILO_POOL * num_hilos);
+        if (grano <= 0) {
+            grano = 1;
+        }
+
+        printf("Aproximando la integral de sin(x) desde %.6f hasta %.6f con %ld subintervalos utilizando un pool de %d hilos (grano %ld).\n",
+               a, b, n, num_hilos, grano);
+
+        double inicio_pool = omp_get_wtime();
+        PoolHilos *pool = (politica != AFINIDAD_NINGUNA)
+            ? pool_crear_con_inicio(num_hilos, fijar_trabajador_pool, &plan_afinidad)
+            : pool_crear(num_hilos);
+        double tiempo_creacion = omp_get_wtime() - inicio_pool;
+
+        double start_time = omp_get_wtime();
+        double resultado = calcular_suma_riemann_pool(pool, a, b, n, grano);
+        double tiempo_ejecucion = omp_get_wtime() - start_time;
+
+        pool_destruir(pool);
+
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Creación del pool: %.6f segundos.\n", tiempo_creacion);
+        printf("Tiempo de ejecución: %.6f segundos.\n", tiempo_ejecucion);
+        return EXIT_SUCCESS;
+    }
+
+    if (modo_lote) {
+        long total = atol(argv[6]);
+        long por_ronda = (argc == 8) ? atol(argv[7]) : total;
+        long siestas;
+
+        if (total <= 0 || por_ronda <= 0) {
+            fprintf(stderr, "El número de trabajos y el tamaño de ronda deben ser enteros positivos.\n");
+            return EXIT_FAILURE;
+        }
+
+        TrabajoRiemann *trabajos = malloc(total * sizeof(TrabajoRiemann));
+        double *resultados = malloc(total * sizeof(double));
+        for (long k = 0; k < total; k++) {
+            trabajos[k].izquierdo = a + k * (b - a) / total;
+            trabajos[k].derecho = (k == total - 1) ? b : a + (k + 1) * (b - a) / total;
+            trabajos[k].n = n;
+        }
+
+        printf("Aproximando la integral de sin(x) desde %.6f hasta %.6f con %ld trabajos de %ld subintervalos (rondas de %ld) utilizando %d hilos.\n",
+               a, b, total, n, por_ronda, num_hilos);
+
+        /* Enfoque por llamada: una región paralela por trabajo */
+        double start_time = omp_get_wtime();
+        for (long k = 0; k < total; k++) {
+            resultados[k] = calcular_suma_riemann_openmp(trabajos[k].izquierdo, trabajos[k].derecho, n, num_hilos);
+        }
+        double tiempo_por_llamada = omp_get_wtime() - start_time;
+        double resultado_por_llamada = 0.0;
+        for (long k = 0; k < total; k++) {
+            resultado_por_llamada += resultados[k];
+        }
+
+        /* Sesión persistente */
+        start_time = omp_get_wtime();
+        calcular_lote_sesion_openmp(trabajos, total, por_ronda, num_hilos, resultados, &siestas);
+        double tiempo_ejecucion = omp_get_wtime() - start_time;
+        double resultado = 0.0;
+        for (long k = 0; k < total; k++) {
+            resultado += resultados[k];
+        }
+
+        printf("Por llamada: %.12f en %.6f segundos (%.0f trabajos/s).\n", resultado_por_llamada,
+               tiempo_por_llamada, total / tiempo_por_llamada);
+        printf("Sesión: %.0f trabajos/s, %.2fx respecto de por llamada; los hilos durmieron %ld veces.\n",
+               total / tiempo_ejecucion, tiempo_por_llamada / tiempo_ejecucion, siestas);
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Tiempo de ejecución: %.6f segundos.\n", tiempo_ejecucion);
+
+        free(trabajos);
+        free(resultados);
+        return EXIT_SUCCESS;
+    }
+
+    if (modo_reproducible) {
+        long bloque = (argc == 7) ? atol(argv[6]) : BLOQUE_REPRODUCIBLE;
+        if (bloque <= 0) {
+            fprintf(stderr, "El tamaño de bloque debe ser un entero positivo.\n");
+            return EXIT_FAILURE;
+        }
+
+        printf("Aproximando de forma reproducible la integral de sin(x) desde %.6f hasta %.6f con %ld subintervalos en bloques de %ld utilizando %d hilos.\n",
+               a, b, n, bloque, num_hilos);
+
+        /* Calentamiento del equipo de hilos y mediciones alternadas de ambas sumas */
+        double tiempos_habitual[REPETICIONES_REPRODUCIBLE], tiempos_reproducible[REPETICIONES_REPRODUCIBLE];
+        double resultado = 0.0;
+        calcular_suma_riemann_openmp(a, b, n, num_hilos);
+        for (int r = 0; r < REPETICIONES_REPRODUCIBLE; r++) {
+            double start_time = omp_get_wtime();
+            calcular_suma_riemann_openmp(a, b, n, num_hilos);
+            tiempos_habitual[r] = omp_get_wtime() - start_time;
+
+            start_time = omp_get_wtime();
+            resultado = calcular_suma_riemann_reproducible(a, b, n, bloque, num_hilos);
+            tiempos_reproducible[r] = omp_get_wtime() - start_time;
+        }
+        double tiempo_habitual = mediana_tiempos(tiempos_habitual, REPETICIONES_REPRODUCIBLE);
+        double tiempo_ejecucion = mediana_tiempos(tiempos_reproducible, REPETICIONES_REPRODUCIBLE);
+
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Resultado en hexadecimal: %a\n", resultado);
+        printf("Reducción habitual: %.6f segundos (sobrecarga del modo reproducible %+.1f %%; medianas de %d mediciones).\n",
+               tiempo_habitual, 100.0 * (tiempo_ejecucion - tiempo_habitual) / tiempo_habitual,
+               REPETICIONES_REPRODUCIBLE);
+        printf("Tiempo de ejecución: %.6f segundos.\n", tiempo_ejecucion);
+        return EXIT_SUCCESS;
+    }
+
+    if (modo_autoajuste) {
+        double tolerancia = (argc == 7) ? atof(argv[6]) : TOLERANCIA_AJUSTE;
+        char modelo[256];
+        ConfiguracionNucleo configuracion;
+        PerfilAjuste perfil = {0};
+
+        if (tolerancia <= 0.0) {
+            fprintf(stderr, "La tolerancia debe ser positiva.\n");
+            return EXIT_FAILURE;
+        }
+
+        modelo_cpu(modelo, sizeof(modelo));
+        printf("Autoajuste de la suma de Riemann de sin(x) en %s con %d hilos (tolerancia relativa %.1e).\n",
+               modelo, num_hilos, tolerancia);
+        double ns = autoajustar_nucleo(a, b, n, num_hilos, tolerancia, &configuracion);
+
+        perfil.hash_cpu = fnv1a(modelo, strlen(modelo), 14695981039346656037ULL);
+        perfil.hash_integrando = hash_integrando(funcion);
+        perfil.hilos = num_hilos;
+        snprintf(perfil.nucleo, sizeof(perfil.nucleo), "%s", NUCLEOS[configuracion.nucleo].nombre);
+        perfil.bloque = configuracion.bloque;
+        snprintf(perfil.planificacion, sizeof(perfil.planificacion), "%s", nombre_planificacion(configuracion.planificacion));
+        perfil.trozo = configuracion.trozo;
+        perfil.ns_por_evaluacion = ns;
+        printf("Perfil elegido: núcleo %s, bloque %ld, planificación %s, trozo %d (%.3f ns/evaluación).\n",
+               perfil.nucleo, perfil.bloque, perfil.planificacion, perfil.trozo, ns);
+        if (!guardar_perfil(&perfil, modelo)) {
+            fprintf(stderr, "Advertencia: no se pudo guardar el perfil en %s.\n", ruta_perfiles());
+        } else {
+            printf("Perfil guardado en %s.\n", ruta_perfiles());
+        }
+
+        double start_time = omp_get_wtime();
+        double resultado = calcular_suma_riemann_ajustada(a, b, n, num_hilos, &configuracion);
+        double tiempo_ejecucion = omp_get_wtime() - start_time;
+
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Tiempo de ejecución: %.6f segundos.\n", tiempo_ejecucion);
+        return EXIT_SUCCESS;
+    }
+
+    if (modo_vr) {
+        int dim = atoi(argv[6]);
+        int tecnicas = leer_tecnicas_vr(argv[7]);
+        uint64_t semilla = (argc == 9) ? strtoull(argv[8], NULL, 10) : SEMILLA_MC;
+        double error_estandar;
+
+        if (dim <= 0 || dim > DIM_MAX_MC || tecnicas == 0) {
+            fprintf(stderr, "La dimensión debe estar entre 1 y %d y las técnicas ser estratos, antitetico o control.\n",
+                    DIM_MAX_MC);
+            return EXIT_FAILURE;
+        }
+
+        printf("Aproximando por Monte Carlo (%s) la integral de sin(x_1)···sin(x_%d) en [%.6f, %.6f]^%d con %ld evaluaciones utilizando %d hilos.\n",
+               argv[7], dim, a, b, dim, n, num_hilos);
+
+        double start_time = omp_get_wtime();
+        double resultado = calcular_integral_reduccion_varianza_openmp(a, b, n, dim, tecnicas, semilla,
+                                                                       num_hilos, &error_estandar);
+        double tiempo_ejecucion = omp_get_wtime() - start_time;
+
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Error estándar: %.3e\n", error_estandar);
+        printf("Tiempo de ejecución: %.6f segundos.\n", tiempo_ejecucion);
+        return EXIT_SUCCESS;
+    }
+
+    if (modo_qmc) {
+        int usar_sobol = strcmp(argv[5], "sobol") == 0;
+        int dim = atoi(argv[6]);
+        int replicas = atoi(argv[7]);
+        uint64_t semilla = (argc == 9) ? strtoull(argv[8], NULL, 10) : SEMILLA_MC;
+        double error_estandar;
+
+        if (dim <= 0 || dim > DIM_MAX_QMC || replicas < 2 || (unsigned long)n > UINT32_MAX) {
+            fprintf(stderr, "La dimensión debe estar entre 1 y %d, las réplicas ser al menos 2 y n menor que 2^32.\n",
+                    DIM_MAX_QMC);
+            return EXIT_FAILURE;
+        }
+
+        printf("Aproximando por cuasi-Monte Carlo (%s) la integral de sin(x_1)···sin(x_%d) en [%.6f, %.6f]^%d con %ld puntos y %d réplicas utilizando %d hilos.\n",
+               argv[5], dim, a, b, dim, n, replicas, num_hilos);
+
+        double start_time = omp_get_wtime();
+        double resultado = calcular_integral_cuasi_montecarlo_openmp(a, b, n, dim, usar_sobol, replicas,
+                                                                     semilla, num_hilos, &error_estandar);
+        double tiempo_ejecucion = omp_get_wtime() - start_time;
+
+        printf("Resultado de la integral aproximada: %.12f\n", resultado);
+        printf("Error estándar: %.3e\n", error_estandar);
+        printf("Tiempo de ejecución: %.6f segundos.\n", tiempo_ejecucion);
+        return EXIT_SUCCESS;
+    }
+
     printf("Aproximando la integral de sin(x) desde %.6f hasta %.6f con %ld subintervalos utilizando %d hilos.\n", a, b, n, num_hilos);
 
+    /* Perfil del autoajuste para esta máquina, integrando y número de hilos, si existe */
+    char modelo[256];
+    PerfilAjuste perfil;
+    ConfiguracionNucleo configuracion;
+    modelo_cpu(modelo, sizeof(modelo));
+    int ajustado = cargar_perfil(fnv1a(modelo, strlen(modelo), 14695981039346656037ULL), hash_integrando(funcion),
+                                 num_hilos, &perfil)
+                   && configuracion_desde_perfil(&perfil, &configuracion);
+    if (ajustado) {
+        printf("Perfil de ajuste: núcleo %s, bloque %ld, planificación %s, trozo %d.\n", perfil.nucleo, perfil.bloque,
+               perfil.planificacion, perfil.trozo);
+    }
+
     /* Medición del tiempo de ejecución */
     double start_time = omp_get_wtime();
 
     /* Cálculo de la suma de Riemann */
-    double suma_total = calcular_suma_riemann_openmp(a, b, n, num_hilos);
+    double suma_total = ajustado ? calcular_suma_riemann_ajustada(a, b, n, num_hilos, &configuracion)
+                                 : calcular_suma_riemann_openmp(a, b, n, num_hilos);
 
     double end_time = omp_get_wtime();
     double tiempo_ejecucion = end_time - start_time;
@@ -0,0 +1,141 @@
+/*
+ * Archivo: perfiles_ajuste.h
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Persistencia de los perfiles del autoajuste de openmp_riemann_suma.c. Un perfil guarda la
+ * variante de núcleo, el tamaño de bloque y la planificación de OpenMP más rápidos para una
+ * máquina, un integrando y un número de hilos. La clave combina un hash FNV-1a del modelo de
+ * CPU (de /proc/cpuinfo), un hash del integrando (de los bits de sus valores en puntos fijos,
+ * así que cambia si se cambia la función) y el número de hilos.
+ *
+ * El archivo de perfiles (perfiles_riemann.txt o el de la variable RIEMANN_PERFILES) tiene una
+ * línea por clave:
+ *     <hash_cpu> <hash_integrando> <hilos> <nucleo> <bloque> <planificacion> <trozo> <ns_por_evaluacion> <modelo>
+ * Guardar un perfil reemplaza la línea de su clave y conserva las demás.
+ */
+
+#ifndef PERFILES_AJUSTE_H
+#define PERFILES_AJUSTE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARCHIVO_PERFILES "perfiles_riemann.txt"
+#define MAX_LINEA_PERFIL 512
+#define PUNTOS_HASH_INTEGRANDO 64
+
+typedef struct {
+    uint64_t hash_cpu;
+    uint64_t hash_integrando;
+    int hilos;
+    char nucleo[16];        // Nombre de la variante de núcleo (p. ej. "simple4", "kahan1", "simd8")
+    long bloque;            // Subintervalos por bloque
+    char planificacion[16]; // static, dynamic o guided
+    int trozo;              // Bloques por trozo de la planificación (0 = por defecto)
+    double ns_por_evaluacion;
+} PerfilAjuste;
+
+static inline uint64_t fnv1a(const void *datos, size_t tamano, uint64_t hash) {
+    const unsigned char *bytes = datos;
+    for (size_t i = 0; i < tamano; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* Modelo de CPU de /proc/cpuinfo ("desconocido" si no está disponible) */
+static inline void modelo_cpu(char *modelo, size_t tamano) {
+    FILE *archivo = fopen("/proc/cpuinfo", "r");
+    char linea[MAX_LINEA_PERFIL];
+    snprintf(modelo, tamano, "desconocido");
+    if (archivo == NULL) {
+        return;
+    }
+    while (fgets(linea, sizeof(linea), archivo) != NULL) {
+        char *separador = strchr(linea, ':');
+        if (strncmp(linea, "model name", 10) == 0 && separador != NULL) {
+            separador += (separador[1] == ' ') ? 2 : 1;
+            separador[strcspn(separador, "\n")] = '\0';
+            snprintf(modelo, tamano, "%s", separador);
+            break;
+        }
+    }
+    fclose(archivo);
+}
+
+static inline uint64_t hash_integrando(double (*f)(double)) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int k = 0; k < PUNTOS_HASH_INTEGRANDO; k++) {
+        double valor = f(-3.7 + 0.37 * k);
+        hash = fnv1a(&valor, sizeof(valor), hash);
+    }
+    return hash;
+}
+
+static inline const char *ruta_perfiles(void) {
+    const char *ruta = getenv("RIEMANN_PERFILES");
+    return (ruta != NULL && ruta[0] != '\0') ? ruta : ARCHIVO_PERFILES;
+}
+
+static inline int leer_linea_perfil(const char *linea, PerfilAjuste *perfil) {
+    unsigned long long hash_cpu, hash_integrando;
+    if (sscanf(linea, "%llx %llx %d %15s %ld %15s %d %lf", &hash_cpu, &hash_integrando, &perfil->hilos,
+               perfil->nucleo, &perfil->bloque, perfil->planificacion, &perfil->trozo, &perfil->ns_por_evaluacion) != 8) {
+        return 0;
+    }
+    perfil->hash_cpu = hash_cpu;
+    perfil->hash_integrando = hash_integrando;
+    return 1;
+}
+
+/* Busca el perfil de la clave dada; devuelve 0 si no existe */
+static inline int cargar_perfil(uint64_t hash_cpu, uint64_t hash_integrando, int hilos, PerfilAjuste *perfil) {
+    FILE *archivo = fopen(ruta_perfiles(), "r");
+    char linea[MAX_LINEA_PERFIL];
+    int encontrado = 0;
+    if (archivo == NULL) {
+        return 0;
+    }
+    while (!encontrado && fgets(linea, sizeof(linea), archivo) != NULL) {
+        encontrado = leer_linea_perfil(linea, perfil) && perfil->hash_cpu == hash_cpu
+                     && perfil->hash_integrando == hash_integrando && perfil->hilos == hilos;
+    }
+    fclose(archivo);
+    return encontrado;
+}
+
+/* Guarda el perfil reemplazando la línea de su clave; devuelve 0 si no se pudo escribir */
+static inline int guardar_perfil(const PerfilAjuste *perfil, const char *modelo) {
+    const char *ruta = ruta_perfiles();
+    char temporal[MAX_LINEA_PERFIL], linea[MAX_LINEA_PERFIL];
+    snprintf(temporal, sizeof(temporal), "%s.tmp", ruta);
+
+    FILE *salida = fopen(temporal, "w");
+    if (salida == NULL) {
+        return 0;
+    }
+    FILE *entrada = fopen(ruta, "r");
+    if (entrada != NULL) {
+        while (fgets(linea, sizeof(linea), entrada) != NULL) {
+            PerfilAjuste otro;
+            if (leer_linea_perfil(linea, &otro) && otro.hash_cpu == perfil->hash_cpu
+                && otro.hash_integrando == perfil->hash_integrando && otro.hilos == perfil->hilos) {
+                continue;
+            }
+            fputs(linea, salida);
+        }
+        fclose(entrada);
+    }
+    fprintf(salida, "%016llx %016llx %d %s %ld %s %d %.4f %s\n", (unsigned long long)perfil->hash_cpu,
+            (unsigned long long)perfil->hash_integrando, perfil->hilos, perfil->nucleo, perfil->bloque,
+            perfil->planificacion, perfil->trozo, perfil->ns_por_evaluacion, modelo);
+    fclose(salida);
+    return rename(temporal, ruta) == 0;
+}
+
+#endif
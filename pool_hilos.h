@@ -0,0 +1,317 @@
+/*
+ * Archivo: pool_hilos.h
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Pool de hilos persistente con robo de trabajo, alternativa a los pragmas de OpenMP en
+ * openmp_riemann_suma.c. Cada trabajador tiene una deque de Chase-Lev sin candados (versión
+ * con atómicos de C11 de Lê, Pop, Cohen y Zappa Nardelli, 2013): el dueño empuja y saca por
+ * abajo y los demás roban por arriba, así que solo hay contención cuando alguien se queda sin
+ * trabajo. El hilo que crea el pool es el trabajador 0 y participa en los cálculos.
+ *
+ * API:
+ * - pool_crear(hilos) / pool_destruir(pool)
+ * - pool_crear_con_inicio(hilos, al_iniciar, contexto): como pool_crear, pero cada trabajador
+ *   llama al_iniciar(trabajador, contexto) antes de empezar (por ejemplo, para fijar su
+ *   afinidad); el trabajador 0 lo hace en el hilo creador.
+ * - pool_paralelo_for(pool, inicio, fin, grano, cuerpo, contexto): llama cuerpo(contexto,
+ *   i0, i1) sobre tramos de como máximo 'grano' índices. El rango se divide por mitades de
+ *   forma perezosa: cada trabajador ejecuta la mitad izquierda y deja la derecha para robo.
+ *   Puede anidarse: una llamada desde dentro de un cuerpo ayuda a terminar sus propias tareas
+ *   (y las de otros) mientras espera, sin bloquear trabajadores.
+ * - pool_paralelo_reduce(...): suma los resultados de cuerpo por tramos fijos de 'grano'
+ *   índices, en orden de tramo, así que el resultado no depende del número de hilos.
+ *
+ * Los trabajadores sin trabajo giran un rato robando y luego duermen en una variable de
+ * condición hasta la siguiente llamada. Las llamadas deben hacerse desde el hilo creador o
+ * desde cuerpos ejecutados por el pool.
+ */
+
+#ifndef POOL_HILOS_H
+#define POOL_HILOS_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define CAPACIDAD_DEQUE 8192   // Potencia de dos; con la deque llena la tarea se ejecuta en el acto
+#define GIROS_ANTES_DE_DORMIR 2048
+
+typedef struct TareaPool TareaPool;
+typedef struct PoolHilos PoolHilos;
+
+/* Tramo [inicio, fin) de un pool_paralelo_for; 'pendientes' cuenta las tareas sin terminar */
+struct TareaPool {
+    void (*cuerpo)(void *contexto, long i0, long i1);
+    void *contexto;
+    long inicio;
+    long fin;
+    long grano;
+    atomic_long *pendientes;
+};
+
+typedef struct {
+    atomic_long arriba;
+    atomic_long abajo;
+    _Atomic(TareaPool *) tareas[CAPACIDAD_DEQUE];
+} __attribute__((aligned(64))) DequeChaseLev;
+
+struct PoolHilos {
+    int hilos;
+    DequeChaseLev *deques;
+    pthread_t *trabajadores;
+    atomic_int apagar;
+    atomic_int llamadas_activas;  // pool_paralelo_for en curso (los trabajadores no duermen)
+    pthread_mutex_t candado;
+    pthread_cond_t despertar;
+    void (*al_iniciar)(int trabajador, void *contexto);
+    void *contexto_inicio;
+};
+
+/* Argumento de arranque de un trabajador */
+typedef struct {
+    PoolHilos *pool;
+    int trabajador;
+} ArranquePool;
+
+/* Trabajador que ejecuta el hilo actual (-1 fuera del pool) */
+static __thread int pool_trabajador_actual = -1;
+
+static inline int deque_empujar(DequeChaseLev *d, TareaPool *tarea) {
+    long abajo = atomic_load_explicit(&d->abajo, memory_order_relaxed);
+    long arriba = atomic_load_explicit(&d->arriba, memory_order_acquire);
+    if (abajo - arriba >= CAPACIDAD_DEQUE) {
+        return 0;
+    }
+    atomic_store_explicit(&d->tareas[abajo & (CAPACIDAD_DEQUE - 1)], tarea, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->abajo, abajo + 1, memory_order_relaxed);
+    return 1;
+}
+
+static inline TareaPool *deque_sacar(DequeChaseLev *d) {
+    long abajo = atomic_load_explicit(&d->abajo, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->abajo, abajo, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long arriba = atomic_load_explicit(&d->arriba, memory_order_relaxed);
+    TareaPool *tarea = NULL;
+
+    if (arriba <= abajo) {
+        tarea = atomic_load_explicit(&d->tareas[abajo & (CAPACIDAD_DEQUE - 1)], memory_order_relaxed);
+        if (arriba == abajo) {
+            /* Último elemento: se disputa con los ladrones */
+            if (!atomic_compare_exchange_strong_explicit(&d->arriba, &arriba, arriba + 1,
+                                                         memory_order_seq_cst, memory_order_relaxed)) {
+                tarea = NULL;
+            }
+            atomic_store_explicit(&d->abajo, abajo + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&d->abajo, abajo + 1, memory_order_relaxed);
+    }
+    return tarea;
+}
+
+static inline TareaPool *deque_robar(DequeChaseLev *d) {
+    long arriba = atomic_load_explicit(&d->arriba, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long abajo = atomic_load_explicit(&d->abajo, memory_order_acquire);
+
+    if (arriba < abajo) {
+        TareaPool *tarea = atomic_load_explicit(&d->tareas[arriba & (CAPACIDAD_DEQUE - 1)], memory_order_relaxed);
+        if (atomic_compare_exchange_strong_explicit(&d->arriba, &arriba, arriba + 1,
+                                                    memory_order_seq_cst, memory_order_relaxed)) {
+            return tarea;
+        }
+    }
+    return NULL;
+}
+
+/* Ejecuta un tramo: mientras sea mayor que el grano, deja la mitad derecha en la deque propia */
+static inline void pool_ejecutar(PoolHilos *pool, TareaPool *tarea) {
+    DequeChaseLev *propia = &pool->deques[pool_trabajador_actual];
+    while (tarea->fin - tarea->inicio > tarea->grano) {
+        long medio = tarea->inicio + (tarea->fin - tarea->inicio) / 2;
+        TareaPool *derecha = malloc(sizeof(TareaPool));
+        *derecha = *tarea;
+        derecha->inicio = medio;
+        tarea->fin = medio;
+        atomic_fetch_add_explicit(tarea->pendientes, 1, memory_order_relaxed);
+        if (!deque_empujar(propia, derecha)) {
+            pool_ejecutar(pool, derecha);
+        }
+    }
+    tarea->cuerpo(tarea->contexto, tarea->inicio, tarea->fin);
+    atomic_fetch_sub_explicit(tarea->pendientes, 1, memory_order_release);
+    free(tarea);
+}
+
+/* Busca una tarea (propia o robada a partir de una víctima pseudoaleatoria) y la ejecuta */
+static inline int pool_intentar_trabajo(PoolHilos *pool, unsigned *estado_aleatorio) {
+    int yo = pool_trabajador_actual;
+    TareaPool *tarea = deque_sacar(&pool->deques[yo]);
+    if (tarea == NULL) {
+        *estado_aleatorio = *estado_aleatorio * 1103515245u + 12345u;
+        int inicio = (int)((*estado_aleatorio >> 16) % (unsigned)pool->hilos);
+        for (int k = 0; k < pool->hilos && tarea == NULL; k++) {
+            int victima = (inicio + k) % pool->hilos;
+            if (victima != yo) {
+                tarea = deque_robar(&pool->deques[victima]);
+            }
+        }
+    }
+    if (tarea == NULL) {
+        return 0;
+    }
+    pool_ejecutar(pool, tarea);
+    return 1;
+}
+
+static inline void *pool_bucle_trabajador(void *argumento) {
+    PoolHilos *pool = ((ArranquePool *)argumento)->pool;
+    pool_trabajador_actual = ((ArranquePool *)argumento)->trabajador;
+    unsigned estado_aleatorio = 2654435761u * (unsigned)(pool_trabajador_actual + 1);
+    free(argumento);
+    if (pool->al_iniciar != NULL) {
+        pool->al_iniciar(pool_trabajador_actual, pool->contexto_inicio);
+    }
+
+    while (!atomic_load_explicit(&pool->apagar, memory_order_acquire)) {
+        /* Girar robando mientras haya llamadas en curso, y luego dormir */
+        int giros = 0;
+        while (giros < GIROS_ANTES_DE_DORMIR || atomic_load_explicit(&pool->llamadas_activas, memory_order_acquire) > 0) {
+            if (pool_intentar_trabajo(pool, &estado_aleatorio)) {
+                giros = 0;
+            } else if (++giros % 64 == 0) {
+                sched_yield();
+            }
+            if (atomic_load_explicit(&pool->apagar, memory_order_acquire)) {
+                return NULL;
+            }
+        }
+        pthread_mutex_lock(&pool->candado);
+        while (atomic_load(&pool->llamadas_activas) == 0 && !atomic_load(&pool->apagar)) {
+            pthread_cond_wait(&pool->despertar, &pool->candado);
+        }
+        pthread_mutex_unlock(&pool->candado);
+    }
+    return NULL;
+}
+
+static inline PoolHilos *pool_crear_con_inicio(int hilos, void (*al_iniciar)(int, void *), void *contexto) {
+    PoolHilos *pool = malloc(sizeof(PoolHilos));
+    pool->hilos = hilos;
+    pool->al_iniciar = al_iniciar;
+    pool->contexto_inicio = contexto;
+    pool->deques = aligned_alloc(64, hilos * sizeof(DequeChaseLev));
+    pool->trabajadores = malloc(hilos * sizeof(pthread_t));
+    atomic_init(&pool->apagar, 0);
+    atomic_init(&pool->llamadas_activas, 0);
+    pthread_mutex_init(&pool->candado, NULL);
+    pthread_cond_init(&pool->despertar, NULL);
+    for (int t = 0; t < hilos; t++) {
+        atomic_init(&pool->deques[t].arriba, 0);
+        atomic_init(&pool->deques[t].abajo, 0);
+    }
+
+    pool_trabajador_actual = 0;
+    if (al_iniciar != NULL) {
+        al_iniciar(0, contexto);
+    }
+    for (int t = 1; t < hilos; t++) {
+        ArranquePool *argumento = malloc(sizeof(ArranquePool));
+        argumento->pool = pool;
+        argumento->trabajador = t;
+        pthread_create(&pool->trabajadores[t], NULL, pool_bucle_trabajador, argumento);
+    }
+    return pool;
+}
+
+static inline PoolHilos *pool_crear(int hilos) {
+    return pool_crear_con_inicio(hilos, NULL, NULL);
+}
+
+static inline void pool_destruir(PoolHilos *pool) {
+    pthread_mutex_lock(&pool->candado);
+    atomic_store(&pool->apagar, 1);
+    pthread_cond_broadcast(&pool->despertar);
+    pthread_mutex_unlock(&pool->candado);
+    for (int t = 1; t < pool->hilos; t++) {
+        pthread_join(pool->trabajadores[t], NULL);
+    }
+    pthread_mutex_destroy(&pool->candado);
+    pthread_cond_destroy(&pool->despertar);
+    free(pool->trabajadores);
+    free(pool->deques);
+    free(pool);
+    pool_trabajador_actual = -1;
+}
+
+static inline void pool_paralelo_for(PoolHilos *pool, long inicio, long fin, long grano,
+                                     void (*cuerpo)(void *, long, long), void *contexto) {
+    if (fin <= inicio) {
+        return;
+    }
+    atomic_long pendientes;
+    atomic_init(&pendientes, 1);
+    TareaPool *raiz = malloc(sizeof(TareaPool));
+    *raiz = (TareaPool){cuerpo, contexto, inicio, fin, grano > 0 ? grano : 1, &pendientes};
+    unsigned estado_aleatorio = 2654435761u * (unsigned)(pool_trabajador_actual + 1) + (unsigned)inicio;
+
+    /* Despertar a los trabajadores dormidos solo en la llamada más externa */
+    if (atomic_fetch_add(&pool->llamadas_activas, 1) == 0) {
+        pthread_mutex_lock(&pool->candado);
+        pthread_cond_broadcast(&pool->despertar);
+        pthread_mutex_unlock(&pool->candado);
+    }
+
+    pool_ejecutar(pool, raiz);
+    while (atomic_load_explicit(&pendientes, memory_order_acquire) > 0) {
+        if (!pool_intentar_trabajo(pool, &estado_aleatorio)) {
+            sched_yield();
+        }
+    }
+    atomic_fetch_sub(&pool->llamadas_activas, 1);
+}
+
+/* Contexto interno de pool_paralelo_reduce */
+typedef struct {
+    double (*cuerpo)(void *, long, long);
+    void *contexto;
+    long inicio;
+    long fin;
+    long grano;
+    double *parciales;
+} ReduccionPool;
+
+static inline void pool_cuerpo_reduccion(void *contexto, long t0, long t1) {
+    ReduccionPool *r = contexto;
+    for (long t = t0; t < t1; t++) {
+        long i0 = r->inicio + t * r->grano;
+        long i1 = i0 + r->grano < r->fin ? i0 + r->grano : r->fin;
+        r->parciales[t] = r->cuerpo(r->contexto, i0, i1);
+    }
+}
+
+static inline double pool_paralelo_reduce(PoolHilos *pool, long inicio, long fin, long grano,
+                                          double (*cuerpo)(void *, long, long), void *contexto) {
+    if (fin <= inicio) {
+        return 0.0;
+    }
+    grano = grano > 0 ? grano : 1;
+    long tramos = (fin - inicio + grano - 1) / grano;
+    ReduccionPool r = {cuerpo, contexto, inicio, fin, grano, malloc(tramos * sizeof(double))};
+
+    pool_paralelo_for(pool, 0, tramos, 1, pool_cuerpo_reduccion, &r);
+
+    double suma = 0.0;
+    for (long t = 0; t < tramos; t++) {
+        suma += r.parciales[t];
+    }
+    free(r.parciales);
+    return suma;
+}
+
+#endif
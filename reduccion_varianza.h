@@ -0,0 +1,325 @@
+/*
+ * Archivo: reduccion_varianza.h
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Técnicas de reducción de varianza del modo vr de openmp_riemann_suma.c y mpi_riemann_suma.c,
+ * combinables entre sí:
+ *
+ * - Estratificación: la primera coordenada se divide en tantos estratos como hilos o procesos.
+ *   Una pasada piloto (FRACCION_PILOTO de las muestras, repartida por igual) estima la
+ *   desviación de cada estrato y el resto se asigna por Neyman, n_s ∝ V_s·σ_s. Las muestras de
+ *   la piloto también cuentan en la estimación final.
+ * - Variables antitéticas: cada muestra es el promedio de f en u y en 1 - u, lo que cancela la
+ *   parte impar de f alrededor del centro de la caja (dos evaluaciones por muestra).
+ * - Variable de control: una función g con integral conocida sobre cualquier caja, declarada
+ *   por el programa. El estimador es media(f) - β·(media(g) - G/V), con β = cov(f, g)/var(g)
+ *   estimado de las mismas muestras; para ello las estadísticas incluyen la covarianza.
+ *
+ * Las muestras se agrupan en tareas (estrato, bloque de TAMANO_BLOQUE_MC) con su propio flujo
+ * de Philox, y las estadísticas de las tareas se combinan en orden dentro de cada estrato.
+ */
+
+#ifndef REDUCCION_VARIANZA_H
+#define REDUCCION_VARIANZA_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "montecarlo.h"
+
+#define TECNICA_ESTRATOS 1
+#define TECNICA_ANTITETICO 2
+#define TECNICA_CONTROL 4
+#define FRACCION_PILOTO 0.1
+#define MUESTRAS_PILOTO_MIN 64  // Muestras piloto mínimas por estrato
+
+/* Medias, sumas de cuadrados y co-momento de los pares (f, g) (seis doubles contiguos) */
+typedef struct {
+    double n;
+    double media_f;
+    double media_g;
+    double m2_f;
+    double m2_g;
+    double c_fg;
+} EstadisticaControl;
+
+/* Descripción del muestreo de una fase (piloto o principal) */
+typedef struct {
+    double (*integrando)(const double *, int);
+    double (*control)(const double *, int);  // Variable de control g (NULL si no se usa)
+    double (*integral_control)(const double *inferior, const double *superior, int dim);  // ∫g sobre una caja
+    int dim;
+    double a;
+    double b;
+    int tecnicas;       // Combinación de TECNICA_*
+    int estratos;
+    uint64_t semilla;
+    int fase;           // 0 piloto, 1 principal (flujos aleatorios distintos)
+    long *muestras;     // Muestras de cada estrato en esta fase
+    long *primera_tarea;  // primera_tarea[s]: índice global de la primera tarea del estrato s
+} PlanVR;
+
+static inline void estadistica_control_agregar(EstadisticaControl *e, double f, double g) {
+    e->n += 1.0;
+    double delta_f = f - e->media_f;
+    double delta_g = g - e->media_g;
+    e->media_f += delta_f / e->n;
+    e->media_g += delta_g / e->n;
+    e->m2_f += delta_f * (f - e->media_f);
+    e->m2_g += delta_g * (g - e->media_g);
+    e->c_fg += delta_f * (g - e->media_g);
+}
+
+/* Combina b en a (Chan, Golub y LeVeque, extendido al co-momento) */
+static inline void estadistica_control_combinar(EstadisticaControl *a, const EstadisticaControl *b) {
+    if (b->n == 0.0) {
+        return;
+    }
+    if (a->n == 0.0) {
+        *a = *b;
+        return;
+    }
+    double n = a->n + b->n;
+    double delta_f = b->media_f - a->media_f;
+    double delta_g = b->media_g - a->media_g;
+    double factor = a->n * b->n / n;
+    a->media_f += delta_f * b->n / n;
+    a->media_g += delta_g * b->n / n;
+    a->m2_f += b->m2_f + delta_f * delta_f * factor;
+    a->m2_g += b->m2_g + delta_g * delta_g * factor;
+    a->c_fg += b->c_fg + delta_f * delta_g * factor;
+    a->n = n;
+}
+
+/* Interpreta una lista separada por comas de estratos, antitetico y control; 0 si es inválida */
+static inline int leer_tecnicas_vr(const char *texto) {
+    char copia[64];
+    int tecnicas = 0;
+    if (strlen(texto) >= sizeof(copia)) {
+        return 0;
+    }
+    strcpy(copia, texto);
+    for (char *parte = strtok(copia, ","); parte != NULL; parte = strtok(NULL, ",")) {
+        if (strcmp(parte, "estratos") == 0) {
+            tecnicas |= TECNICA_ESTRATOS;
+        } else if (strcmp(parte, "antitetico") == 0) {
+            tecnicas |= TECNICA_ANTITETICO;
+        } else if (strcmp(parte, "control") == 0) {
+            tecnicas |= TECNICA_CONTROL;
+        } else {
+            return 0;
+        }
+    }
+    return tecnicas;
+}
+
+/* Caja del estrato s: la primera coordenada en su franja de [a, b], el resto en [a, b] */
+static inline void caja_estrato(const PlanVR *p, int s, double *inferior, double *superior) {
+    double ancho = (p->b - p->a) / p->estratos;
+    for (int d = 0; d < p->dim; d++) {
+        inferior[d] = p->a;
+        superior[d] = p->b;
+    }
+    inferior[0] = p->a + s * ancho;
+    superior[0] = (s == p->estratos - 1) ? p->b : p->a + (s + 1) * ancho;
+}
+
+/* Calcula primera_tarea a partir de las muestras por estrato; devuelve el total de tareas */
+static inline long plan_vr_tareas(PlanVR *p) {
+    p->primera_tarea[0] = 0;
+    for (int s = 0; s < p->estratos; s++) {
+        p->primera_tarea[s + 1] = p->primera_tarea[s] + (p->muestras[s] + TAMANO_BLOQUE_MC - 1) / TAMANO_BLOQUE_MC;
+    }
+    return p->primera_tarea[p->estratos];
+}
+
+/* Estadística de una tarea: bloque k del estrato s */
+static inline EstadisticaControl estadistica_tarea_vr(const PlanVR *p, int s, long k) {
+    double u[MUESTRAS_POR_TANDA * DIM_MAX_MC + 1];
+    double x[DIM_MAX_MC], reflejo[DIM_MAX_MC];
+    double inferior[DIM_MAX_MC], superior[DIM_MAX_MC];
+    int por_muestra = p->dim + (p->dim & 1);
+    long muestras = p->muestras[s] - k * TAMANO_BLOQUE_MC;
+    uint64_t bloque = (UINT64_C(1) << 62) | ((uint64_t)p->fase << 56) | ((uint64_t)s << 32) | (uint64_t)k;
+    EstadisticaControl e = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+    muestras = muestras < TAMANO_BLOQUE_MC ? muestras : TAMANO_BLOQUE_MC;
+    caja_estrato(p, s, inferior, superior);
+
+    for (long inicio = 0; inicio < muestras; inicio += MUESTRAS_POR_TANDA) {
+        int tanda = muestras - inicio < MUESTRAS_POR_TANDA ? (int)(muestras - inicio) : MUESTRAS_POR_TANDA;
+        philox_uniformes(p->semilla, bloque, (uint64_t)inicio * por_muestra, tanda * por_muestra, u);
+        for (int m = 0; m < tanda; m++) {
+            const double *v = &u[m * por_muestra];
+            for (int d = 0; d < p->dim; d++) {
+                x[d] = inferior[d] + (superior[d] - inferior[d]) * v[d];
+                reflejo[d] = inferior[d] + (superior[d] - inferior[d]) * (1.0 - v[d]);
+            }
+            double f = p->integrando(x, p->dim);
+            double g = p->control ? p->control(x, p->dim) : 0.0;
+            if (p->tecnicas & TECNICA_ANTITETICO) {
+                f = 0.5 * (f + p->integrando(reflejo, p->dim));
+                g = p->control ? 0.5 * (g + p->control(reflejo, p->dim)) : 0.0;
+            }
+            estadistica_control_agregar(&e, f, g);
+        }
+    }
+    return e;
+}
+
+/* Evalúa las tareas globales [primera, ultima) y combina cada una, en orden, en la estadística
+ * de su estrato. Con OpenMP las tareas se reparten entre los hilos. */
+static inline void evaluar_tareas_vr(const PlanVR *p, long primera, long ultima, EstadisticaControl *por_estrato) {
+    long cantidad = ultima - primera;
+    EstadisticaControl *parciales = malloc((cantidad > 0 ? cantidad : 1) * sizeof(EstadisticaControl));
+    int *estrato_tarea = malloc((cantidad > 0 ? cantidad : 1) * sizeof(int));
+
+    int s = 0;
+    for (long t = 0; t < cantidad; t++) {
+        while (p->primera_tarea[s + 1] <= primera + t) {
+            s++;
+        }
+        estrato_tarea[t] = s;
+    }
+
+#if defined(_OPENMP)
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (long t = 0; t < cantidad; t++) {
+        int e = estrato_tarea[t];
+        parciales[t] = estadistica_tarea_vr(p, e, primera + t - p->primera_tarea[e]);
+    }
+
+    for (long t = 0; t < cantidad; t++) {
+        estadistica_control_combinar(&por_estrato[estrato_tarea[t]], &parciales[t]);
+    }
+    free(parciales);
+    free(estrato_tarea);
+}
+
+/* Estimación de la integral en un estrato de volumen V cuya variable de control integra
+ * integral_control; deja en *varianza la varianza del estimador. */
+static inline double estimacion_estrato_vr(const EstadisticaControl *e, double volumen, double integral_control,
+                                           int usar_control, double *varianza) {
+    double beta = (usar_control && e->m2_g > 0.0) ? e->c_fg / e->m2_g : 0.0;
+    double residual = e->n > 1.0 ? (e->m2_f - beta * e->c_fg) / (e->n - 1.0) : INFINITY;
+    *varianza = volumen * volumen * residual / e->n;
+    return volumen * (e->media_f - beta * (e->media_g - integral_control / volumen));
+}
+
+/* Reparte 'total' muestras de forma proporcional a 'pesos' (Neyman) por restos mayores */
+static inline void asignar_neyman(const double *pesos, int estratos, long total, long *asignacion) {
+    double suma = 0.0;
+    long asignadas = 0;
+    for (int s = 0; s < estratos; s++) {
+        suma += pesos[s];
+    }
+    for (int s = 0; s < estratos; s++) {
+        double cuota = suma > 0.0 ? total * pesos[s] / suma : (double)total / estratos;
+        asignacion[s] = (long)cuota;
+        asignadas += asignacion[s];
+    }
+    while (asignadas < total) {
+        int mejor = 0;
+        double mayor_resto = -1.0;
+        for (int s = 0; s < estratos; s++) {
+            double cuota = suma > 0.0 ? total * pesos[s] / suma : (double)total / estratos;
+            if (cuota - asignacion[s] > mayor_resto) {
+                mayor_resto = cuota - asignacion[s];
+                mejor = s;
+            }
+        }
+        asignacion[mejor]++;
+        asignadas++;
+    }
+}
+
+/* Ejecuta una fase: el trabajador evalúa su tramo contiguo de tareas, 'reducir' (si no es
+ * NULL) combina en el lugar las estadísticas de todos los trabajadores y el resultado se
+ * acumula por estrato en 'acumulado'. */
+static inline void ejecutar_fase_vr(PlanVR *p, int trabajador, int trabajadores,
+                                    void (*reducir)(EstadisticaControl *, int), EstadisticaControl *acumulado) {
+    long tareas = plan_vr_tareas(p);
+    long por_trabajador = tareas / trabajadores;
+    long primera = trabajador * por_trabajador;
+    long ultima = (trabajador == trabajadores - 1) ? tareas : primera + por_trabajador;
+    EstadisticaControl *local = calloc(p->estratos, sizeof(EstadisticaControl));
+
+    evaluar_tareas_vr(p, primera, ultima, local);
+    if (reducir != NULL) {
+        reducir(local, p->estratos);
+    }
+    for (int s = 0; s < p->estratos; s++) {
+        estadistica_control_combinar(&acumulado[s], &local[s]);
+    }
+    free(local);
+}
+
+/* Integral con las técnicas del plan y 'evaluaciones' evaluaciones del integrando. Deja en
+ * por_estrato las estadísticas finales de cada estrato (piloto y fase principal). */
+static inline double integral_reduccion_varianza(PlanVR *p, long evaluaciones, int trabajador, int trabajadores,
+                                                 void (*reducir)(EstadisticaControl *, int),
+                                                 EstadisticaControl *por_estrato, double *error_estandar) {
+    int usar_control = (p->tecnicas & TECNICA_CONTROL) != 0;
+    long total = evaluaciones / ((p->tecnicas & TECNICA_ANTITETICO) ? 2 : 1);
+    double inferior[DIM_MAX_MC], superior[DIM_MAX_MC];
+    double *volumenes = malloc(p->estratos * sizeof(double));
+    double *integrales_control = malloc(p->estratos * sizeof(double));
+    double *pesos = malloc(p->estratos * sizeof(double));
+    p->muestras = malloc(p->estratos * sizeof(long));
+    p->primera_tarea = malloc((p->estratos + 1) * sizeof(long));
+    memset(por_estrato, 0, p->estratos * sizeof(EstadisticaControl));
+
+    for (int s = 0; s < p->estratos; s++) {
+        caja_estrato(p, s, inferior, superior);
+        volumenes[s] = 1.0;
+        for (int d = 0; d < p->dim; d++) {
+            volumenes[s] *= superior[d] - inferior[d];
+        }
+        integrales_control[s] = usar_control ? p->integral_control(inferior, superior, p->dim) : 0.0;
+    }
+
+    if (p->estratos > 1) {
+        /* Piloto: mismas muestras en cada estrato para estimar V_s·σ_s */
+        long piloto = (long)(FRACCION_PILOTO * total / p->estratos);
+        piloto = piloto < MUESTRAS_PILOTO_MIN ? MUESTRAS_PILOTO_MIN : piloto;
+        piloto = piloto * p->estratos > total ? total / p->estratos : piloto;
+        for (int s = 0; s < p->estratos; s++) {
+            p->muestras[s] = piloto;
+        }
+        p->fase = 0;
+        ejecutar_fase_vr(p, trabajador, trabajadores, reducir, por_estrato);
+
+        for (int s = 0; s < p->estratos; s++) {
+            double varianza;
+            estimacion_estrato_vr(&por_estrato[s], volumenes[s], integrales_control[s], usar_control, &varianza);
+            pesos[s] = isfinite(varianza) ? sqrt(varianza * por_estrato[s].n) : 1.0;
+        }
+        asignar_neyman(pesos, p->estratos, total - piloto * p->estratos, p->muestras);
+    } else {
+        p->muestras[0] = total;
+    }
+
+    p->fase = 1;
+    ejecutar_fase_vr(p, trabajador, trabajadores, reducir, por_estrato);
+
+    double resultado = 0.0, varianza_total = 0.0;
+    for (int s = 0; s < p->estratos; s++) {
+        double varianza;
+        resultado += estimacion_estrato_vr(&por_estrato[s], volumenes[s], integrales_control[s], usar_control, &varianza);
+        varianza_total += varianza;
+    }
+
+    free(volumenes);
+    free(integrales_control);
+    free(pesos);
+    free(p->muestras);
+    free(p->primera_tarea);
+    *error_estandar = sqrt(varianza_total);
+    return resultado;
+}
+
+#endif
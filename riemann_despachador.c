@@ -0,0 +1,276 @@
+/*
+ * Programa: riemann_despachador.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Punto de entrada único para la suma de Riemann que elige entre riemann_suma_secuencial,
+ * openmp_riemann_suma y mpi_riemann_suma, y el número de hilos o procesos, según cuál se
+ * predice más rápido para el n pedido. Con n pequeño manda el costo fijo (arranque del
+ * proceso, creación de hilos, mpirun y MPI_Init); con n grande, el costo por evaluación
+ * dividido entre los trabajadores.
+ *
+ * El modo calibrar ejecuta cada configuración (secuencial, OpenMP y MPI con 1, 2, 4, ...
+ * trabajadores hasta el máximo) con varios tamaños de problema, mide el tiempo de pared del
+ * proceso completo (el mejor de REPETICIONES_CALIBRACION) y ajusta por mínimos cuadrados
+ * tiempo = sobrecarga + costo_por_evaluacion · n. La tabla se guarda en un archivo de texto
+ * (calibracion_riemann.txt o el de la variable RIEMANN_CALIBRACION) y se reutiliza en las
+ * ejecuciones siguientes. Al despachar se muestra la predicción de cada configuración y se
+ * reemplaza el proceso por el programa elegido, cuya salida queda tal cual.
+ *
+ * Los ejecutables deben estar compilados en el directorio actual. La orden de lanzamiento de
+ * MPI se toma de RIEMANN_MPIRUN (por defecto "mpirun").
+ *
+ * Compilación:
+ *     gcc -O2 -o riemann_despachador riemann_despachador.c
+ *
+ * Uso:
+ *     ./riemann_despachador calibrar [max_trabajadores]
+ *     ./riemann_despachador <a> <b> <n>
+ *     Donde:
+ *         calibrar [max_trabajadores] : Mide las configuraciones hasta max_trabajadores hilos o
+ *                                       procesos (por defecto, las CPUs en línea) y guarda la tabla
+ *         <a> : Límite inferior de integración (double)
+ *         <b> : Límite superior de integración (double)
+ *         <n> : Número de subintervalos (entero positivo)
+ *
+ * Ejemplo:
+ *     ./riemann_despachador calibrar 8
+ *     ./riemann_despachador 0 3.141592653589793 100000000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_CONFIGURACIONES 64
+#define REPETICIONES_CALIBRACION 3
+#define ARCHIVO_CALIBRACION "calibracion_riemann.txt"
+
+/* Tamaños de calibración: uno dominado por la sobrecarga y dos por el cómputo */
+static const long TAMANOS_CALIBRACION[] = {1000, 4000000, 16000000};
+#define NUM_TAMANOS (sizeof(TAMANOS_CALIBRACION) / sizeof(TAMANOS_CALIBRACION[0]))
+
+typedef enum { BACKEND_SECUENCIAL, BACKEND_OPENMP, BACKEND_MPI } Backend;
+
+static const char *NOMBRES_BACKEND[] = {"secuencial", "openmp", "mpi"};
+static const char *EJECUTABLES_BACKEND[] = {"riemann_suma_secuencial", "openmp_riemann_suma", "mpi_riemann_suma"};
+
+/* Fila de la tabla de calibración */
+typedef struct {
+    Backend backend;
+    int trabajadores;
+    double sobrecarga;      // Segundos fijos por ejecución
+    double costo_evaluacion;  // Segundos por subintervalo
+} Configuracion;
+
+static const char *ruta_calibracion(void) {
+    const char *ruta = getenv("RIEMANN_CALIBRACION");
+    return (ruta != NULL && ruta[0] != '\0') ? ruta : ARCHIVO_CALIBRACION;
+}
+
+static const char *orden_mpirun(void) {
+    const char *orden = getenv("RIEMANN_MPIRUN");
+    return (orden != NULL && orden[0] != '\0') ? orden : "mpirun";
+}
+
+/* Línea de órdenes que ejecuta una configuración */
+static void construir_orden(const Configuracion *c, const char *a, const char *b, long n, char *orden, size_t tamano) {
+    switch (c->backend) {
+    case BACKEND_SECUENCIAL:
+        snprintf(orden, tamano, "./%s %s %s %ld", EJECUTABLES_BACKEND[c->backend], a, b, n);
+        break;
+    case BACKEND_OPENMP:
+        snprintf(orden, tamano, "./%s %s %s %ld %d", EJECUTABLES_BACKEND[c->backend], a, b, n, c->trabajadores);
+        break;
+    case BACKEND_MPI:
+        snprintf(orden, tamano, "%s -np %d ./%s %s %s %ld", orden_mpirun(), c->trabajadores,
+                 EJECUTABLES_BACKEND[c->backend], a, b, n);
+        break;
+    }
+}
+
+static double tiempo_actual(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* Tiempo de pared de una ejecución completa, o negativo si falla */
+static double medir_orden(const char *orden) {
+    char silenciada[1040];
+    snprintf(silenciada, sizeof(silenciada), "%s > /dev/null", orden);
+    double inicio = tiempo_actual();
+    if (system(silenciada) != 0) {
+        return -1.0;
+    }
+    return tiempo_actual() - inicio;
+}
+
+/* Configuraciones candidatas: secuencial y cada backend paralelo con 1, 2, 4, ... trabajadores */
+static int listar_configuraciones(int max_trabajadores, Configuracion *configuraciones) {
+    int cantidad = 0;
+    configuraciones[cantidad++] = (Configuracion){BACKEND_SECUENCIAL, 1, 0.0, 0.0};
+    for (int backend = BACKEND_OPENMP; backend <= BACKEND_MPI; backend++) {
+        for (int p = 1; cantidad < MAX_CONFIGURACIONES; p *= 2) {
+            int trabajadores = p < max_trabajadores ? p : max_trabajadores;
+            configuraciones[cantidad++] = (Configuracion){(Backend)backend, trabajadores, 0.0, 0.0};
+            if (trabajadores == max_trabajadores) {
+                break;
+            }
+        }
+    }
+    return cantidad;
+}
+
+static int calibrar(int max_trabajadores) {
+    Configuracion configuraciones[MAX_CONFIGURACIONES];
+    int cantidad = listar_configuraciones(max_trabajadores, configuraciones);
+    char orden[1024];
+
+    for (int i = 0; i < (int)(sizeof(EJECUTABLES_BACKEND) / sizeof(EJECUTABLES_BACKEND[0])); i++) {
+        if (access(EJECUTABLES_BACKEND[i], X_OK) != 0) {
+            fprintf(stderr, "Error: no se encontró el ejecutable %s en el directorio actual.\n", EJECUTABLES_BACKEND[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("Calibrando %d configuraciones con %zu tamaños (%d repeticiones cada una)...\n", cantidad, NUM_TAMANOS,
+           REPETICIONES_CALIBRACION);
+    for (int c = 0; c < cantidad; c++) {
+        double suma_n = 0.0, suma_t = 0.0, suma_nn = 0.0, suma_nt = 0.0;
+        for (size_t k = 0; k < NUM_TAMANOS; k++) {
+            double mejor = -1.0;
+            construir_orden(&configuraciones[c], "0", "3.141592653589793", TAMANOS_CALIBRACION[k], orden, sizeof(orden));
+            for (int r = 0; r < REPETICIONES_CALIBRACION; r++) {
+                double tiempo = medir_orden(orden);
+                if (tiempo < 0.0) {
+                    fprintf(stderr, "Error: falló la ejecución de '%s'.\n", orden);
+                    return EXIT_FAILURE;
+                }
+                if (mejor < 0.0 || tiempo < mejor) {
+                    mejor = tiempo;
+                }
+            }
+            double n = (double)TAMANOS_CALIBRACION[k];
+            suma_n += n;
+            suma_t += mejor;
+            suma_nn += n * n;
+            suma_nt += n * mejor;
+        }
+
+        /* Mínimos cuadrados de tiempo = sobrecarga + costo · n, sin valores negativos */
+        double m = (double)NUM_TAMANOS;
+        double costo = (m * suma_nt - suma_n * suma_t) / (m * suma_nn - suma_n * suma_n);
+        costo = costo > 0.0 ? costo : 0.0;
+        double sobrecarga = (suma_t - costo * suma_n) / m;
+        configuraciones[c].costo_evaluacion = costo;
+        configuraciones[c].sobrecarga = sobrecarga > 0.0 ? sobrecarga : 0.0;
+        printf("  %-10s %3d trabajadores: sobrecarga %.6f s, %.3e s por evaluación\n",
+               NOMBRES_BACKEND[configuraciones[c].backend], configuraciones[c].trabajadores,
+               configuraciones[c].sobrecarga, configuraciones[c].costo_evaluacion);
+    }
+
+    FILE *archivo = fopen(ruta_calibracion(), "w");
+    if (archivo == NULL) {
+        fprintf(stderr, "Error: no se pudo escribir %s.\n", ruta_calibracion());
+        return EXIT_FAILURE;
+    }
+    fprintf(archivo, "# backend trabajadores sobrecarga_s costo_por_evaluacion_s\n");
+    for (int c = 0; c < cantidad; c++) {
+        fprintf(archivo, "%s %d %.9e %.9e\n", NOMBRES_BACKEND[configuraciones[c].backend],
+                configuraciones[c].trabajadores, configuraciones[c].sobrecarga, configuraciones[c].costo_evaluacion);
+    }
+    fclose(archivo);
+    printf("Tabla de calibración guardada en %s.\n", ruta_calibracion());
+    return EXIT_SUCCESS;
+}
+
+/* Lee la tabla de calibración; devuelve el número de configuraciones (0 si no hay tabla) */
+static int cargar_calibracion(Configuracion *configuraciones) {
+    FILE *archivo = fopen(ruta_calibracion(), "r");
+    char linea[256], nombre[32];
+    int cantidad = 0;
+    if (archivo == NULL) {
+        return 0;
+    }
+    while (cantidad < MAX_CONFIGURACIONES && fgets(linea, sizeof(linea), archivo) != NULL) {
+        Configuracion c;
+        if (linea[0] == '#'
+            || sscanf(linea, "%31s %d %lf %lf", nombre, &c.trabajadores, &c.sobrecarga, &c.costo_evaluacion) != 4) {
+            continue;
+        }
+        for (int backend = BACKEND_SECUENCIAL; backend <= BACKEND_MPI; backend++) {
+            if (strcmp(nombre, NOMBRES_BACKEND[backend]) == 0) {
+                c.backend = (Backend)backend;
+                configuraciones[cantidad++] = c;
+            }
+        }
+    }
+    fclose(archivo);
+    return cantidad;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && argc <= 3 && strcmp(argv[1], "calibrar") == 0) {
+        int max_trabajadores = (argc == 3) ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (max_trabajadores <= 0) {
+            fprintf(stderr, "El número máximo de trabajadores debe ser un entero positivo.\n");
+            return EXIT_FAILURE;
+        }
+        return calibrar(max_trabajadores);
+    }
+
+    if (argc != 4) {
+        fprintf(stderr, "Uso: %s calibrar [max_trabajadores]\n", argv[0]);
+        fprintf(stderr, "     %s <a> <b> <n>\n", argv[0]);
+        fprintf(stderr, "Donde:\n");
+        fprintf(stderr, "    calibrar [max_trabajadores] : Mide cada backend y guarda la tabla en %s\n", ruta_calibracion());
+        fprintf(stderr, "    <a> : Límite inferior de integración (double)\n");
+        fprintf(stderr, "    <b> : Límite superior de integración (double)\n");
+        fprintf(stderr, "    <n> : Número de subintervalos (entero positivo)\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Los límites pasan a una línea de órdenes del shell: solo se aceptan números */
+    char *fin_a, *fin_b;
+    strtod(argv[1], &fin_a);
+    strtod(argv[2], &fin_b);
+    long n = atol(argv[3]);
+    if (n <= 0 || fin_a == argv[1] || *fin_a != '\0' || fin_b == argv[2] || *fin_b != '\0') {
+        fprintf(stderr, "Los límites deben ser números y el número de subintervalos un entero positivo.\n");
+        return EXIT_FAILURE;
+    }
+
+    Configuracion configuraciones[MAX_CONFIGURACIONES];
+    int cantidad = cargar_calibracion(configuraciones);
+    if (cantidad == 0) {
+        fprintf(stderr, "No hay tabla de calibración en %s; ejecute primero: %s calibrar\n", ruta_calibracion(), argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* Predicción de cada configuración y elección de la más rápida */
+    int elegida = 0;
+    printf("Predicciones para n = %ld:\n", n);
+    for (int c = 0; c < cantidad; c++) {
+        double prediccion = configuraciones[c].sobrecarga + configuraciones[c].costo_evaluacion * n;
+        double mejor = configuraciones[elegida].sobrecarga + configuraciones[elegida].costo_evaluacion * n;
+        printf("  %-10s %3d trabajadores: %.6f s\n", NOMBRES_BACKEND[configuraciones[c].backend],
+               configuraciones[c].trabajadores, prediccion);
+        if (prediccion < mejor) {
+            elegida = c;
+        }
+    }
+
+    char orden[1024];
+    construir_orden(&configuraciones[elegida], argv[1], argv[2], n, orden, sizeof(orden));
+    printf("Backend elegido: %s con %d trabajadores (%s).\n", NOMBRES_BACKEND[configuraciones[elegida].backend],
+           configuraciones[elegida].trabajadores, orden);
+    fflush(stdout);
+
+    execl("/bin/sh", "sh", "-c", orden, (char *)NULL);
+    perror("execl");
+    return EXIT_FAILURE;
+}
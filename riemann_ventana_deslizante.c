@@ -0,0 +1,283 @@
+/*
+ * Programa: riemann_ventana_deslizante.c
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Este programa calcula en línea la integral de una señal muestreada sobre una ventana
+ * deslizante de los últimos W segundos. Las muestras se leen de la entrada estándar (o de
+ * una tubería) y la integral de la ventana se actualiza con costo O(1) amortizado por muestra
+ * usando la Regla del Trapecio o la Regla de Simpson (para espaciado no uniforme).
+ *
+ * Las áreas de cada panel se guardan en un buffer circular junto con la muestra, de modo que
+ * al entrar una muestra se suma su panel y al salir de la ventana se resta. Las sumas usan
+ * acumulación compensada (Neumaier) y se recalculan desde el buffer cada vez que este da una
+ * vuelta completa, lo que acota la deriva sin perder el costo amortizado constante. El buffer
+ * solo crece (duplicándose) cuando la ventana no cabe; no hay reservas de memoria por muestra.
+ *
+ * Compilación:
+ *     gcc -O2 -o riemann_ventana_deslizante riemann_ventana_deslizante.c -lm
+ *
+ * Uso:
+ *     <fuente> | ./riemann_ventana_deslizante <W> <regla> <periodo_emision> [dt]
+ *     Donde:
+ *         <W> : Ancho de la ventana en segundos (double positivo)
+ *         <regla> : trapecio | simpson
+ *         <periodo_emision> : Segundos de señal entre dos salidas (0 = emitir en cada muestra)
+ *         [dt] : Si se indica, cada línea trae solo el valor y el tiempo es k*dt; si no,
+ *                cada línea trae "<t> <valor>"
+ *
+ *     Cada salida es una línea "<t> <integral_ventana> <muestras_en_ventana>".
+ *
+ * Ejemplo:
+ *     awk 'BEGIN{for(i=0;i<=100000;i++) printf "%.6f %.12f\n", i*1e-3, sin(i*1e-3)}' | \
+ *         ./riemann_ventana_deslizante 3.141592653589793 simpson 10
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CAPACIDAD_INICIAL 1024
+
+/* Suma compensada de Neumaier; restar un término es sumar su negativo */
+typedef struct {
+    double suma;
+    double compensacion;
+} SumaCompensada;
+
+static void suma_compensada_agregar(SumaCompensada *s, double valor) {
+    double t = s->suma + valor;
+    if (fabs(s->suma) >= fabs(valor)) {
+        s->compensacion += (s->suma - t) + valor;
+    } else {
+        s->compensacion += (valor - t) + s->suma;
+    }
+    s->suma = t;
+}
+
+static double suma_compensada_valor(const SumaCompensada *s) {
+    return s->suma + s->compensacion;
+}
+
+/* Muestra guardada en el buffer circular. El panel [k, k+1] y el par de Simpson
+ * [k, k+2] se guardan en la ranura de la muestra k en cuanto llegan sus vecinas. */
+typedef struct {
+    double t;
+    double valor;
+    double area_panel;  // Trapecio sobre [t_k, t_{k+1}]
+    double area_par;    // Simpson sobre [t_k, t_{k+2}]
+} Muestra;
+
+typedef enum { REGLA_TRAPECIO, REGLA_SIMPSON } Regla;
+
+typedef struct {
+    Muestra *buffer;
+    size_t capacidad;            // Potencia de dos
+    unsigned long long primero;  // Índice global de la muestra más antigua en la ventana
+    unsigned long long total;    // Índice global de la siguiente muestra
+    unsigned long long desalojos;
+    SumaCompensada paneles;      // Trapecios con ambos extremos en la ventana
+    SumaCompensada pares[2];     // Pares de Simpson completos, separados por paridad de inicio
+    int hay_previa;              // Última muestra desalojada, para interpolar el corte
+    double t_previa, valor_previa;
+} VentanaDeslizante;
+
+static Muestra *ranura(VentanaDeslizante *v, unsigned long long k) {
+    return &v->buffer[k & (v->capacidad - 1)];
+}
+
+/* Regla de Simpson para dos paneles de anchos h0 y h1 (no necesariamente iguales) */
+static double simpson_no_uniforme(double h0, double h1, double f0, double f1, double f2) {
+    double h = h0 + h1;
+    return h / 6.0 * ((2.0 - h1 / h0) * f0 + h * h / (h0 * h1) * f1 + (2.0 - h0 / h1) * f2);
+}
+
+/* Integral sobre el último panel [x1, x2] de la parábola que pasa por x0, x1, x2 */
+static double ultimo_panel_cuadratico(double h0, double h1, double f0, double f1, double f2) {
+    return -h1 * h1 * h1 / (6.0 * h0 * (h0 + h1)) * f0
+           + h1 * (h1 + 3.0 * h0) / (6.0 * h0) * f1
+           + h1 * (2.0 * h1 + 3.0 * h0) / (6.0 * (h0 + h1)) * f2;
+}
+
+static void ventana_crecer(VentanaDeslizante *v) {
+    size_t nueva_capacidad = v->capacidad * 2;
+    Muestra *nuevo = malloc(nueva_capacidad * sizeof(Muestra));
+    if (nuevo == NULL) {
+        fprintf(stderr, "No se pudo ampliar el buffer de la ventana.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned long long k = v->primero; k < v->total; k++) {
+        nuevo[k & (nueva_capacidad - 1)] = *ranura(v, k);
+    }
+    free(v->buffer);
+    v->buffer = nuevo;
+    v->capacidad = nueva_capacidad;
+}
+
+/* Recalcula las sumas desde el buffer para descartar la deriva acumulada */
+static void ventana_recalcular(VentanaDeslizante *v) {
+    memset(&v->paneles, 0, sizeof(v->paneles));
+    memset(v->pares, 0, sizeof(v->pares));
+    for (unsigned long long k = v->primero; k + 1 < v->total; k++) {
+        suma_compensada_agregar(&v->paneles, ranura(v, k)->area_panel);
+        if (k + 2 < v->total) {
+            suma_compensada_agregar(&v->pares[k & 1], ranura(v, k)->area_par);
+        }
+    }
+}
+
+static void ventana_agregar(VentanaDeslizante *v, double t, double valor, double ancho) {
+    if (v->total - v->primero == v->capacidad) {
+        ventana_crecer(v);
+    }
+
+    unsigned long long k = v->total;
+    Muestra *m = ranura(v, k);
+    m->t = t;
+    m->valor = valor;
+    m->area_panel = 0.0;
+    m->area_par = 0.0;
+    v->total++;
+
+    if (k >= v->primero + 1) {
+        Muestra *m1 = ranura(v, k - 1);
+        m1->area_panel = 0.5 * (t - m1->t) * (m1->valor + valor);
+        suma_compensada_agregar(&v->paneles, m1->area_panel);
+    }
+    if (k >= v->primero + 2) {
+        Muestra *m2 = ranura(v, k - 2);
+        Muestra *m1 = ranura(v, k - 1);
+        m2->area_par = simpson_no_uniforme(m1->t - m2->t, t - m1->t, m2->valor, m1->valor, valor);
+        suma_compensada_agregar(&v->pares[(k - 2) & 1], m2->area_par);
+    }
+
+    /* Desalojo de las muestras que quedaron fuera de la ventana [t - W, t] */
+    double corte = t - ancho;
+    while (v->total - v->primero > 1 && ranura(v, v->primero)->t < corte) {
+        Muestra *viejo = ranura(v, v->primero);
+        suma_compensada_agregar(&v->paneles, -viejo->area_panel);
+        if (v->primero + 2 < v->total) {
+            suma_compensada_agregar(&v->pares[v->primero & 1], -viejo->area_par);
+        }
+        v->hay_previa = 1;
+        v->t_previa = viejo->t;
+        v->valor_previa = viejo->valor;
+        v->primero++;
+
+        if (++v->desalojos % v->capacidad == 0) {
+            ventana_recalcular(v);
+        }
+    }
+}
+
+/* Integral de la ventana en O(1) a partir de las sumas mantenidas */
+static double ventana_integral(VentanaDeslizante *v, Regla regla, double ancho) {
+    unsigned long long ultimo = v->total - 1;
+    unsigned long long paneles = ultimo - v->primero;
+    double integral;
+
+    if (regla == REGLA_TRAPECIO || paneles < 2) {
+        integral = suma_compensada_valor(&v->paneles);
+    } else if (paneles % 2 == 0) {
+        integral = suma_compensada_valor(&v->pares[v->primero & 1]);
+    } else {
+        /* Número impar de paneles: Simpson hasta el penúltimo y cierre cuadrático */
+        Muestra *m0 = ranura(v, ultimo - 2);
+        Muestra *m1 = ranura(v, ultimo - 1);
+        Muestra *m2 = ranura(v, ultimo);
+        integral = suma_compensada_valor(&v->pares[v->primero & 1])
+                   + ultimo_panel_cuadratico(m1->t - m0->t, m2->t - m1->t,
+                                             m0->valor, m1->valor, m2->valor);
+    }
+
+    /* Trozo parcial entre el corte t - W y la primera muestra, interpolado linealmente */
+    Muestra *primera = ranura(v, v->primero);
+    double corte = ranura(v, ultimo)->t - ancho;
+    if (v->hay_previa && corte < primera->t && v->t_previa <= corte) {
+        double alfa = (corte - v->t_previa) / (primera->t - v->t_previa);
+        double valor_corte = v->valor_previa + alfa * (primera->valor - v->valor_previa);
+        integral += 0.5 * (primera->t - corte) * (valor_corte + primera->valor);
+    }
+
+    return integral;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4 && argc != 5) {
+        fprintf(stderr, "Uso: %s <W> <regla> <periodo_emision> [dt]\n", argv[0]);
+        fprintf(stderr, "Donde:\n");
+        fprintf(stderr, "    <W> : Ancho de la ventana en segundos (double positivo)\n");
+        fprintf(stderr, "    <regla> : trapecio | simpson\n");
+        fprintf(stderr, "    <periodo_emision> : Segundos de señal entre dos salidas (0 = cada muestra)\n");
+        fprintf(stderr, "    [dt] : Paso de tiempo si la entrada trae solo valores\n");
+        return EXIT_FAILURE;
+    }
+
+    double ancho = atof(argv[1]);
+    double periodo = atof(argv[3]);
+    double dt = (argc == 5) ? atof(argv[4]) : 0.0;
+    Regla regla;
+
+    if (strcmp(argv[2], "trapecio") == 0) {
+        regla = REGLA_TRAPECIO;
+    } else if (strcmp(argv[2], "simpson") == 0) {
+        regla = REGLA_SIMPSON;
+    } else {
+        fprintf(stderr, "La regla debe ser 'trapecio' o 'simpson'.\n");
+        return EXIT_FAILURE;
+    }
+
+    if (ancho <= 0.0 || periodo < 0.0 || (argc == 5 && dt <= 0.0)) {
+        fprintf(stderr, "W y dt deben ser positivos y el periodo de emisión no negativo.\n");
+        return EXIT_FAILURE;
+    }
+
+    VentanaDeslizante ventana;
+    memset(&ventana, 0, sizeof(ventana));
+    ventana.capacidad = CAPACIDAD_INICIAL;
+    ventana.buffer = malloc(ventana.capacidad * sizeof(Muestra));
+    if (ventana.buffer == NULL) {
+        fprintf(stderr, "No se pudo reservar el buffer de la ventana.\n");
+        return EXIT_FAILURE;
+    }
+
+    char linea[256];
+    unsigned long long leidas = 0;
+    double proxima_emision = -INFINITY;
+
+    while (fgets(linea, sizeof(linea), stdin) != NULL) {
+        char *resto;
+        double t, valor;
+
+        if (dt > 0.0) {
+            t = leidas * dt;
+            valor = strtod(linea, &resto);
+        } else {
+            t = strtod(linea, &resto);
+            valor = strtod(resto, &resto);
+        }
+        if (resto == linea) {
+            continue;  // Línea vacía o comentario
+        }
+        leidas++;
+
+        if (ventana.total > ventana.primero && t <= ranura(&ventana, ventana.total - 1)->t) {
+            fprintf(stderr, "Muestra ignorada: el tiempo %.6f no es creciente.\n", t);
+            continue;
+        }
+
+        ventana_agregar(&ventana, t, valor, ancho);
+
+        if (t >= proxima_emision) {
+            printf("%.6f %.12f %llu\n", t, ventana_integral(&ventana, regla, ancho),
+                   ventana.total - ventana.primero);
+            fflush(stdout);
+            proxima_emision = t + periodo;
+        }
+    }
+
+    free(ventana.buffer);
+    return EXIT_SUCCESS;
+}
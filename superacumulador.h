@@ -0,0 +1,131 @@
+/*
+ * Archivo: superacumulador.h
+ * Autor: Samuel Chamalé
+ * Fecha: 2024-10-23
+ *
+ * Descripción:
+ * Superacumulador al estilo de Kulisch para el modo reproducible de mpi_riemann_suma.c. Un
+ * número de punto fijo con LIMBS_SUPERACUMULADOR limbs de 32 bits (guardados en int64_t para
+ * absorber acarreos) cubre todo el rango de los double finitos, desde 2^-1074. Cada double se
+ * suma de forma exacta desplazando su mantisa a su posición, así que la suma no depende del
+ * orden ni de cómo se agrupen los sumandos: es la misma con cualquier número de procesos y
+ * cualquier árbol de reducción de MPI. Solo al final se redondea a double (al más cercano).
+ *
+ * Los limbs se normalizan (acarreo hacia arriba, cada limb en [0, 2^32) salvo el superior, que
+ * lleva el signo) cada NORMALIZAR_SUPERACUMULADOR sumas, antes de reducir y antes de convertir.
+ * Dos superacumuladores normalizados se suman limb a limb sin desbordar. No admite infinitos ni
+ * NaN.
+ */
+
+#ifndef SUPERACUMULADOR_H
+#define SUPERACUMULADOR_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LIMBS_SUPERACUMULADOR 68            // 2176 bits: rango de los double más margen de acarreo
+#define NORMALIZAR_SUPERACUMULADOR (1 << 30)  // Sumas entre normalizaciones (cada una suma < 2^32 por limb)
+#define DESPLAZAMIENTO_SUPERACUMULADOR 1074   // El bit 0 vale 2^-1074
+
+typedef struct {
+    int64_t limbs[LIMBS_SUPERACUMULADOR];  // Lo único que se comunica (tipo contiguo de int64)
+    long pendientes;                       // Sumas desde la última normalización
+} Superacumulador;
+
+static inline void superacumulador_iniciar(Superacumulador *s) {
+    memset(s->limbs, 0, sizeof(s->limbs));
+    s->pendientes = 0;
+}
+
+static inline void superacumulador_normalizar(int64_t *limbs) {
+    int64_t acarreo = 0;
+    for (int k = 0; k < LIMBS_SUPERACUMULADOR - 1; k++) {
+        int64_t valor = limbs[k] + acarreo;
+        acarreo = valor >> 32;  // Desplazamiento aritmético: redondea hacia -infinito
+        limbs[k] = valor - acarreo * ((int64_t)1 << 32);
+    }
+    limbs[LIMBS_SUPERACUMULADOR - 1] += acarreo;
+}
+
+static inline void superacumulador_sumar(Superacumulador *s, double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int exponente = (int)((bits >> 52) & 0x7ff);
+    uint64_t mantisa = bits & ((UINT64_C(1) << 52) - 1);
+    if (exponente == 0 && mantisa == 0) {
+        return;
+    }
+    if (exponente != 0) {
+        mantisa |= UINT64_C(1) << 52;
+    } else {
+        exponente = 1;  // Subnormal
+    }
+
+    /* x = ±mantisa · 2^(exponente - 1075): la mantisa empieza en el bit exponente - 1 */
+    int posicion = exponente - 1;
+    int k = posicion / 32;
+    unsigned __int128 desplazada = (unsigned __int128)mantisa << (posicion % 32);
+    int64_t partes[3] = {(int64_t)(desplazada & 0xffffffffu), (int64_t)((desplazada >> 32) & 0xffffffffu),
+                         (int64_t)(desplazada >> 64)};
+    if (bits >> 63) {
+        s->limbs[k] -= partes[0];
+        s->limbs[k + 1] -= partes[1];
+        s->limbs[k + 2] -= partes[2];
+    } else {
+        s->limbs[k] += partes[0];
+        s->limbs[k + 1] += partes[1];
+        s->limbs[k + 2] += partes[2];
+    }
+    if (++s->pendientes == NORMALIZAR_SUPERACUMULADOR) {
+        superacumulador_normalizar(s->limbs);
+        s->pendientes = 0;
+    }
+}
+
+/* Suma limb a limb de dos superacumuladores normalizados (operación de reducción) */
+static inline void superacumulador_combinar(int64_t *acumulado, const int64_t *entrada) {
+    for (int k = 0; k < LIMBS_SUPERACUMULADOR; k++) {
+        acumulado[k] += entrada[k];
+    }
+    superacumulador_normalizar(acumulado);
+}
+
+/* Redondeo al double más cercano del valor exacto: se toman los 96 bits superiores con un bit
+ * pegajoso por los limbs inferiores y se convierte el entero de 128 bits (con redondeo) */
+static inline double superacumulador_a_double(const int64_t *limbs_originales) {
+    int64_t limbs[LIMBS_SUPERACUMULADOR];
+    memcpy(limbs, limbs_originales, sizeof(limbs));
+    superacumulador_normalizar(limbs);
+
+    int negativo = limbs[LIMBS_SUPERACUMULADOR - 1] < 0;
+    if (negativo) {
+        for (int k = 0; k < LIMBS_SUPERACUMULADOR; k++) {
+            limbs[k] = -limbs[k];
+        }
+        superacumulador_normalizar(limbs);
+    }
+
+    int superior = LIMBS_SUPERACUMULADOR - 1;
+    while (superior >= 0 && limbs[superior] == 0) {
+        superior--;
+    }
+    if (superior < 0) {
+        return 0.0;
+    }
+
+    unsigned __int128 mantisa = 0;
+    for (int k = superior; k >= superior - 2; k--) {
+        mantisa = (mantisa << 32) | (uint64_t)(k >= 0 ? limbs[k] : 0);
+    }
+    for (int k = superior - 3; k >= 0; k--) {
+        if (limbs[k] != 0) {
+            mantisa |= 1;
+            break;
+        }
+    }
+    double valor = ldexp((double)mantisa, 32 * (superior - 2) - DESPLAZAMIENTO_SUPERACUMULADOR);
+    return negativo ? -valor : valor;
+}
+
+#endif